@@ -0,0 +1,88 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <stdio.h>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "splat.h"
+#include "bench.h"
+
+static bool firstResult;
+static uint32_t randomState = 2463534242u;
+
+uint64_t BenchNanoseconds() {
+  return SDL_GetPerformanceCounter() * 1000000000.0 / SDL_GetPerformanceFrequency();
+}
+
+int BenchPrepare(int width, int height, bool hardware) {
+  if (!hardware) {
+    SDL_setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+    SDL_setenv("GALLIUM_DRIVER", "llvmpipe", 0);
+  }
+
+  if (Splat_PrepareOffscreen(width, height) != 0) {
+    fprintf(stderr, "Unable to create an offscreen context: %s\n", Splat_GetError());
+    return -1;
+  }
+
+  return 0;
+}
+
+uint32_t BenchRandom() {
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return randomState;
+}
+
+void BenchBeginOutput(const char *suite) {
+  printf("{\n  \"suite\": \"%s\",\n", suite);
+#ifdef PACKAGE_VERSION
+  printf("  \"version\": \"%s\",\n", PACKAGE_VERSION);
+#endif
+  const char *renderer = (const char *) glGetString(GL_RENDERER);
+  printf("  \"renderer\": \"%s\",\n", renderer ? renderer : "unknown");
+  printf("  \"results\": [");
+  firstResult = true;
+}
+
+void BenchBeginResult(const char *name) {
+  printf("%s\n    { \"name\": \"%s\"", firstResult ? "" : ",", name);
+  firstResult = false;
+}
+
+void BenchInteger(const char *field, uint64_t value) {
+  printf(", \"%s\": %llu", field, (unsigned long long) value);
+}
+
+void BenchNumber(const char *field, double value) {
+  printf(", \"%s\": %.3f", field, value);
+}
+
+void BenchEndResult() {
+  printf(" }");
+  fflush(stdout);
+}
+
+void BenchEndOutput() {
+  printf("\n  ]\n}\n");
+}
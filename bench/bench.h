@@ -0,0 +1,54 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_BENCH_H__
+#define __SPLAT_BENCH_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Returns a monotonic time in nanoseconds */
+uint64_t BenchNanoseconds();
+
+/*
+ * Creates the offscreen context benchmarks render in.  Unless hardware
+ * is true, Mesa is asked for its llvmpipe software renderer so results
+ * are comparable between machines.
+ */
+int BenchPrepare(int width, int height, bool hardware);
+
+/* Returns an xorshift random number, seeded the same way every run */
+uint32_t BenchRandom();
+
+/*
+ * Writes results to stdout as one JSON object: a header describing the
+ * library and renderer, then an array of results, each an object of
+ * named fields.
+ */
+void BenchBeginOutput(const char *suite);
+void BenchBeginResult(const char *name);
+void BenchInteger(const char *field, uint64_t value);
+void BenchNumber(const char *field, double value);
+void BenchEndResult();
+void BenchEndOutput();
+
+#endif // __SPLAT_BENCH_H__
@@ -0,0 +1,407 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+/*
+ * Renders standard sprite workloads offscreen and reports their
+ * throughput as JSON.  Run with --help for options.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "splat.h"
+#include "bench.h"
+
+#define VIEW_WIDTH 1024
+#define VIEW_HEIGHT 768
+#define SPRITE_SIZE 32
+#define WORLD_SIZE 16384 // Width and height of the scrolling world
+#define TEXTURE_COUNT 1024 // Images in the many-texture scene
+#define UI_PANELS 64 // Clip rects in the UI scene
+#define WARMUP_FRAMES 3
+
+typedef struct Bench {
+  Splat_Canvas *canvas;
+  Splat_Layer *layers[4];
+  int layerCount;
+  Splat_Instance **instances;
+  int instanceCount;
+  Splat_Image **images;
+  int imageCount;
+  int sprites; // Sprites or primitives drawn each frame
+} Bench;
+
+typedef struct Scene {
+  const char *name;
+  int sprites;
+  int (*setup)(Bench *bench, int sprites);
+  void (*update)(Bench *bench, int frame); // Called before each frame, may be NULL
+} Scene;
+
+/* Creates a sprite-sized image with a distinct color */
+static Splat_Image *CreateSpriteImage(int width, int height, uint32_t seed) {
+  uint32_t *pixels = malloc(width * height * 4);
+  if (!pixels) {
+    return NULL;
+  }
+
+  for (int i = 0; i < width * height; i++) {
+    pixels[i] = (seed * 2654435761u) | 0xff000000u;
+  }
+
+  Splat_Image *image = Splat_CreateImageFromPixels(pixels, width, height, width * 4, SPLAT_PIXELFORMAT_RGBA32);
+  free(pixels);
+  return image;
+}
+
+static int AddImages(Bench *bench, int count, int width, int height) {
+  bench->images = malloc(count * sizeof(Splat_Image *));
+  if (!bench->images) {
+    return -1;
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (!(bench->images[i] = CreateSpriteImage(width, height, i + 1))) {
+      return -1;
+    }
+    bench->imageCount++;
+  }
+
+  return 0;
+}
+
+static int AddLayers(Bench *bench, int count) {
+  for (int i = 0; i < count; i++) {
+    if (!(bench->layers[i] = Splat_CreateLayer(bench->canvas))) {
+      return -1;
+    }
+    bench->layerCount++;
+  }
+
+  return 0;
+}
+
+/* Creates sprites spread over an area, cycling through the images and layers */
+static int AddSprites(Bench *bench, int count, int areaWidth, int areaHeight, float s2, float t2, uint32_t flags) {
+  bench->instances = malloc(count * sizeof(Splat_Instance *));
+  if (!bench->instances) {
+    return -1;
+  }
+
+  for (int i = 0; i < count; i++) {
+    Splat_Image *image = bench->images[i % bench->imageCount];
+    Splat_Layer *layer = bench->layers[i % bench->layerCount];
+    const int x = BenchRandom() % (areaWidth - SPRITE_SIZE);
+    const int y = BenchRandom() % (areaHeight - SPRITE_SIZE);
+    if (!(bench->instances[i] = Splat_CreateInstance(image, layer, x, y, 0.0f, 0.0f, s2, t2, flags))) {
+      return -1;
+    }
+    bench->instanceCount++;
+  }
+
+  bench->sprites = count;
+  return 0;
+}
+
+static int SetupStatic(Bench *bench, int sprites) {
+  if (AddImages(bench, 1, SPRITE_SIZE, SPRITE_SIZE) != 0 || AddLayers(bench, 1) != 0) {
+    return -1;
+  }
+
+  return AddSprites(bench, sprites, VIEW_WIDTH, VIEW_HEIGHT, 1.0f, 1.0f, 0);
+}
+
+static int SetupRotating(Bench *bench, int sprites) {
+  if (AddImages(bench, 1, SPRITE_SIZE, SPRITE_SIZE) != 0 || AddLayers(bench, 1) != 0) {
+    return -1;
+  }
+
+  return AddSprites(bench, sprites, VIEW_WIDTH, VIEW_HEIGHT, 1.0f, 1.0f, SPLAT_ROTATE);
+}
+
+static void UpdateRotating(Bench *bench, int frame) {
+  for (int i = 0; i < bench->instanceCount; i++) {
+    Splat_SetInstanceAngle(bench->instances[i], (float) ((frame + i) % 360));
+  }
+}
+
+static int SetupMirrored(Bench *bench, int sprites) {
+  static const uint32_t mirrors[] = { SPLAT_MIRROR_X, SPLAT_MIRROR_Y, SPLAT_MIRROR_X | SPLAT_MIRROR_Y, SPLAT_MIRROR_DIAG };
+
+  if (SetupStatic(bench, sprites) != 0) {
+    return -1;
+  }
+
+  for (int i = 0; i < bench->instanceCount; i++) {
+    Splat_SetInstanceFlags(bench->instances[i], mirrors[i % 4]);
+  }
+
+  return 0;
+}
+
+/* Panels of widgets, each widget clipped to its panel */
+static int SetupClippedUI(Bench *bench, int sprites) {
+  if (SetupStatic(bench, sprites) != 0) {
+    return -1;
+  }
+
+  const int columns = 8;
+  const int panelWidth = VIEW_WIDTH / columns;
+  const int panelHeight = VIEW_HEIGHT / (UI_PANELS / columns);
+  for (int i = 0; i < bench->instanceCount; i++) {
+    const int panel = i % UI_PANELS;
+    SDL_Rect clip = { (panel % columns) * panelWidth + 4, (panel / columns) * panelHeight + 4, panelWidth - 8, panelHeight - 8 };
+    Splat_SetInstancePosition(bench->instances[i], clip.x + BenchRandom() % panelWidth - SPRITE_SIZE / 2,
+                              clip.y + BenchRandom() % panelHeight - SPRITE_SIZE / 2);
+    Splat_SetInstanceClip(bench->instances[i], &clip);
+  }
+
+  return 0;
+}
+
+static int SetupManyTextures(Bench *bench, int sprites) {
+  if (AddImages(bench, TEXTURE_COUNT, SPRITE_SIZE, SPRITE_SIZE) != 0 || AddLayers(bench, 1) != 0) {
+    return -1;
+  }
+
+  return AddSprites(bench, sprites, VIEW_WIDTH, VIEW_HEIGHT, 1.0f, 1.0f, 0);
+}
+
+/* The same sprites as the many-texture scene, packed into one atlas */
+static int SetupSingleTexture(Bench *bench, int sprites) {
+  const int atlasSize = SPRITE_SIZE * 32;
+  if (AddImages(bench, 1, atlasSize, atlasSize) != 0 || AddLayers(bench, 1) != 0) {
+    return -1;
+  }
+
+  if (AddSprites(bench, sprites, VIEW_WIDTH, VIEW_HEIGHT, 1.0f / 32, 1.0f / 32, 0) != 0) {
+    return -1;
+  }
+
+  for (int i = 0; i < bench->instanceCount; i++) {
+    const float s = (i % TEXTURE_COUNT % 32) / 32.0f;
+    const float t = (i % TEXTURE_COUNT / 32) / 32.0f;
+    Splat_SetInstanceImage(bench->instances[i], NULL, s, t, s + 1.0f / 32, t + 1.0f / 32);
+  }
+
+  return 0;
+}
+
+/* Sprites over a world much larger than the view, most of them culled */
+static int SetupScrollingWorld(Bench *bench, int sprites) {
+  if (AddImages(bench, 16, SPRITE_SIZE, SPRITE_SIZE) != 0 || AddLayers(bench, 4) != 0) {
+    return -1;
+  }
+
+  return AddSprites(bench, sprites, WORLD_SIZE, WORLD_SIZE, 1.0f, 1.0f, SPLAT_RELATIVE);
+}
+
+static void UpdateScrollingWorld(Bench *bench, int frame) {
+  SDL_Point position = { (frame * 7) % (WORLD_SIZE - VIEW_WIDTH), (frame * 5) % (WORLD_SIZE - VIEW_HEIGHT) };
+  Splat_SetViewPosition(bench->canvas, &position);
+}
+
+static int SetupDebugFlood(Bench *bench, int sprites) {
+  bench->sprites = sprites;
+  return 0;
+}
+
+/* Debug primitives expire after one frame, so the flood is drawn again every frame */
+static void UpdateDebugFlood(Bench *bench, int frame) {
+  for (int i = 0; i < bench->sprites; i++) {
+    SDL_Color color = { BenchRandom() & 0xff, BenchRandom() & 0xff, BenchRandom() & 0xff, 255 };
+    if (i % 2) {
+      SDL_Rect rect = { BenchRandom() % VIEW_WIDTH, BenchRandom() % VIEW_HEIGHT, SPRITE_SIZE, SPRITE_SIZE };
+      Splat_DrawRect(bench->canvas, &rect, &color, 1, (i % 4) == 1 ? SPLAT_FILLED : 0, 0);
+    } else {
+      SDL_Point start = { BenchRandom() % VIEW_WIDTH, BenchRandom() % VIEW_HEIGHT };
+      SDL_Point end = { BenchRandom() % VIEW_WIDTH, BenchRandom() % VIEW_HEIGHT };
+      Splat_DrawLine(bench->canvas, &start, &end, &color, 1, 0, 0);
+    }
+  }
+}
+
+static const Scene scenes[] = {
+  { "static_10k", 10000, SetupStatic, NULL },
+  { "static_100k", 100000, SetupStatic, NULL },
+  { "static_1m", 1000000, SetupStatic, NULL },
+  { "rotating_10k", 10000, SetupRotating, UpdateRotating },
+  { "mirrored_10k", 10000, SetupMirrored, NULL },
+  { "clipped_ui_10k", 10000, SetupClippedUI, NULL },
+  { "many_textures_10k", 10000, SetupManyTextures, NULL },
+  { "single_texture_10k", 10000, SetupSingleTexture, NULL },
+  { "scrolling_world_100k", 100000, SetupScrollingWorld, UpdateScrollingWorld },
+  { "debug_flood_10k", 10000, SetupDebugFlood, UpdateDebugFlood },
+};
+
+static void Teardown(Bench *bench) {
+  // Instances are listed newest first, so destroying them in reverse is quick
+  for (int i = bench->instanceCount - 1; i >= 0; i--) {
+    Splat_DestroyInstance(bench->instances[i]);
+  }
+  for (int i = 0; i < bench->layerCount; i++) {
+    Splat_DestroyLayer(bench->layers[i]);
+  }
+  for (int i = 0; i < bench->imageCount; i++) {
+    Splat_DestroyImage(bench->images[i]);
+  }
+  if (bench->canvas) {
+    Splat_DestroyCanvas(bench->canvas);
+  }
+
+  free(bench->instances);
+  free(bench->images);
+  memset(bench, 0, sizeof(Bench));
+}
+
+static int RunScene(const Scene *scene, int maxFrames, double maxSeconds) {
+  Bench bench;
+  memset(&bench, 0, sizeof(Bench));
+
+  if (!(bench.canvas = Splat_CreateCanvas()) || scene->setup(&bench, scene->sprites) != 0) {
+    fprintf(stderr, "%s: setup failed: %s\n", scene->name, Splat_GetError());
+    Teardown(&bench);
+    return -1;
+  }
+
+  Splat_FrameStats stats;
+  uint64_t setupUploads = 0, uploads = 0, drawCalls = 0, culled = 0;
+  int frames = 0;
+  uint64_t start = 0, end = 0;
+  for (int frame = 0; frame < WARMUP_FRAMES + maxFrames; frame++) {
+    if (frame == WARMUP_FRAMES) {
+      glFinish();
+      start = BenchNanoseconds();
+    }
+
+    if (scene->update) {
+      scene->update(&bench, frame);
+    }
+
+    if (Splat_Render(bench.canvas) != 0) {
+      fprintf(stderr, "%s: render failed: %s\n", scene->name, Splat_GetError());
+      Teardown(&bench);
+      return -1;
+    }
+
+    Splat_GetFrameStats(bench.canvas, &stats);
+    if (frame < WARMUP_FRAMES) {
+      setupUploads += stats.bytesUploaded;
+      continue;
+    }
+
+    uploads += stats.bytesUploaded;
+    drawCalls += stats.drawCalls;
+    culled += stats.instancesCulled;
+    frames++;
+
+    // Stop early on slow scenes, but always measure a few frames
+    if (frames >= 3 && (BenchNanoseconds() - start) / 1e9 >= maxSeconds) {
+      break;
+    }
+  }
+  glFinish();
+  end = BenchNanoseconds();
+
+  const double seconds = (end - start) / 1e9;
+  BenchBeginResult(scene->name);
+  BenchInteger("sprites", bench.sprites);
+  BenchInteger("frames", frames);
+  BenchNumber("seconds", seconds);
+  BenchNumber("fps", frames / seconds);
+  BenchNumber("ns_per_sprite", (end - start) / (double) frames / bench.sprites);
+  BenchNumber("frame_ms_p50", stats.frameTimeP50);
+  BenchNumber("frame_ms_p95", stats.frameTimeP95);
+  BenchNumber("frame_ms_p99", stats.frameTimeP99);
+  BenchInteger("draw_calls_per_frame", drawCalls / frames);
+  BenchInteger("culled_per_frame", culled / frames);
+  BenchInteger("setup_upload_bytes", setupUploads);
+  BenchInteger("upload_bytes", uploads);
+  BenchEndResult();
+
+  Teardown(&bench);
+  return 0;
+}
+
+static void Usage(const char *program) {
+  fprintf(stderr, "Usage: %s [--frames N] [--seconds S] [--scene NAME] [--hardware] [--list]\n", program);
+  fprintf(stderr, "  --frames N    Most frames to measure per scene (default 300)\n");
+  fprintf(stderr, "  --seconds S   Time to spend measuring each scene (default 2)\n");
+  fprintf(stderr, "  --scene NAME  Only run scenes whose name contains NAME\n");
+  fprintf(stderr, "  --hardware    Use the default OpenGL driver instead of llvmpipe\n");
+  fprintf(stderr, "  --list        List the scenes and exit\n");
+}
+
+int main(int argc, char *argv[]) {
+  int maxFrames = 300;
+  double maxSeconds = 2.0;
+  const char *filter = NULL;
+  bool hardware = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      maxFrames = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      maxSeconds = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (strcmp(argv[i], "--hardware") == 0) {
+      hardware = true;
+    } else if (strcmp(argv[i], "--list") == 0) {
+      for (size_t j = 0; j < SDL_arraysize(scenes); j++) {
+        printf("%s\n", scenes[j].name);
+      }
+      return 0;
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (maxFrames < 1) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  if (BenchPrepare(VIEW_WIDTH, VIEW_HEIGHT, hardware) != 0) {
+    return 1;
+  }
+
+  // Keep at most one frame queued so each frame's time includes its GPU work
+  Splat_SetMaxFramesInFlight(1);
+
+  int result = 0;
+  BenchBeginOutput("splatbench");
+  for (size_t i = 0; i < SDL_arraysize(scenes); i++) {
+    if (!filter || strstr(scenes[i].name, filter)) {
+      if (RunScene(&scenes[i], maxFrames, maxSeconds) != 0) {
+        result = 1;
+      }
+    }
+  }
+  BenchEndOutput();
+
+  Splat_Finish();
+  return result;
+}
@@ -0,0 +1,367 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+/*
+ * Measures the cost of individual API calls against populations of
+ * live objects, reporting nanoseconds and heap allocations per call as
+ * JSON.  Allocations are counted by wrapping malloc at link time
+ * (-Wl,--wrap=malloc), with the library linked in statically so its
+ * calls are wrapped too.  Run with --help for options.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+#include "splat.h"
+#include "bench.h"
+
+#define LAYERS 16 // Layers the population is spread over
+#define BATCH 64 // Calls made between clock reads
+#define MIN_CALLS 16
+
+static uint64_t allocations = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  allocations++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  allocations++;
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  allocations++;
+  return __real_realloc(ptr, size);
+}
+
+typedef struct Fixture {
+  Splat_Canvas *canvas;
+  Splat_Image *image;
+  Splat_Layer **layers;
+  int layerCount;
+  Splat_Instance **instances; // Live instances, in creation order where it matters
+  int instanceCount;
+  int instanceCapacity;
+} Fixture;
+
+typedef struct Micro {
+  const char *name;
+  int (*setup)(Fixture *fixture, int population);
+  int (*call)(Fixture *fixture, int i);
+  int divisor; // Limits calls to population / divisor for calls that change the population, 0 if unlimited
+} Micro;
+
+static int AddLayers(Fixture *fixture, int count) {
+  fixture->layers = malloc(count * sizeof(Splat_Layer *));
+  if (!fixture->layers) {
+    return -1;
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (!(fixture->layers[i] = Splat_CreateLayer(fixture->canvas))) {
+      return -1;
+    }
+    fixture->layerCount++;
+  }
+
+  return 0;
+}
+
+static int AddInstance(Fixture *fixture, Splat_Layer *layer) {
+  if (fixture->instanceCount == fixture->instanceCapacity) {
+    const int capacity = fixture->instanceCapacity ? fixture->instanceCapacity * 2 : 1024;
+    Splat_Instance **instances = realloc(fixture->instances, capacity * sizeof(Splat_Instance *));
+    if (!instances) {
+      return -1;
+    }
+    fixture->instances = instances;
+    fixture->instanceCapacity = capacity;
+  }
+
+  Splat_Instance *instance = Splat_CreateInstance(fixture->image, layer, BenchRandom() % 1024, BenchRandom() % 768, 0.0f, 0.0f, 1.0f, 1.0f, 0);
+  if (!instance) {
+    return -1;
+  }
+
+  fixture->instances[fixture->instanceCount++] = instance;
+  return 0;
+}
+
+/* A population of instances spread over the layers */
+static int SetupInstances(Fixture *fixture, int population) {
+  if (AddLayers(fixture, LAYERS) != 0) {
+    return -1;
+  }
+
+  for (int i = 0; i < population; i++) {
+    if (AddInstance(fixture, fixture->layers[i % LAYERS]) != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/* A population of layers, each with one instance */
+static int SetupLayers(Fixture *fixture, int population) {
+  if (AddLayers(fixture, population) != 0) {
+    return -1;
+  }
+
+  for (int i = 0; i < population; i++) {
+    if (AddInstance(fixture, fixture->layers[i]) != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+/* A population of debug rects, which last until the next render */
+static int SetupRects(Fixture *fixture, int population) {
+  SDL_Color color = { 255, 255, 255, 255 };
+  for (int i = 0; i < population; i++) {
+    SDL_Rect rect = { BenchRandom() % 1024, BenchRandom() % 768, 16, 16 };
+    if (Splat_DrawRect(fixture->canvas, &rect, &color, 1, 0, 0) != 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+static int CallCreateInstance(Fixture *fixture, int i) {
+  return AddInstance(fixture, fixture->layers[i % LAYERS]);
+}
+
+/* Destroys a random live instance */
+static int CallDestroyInstance(Fixture *fixture, int i) {
+  const int index = BenchRandom() % fixture->instanceCount;
+  Splat_Instance *instance = fixture->instances[index];
+  fixture->instances[index] = fixture->instances[--fixture->instanceCount];
+  return Splat_DestroyInstance(instance);
+}
+
+/* Destroys a random live instance and creates a replacement */
+static int CallChurnInstance(Fixture *fixture, int i) {
+  const int index = BenchRandom() % fixture->instanceCount;
+  Splat_Instance *instance = fixture->instances[index];
+  fixture->instances[index] = fixture->instances[--fixture->instanceCount];
+  if (Splat_DestroyInstance(instance) != 0) {
+    return -1;
+  }
+
+  return AddInstance(fixture, fixture->layers[i % LAYERS]);
+}
+
+static int CallSetInstanceLayer(Fixture *fixture, int i) {
+  return Splat_SetInstanceLayer(fixture->instances[BenchRandom() % fixture->instanceCount], fixture->layers[i % LAYERS]);
+}
+
+static int CallMoveLayer(Fixture *fixture, int i) {
+  Splat_Layer *layer = fixture->layers[BenchRandom() % fixture->layerCount];
+  Splat_Layer *other = fixture->layers[BenchRandom() % fixture->layerCount];
+  return layer == other ? 0 : Splat_MoveLayer(layer, other);
+}
+
+static int CallSetViewPosition(Fixture *fixture, int i) {
+  SDL_Point position = { i % 4096, i % 2048 };
+  return Splat_SetViewPosition(fixture->canvas, &position);
+}
+
+static int CallSetScale(Fixture *fixture, int i) {
+  const float scale = 1.0f + (i % 8) * 0.25f;
+  return Splat_SetScale(fixture->canvas, scale, scale);
+}
+
+static int CallDrawRect(Fixture *fixture, int i) {
+  SDL_Color color = { 255, 255, 255, 255 };
+  SDL_Rect rect = { i % 1024, i % 768, 16, 16 };
+  return Splat_DrawRect(fixture->canvas, &rect, &color, 1, 0, 0);
+}
+
+static int CallDrawLine(Fixture *fixture, int i) {
+  SDL_Color color = { 255, 255, 255, 255 };
+  SDL_Point start = { i % 1024, i % 768 };
+  SDL_Point end = { (i + 100) % 1024, (i + 50) % 768 };
+  return Splat_DrawLine(fixture->canvas, &start, &end, &color, 1, 0, 0);
+}
+
+/* Creates and destroys an image while the population of instances uses another */
+static int CallCreateDestroyImage(Fixture *fixture, int i) {
+  const uint32_t pixels[16 * 16] = { 0 };
+  Splat_Image *image = Splat_CreateImageFromPixels(pixels, 16, 16, 16 * 4, SPLAT_PIXELFORMAT_RGBA32);
+  if (!image) {
+    return -1;
+  }
+
+  return Splat_DestroyImage(image);
+}
+
+static const Micro micros[] = {
+  { "create_instance", SetupInstances, CallCreateInstance, 10 },
+  { "destroy_instance", SetupInstances, CallDestroyInstance, 10 },
+  { "churn_instance", SetupInstances, CallChurnInstance, 0 },
+  { "set_instance_layer", SetupInstances, CallSetInstanceLayer, 0 },
+  { "move_layer", SetupLayers, CallMoveLayer, 0 },
+  { "set_view_position", SetupInstances, CallSetViewPosition, 0 },
+  { "set_scale", SetupInstances, CallSetScale, 0 },
+  { "draw_rect", SetupRects, CallDrawRect, 10 },
+  { "draw_line", SetupRects, CallDrawLine, 10 },
+  { "create_destroy_image", SetupInstances, CallCreateDestroyImage, 0 },
+};
+
+static const int populations[] = { 1000, 10000, 100000, 1000000 };
+
+static void Teardown(Fixture *fixture) {
+  // Instances are listed newest first and layers oldest first, so these are quick
+  for (int i = fixture->instanceCount - 1; i >= 0; i--) {
+    Splat_DestroyInstance(fixture->instances[i]);
+  }
+  for (int i = 0; i < fixture->layerCount; i++) {
+    Splat_DestroyLayer(fixture->layers[i]);
+  }
+
+  if (fixture->canvas) {
+    // Debug primitives are only released as they expire during a render
+    Splat_Render(fixture->canvas);
+    Splat_DestroyCanvas(fixture->canvas);
+  }
+
+  free(fixture->instances);
+  free(fixture->layers);
+}
+
+static int RunMicro(const Micro *micro, Splat_Image *image, int population, double maxSeconds) {
+  Fixture fixture;
+  memset(&fixture, 0, sizeof(Fixture));
+  fixture.image = image;
+
+  if (!(fixture.canvas = Splat_CreateCanvas()) || micro->setup(&fixture, population) != 0) {
+    fprintf(stderr, "%s/%d: setup failed: %s\n", micro->name, population, Splat_GetError());
+    Teardown(&fixture);
+    return -1;
+  }
+
+  const int maxCalls = micro->divisor ? SDL_max(population / micro->divisor, MIN_CALLS) : INT32_MAX;
+  int calls = 0;
+  const uint64_t startAllocations = allocations;
+  const uint64_t start = BenchNanoseconds();
+  uint64_t end = start;
+  while (calls < maxCalls && (calls < MIN_CALLS || (end - start) / 1e9 < maxSeconds)) {
+    const int batch = SDL_min(BATCH, maxCalls - calls);
+    for (int i = 0; i < batch; i++) {
+      if (micro->call(&fixture, calls + i) != 0) {
+        fprintf(stderr, "%s/%d: call failed: %s\n", micro->name, population, Splat_GetError());
+        Teardown(&fixture);
+        return -1;
+      }
+    }
+    calls += batch;
+    end = BenchNanoseconds();
+  }
+  const uint64_t callAllocations = allocations - startAllocations;
+
+  BenchBeginResult(micro->name);
+  BenchInteger("population", population);
+  BenchInteger("calls", calls);
+  BenchNumber("ns_per_call", (double) (end - start) / calls);
+  BenchNumber("allocations_per_call", (double) callAllocations / calls);
+  BenchEndResult();
+
+  Teardown(&fixture);
+  return 0;
+}
+
+static void Usage(const char *program) {
+  fprintf(stderr, "Usage: %s [--seconds S] [--max-population N] [--bench NAME] [--hardware] [--list]\n", program);
+  fprintf(stderr, "  --seconds S           Time to spend measuring each call and population (default 0.25)\n");
+  fprintf(stderr, "  --max-population N    Skip populations larger than N (default 1000000)\n");
+  fprintf(stderr, "  --bench NAME          Only run benchmarks whose name contains NAME\n");
+  fprintf(stderr, "  --hardware            Use the default OpenGL driver instead of llvmpipe\n");
+  fprintf(stderr, "  --list                List the benchmarks and exit\n");
+}
+
+int main(int argc, char *argv[]) {
+  double maxSeconds = 0.25;
+  int maxPopulation = 1000000;
+  const char *filter = NULL;
+  bool hardware = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      maxSeconds = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--max-population") == 0 && i + 1 < argc) {
+      maxPopulation = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (strcmp(argv[i], "--hardware") == 0) {
+      hardware = true;
+    } else if (strcmp(argv[i], "--list") == 0) {
+      for (size_t j = 0; j < SDL_arraysize(micros); j++) {
+        printf("%s\n", micros[j].name);
+      }
+      return 0;
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  // Images need a context, even though most calls measured don't touch OpenGL
+  if (BenchPrepare(1024, 768, hardware) != 0) {
+    return 1;
+  }
+
+  const uint32_t pixels[32 * 32] = { 0 };
+  Splat_Image *image = Splat_CreateImageFromPixels(pixels, 32, 32, 32 * 4, SPLAT_PIXELFORMAT_RGBA32);
+  if (!image) {
+    fprintf(stderr, "Unable to create an image: %s\n", Splat_GetError());
+    return 1;
+  }
+
+  int result = 0;
+  BenchBeginOutput("splatmicro");
+  for (size_t i = 0; i < SDL_arraysize(micros); i++) {
+    if (filter && !strstr(micros[i].name, filter)) {
+      continue;
+    }
+
+    for (size_t j = 0; j < SDL_arraysize(populations) && populations[j] <= maxPopulation; j++) {
+      if (RunMicro(&micros[i], image, populations[j], maxSeconds) != 0) {
+        result = 1;
+      }
+    }
+  }
+  BenchEndOutput();
+
+  Splat_DestroyImage(image);
+  Splat_Finish();
+  return result;
+}
@@ -0,0 +1,744 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+/*
+ * Replays a GL capture made with Splat_StartGLCapture() and reports how
+ * long each frame takes as JSON.  The library is only used to create
+ * the context, so a capture can be replayed against any driver or
+ * release to compare them on exactly the same commands.
+ */
+
+#define GL_GLEXT_PROTOTYPES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "splat.h"
+#include "bench.h"
+#include "glformat.h"
+
+/* Maps object names of the capturing context to names of our own */
+typedef struct NameMap {
+  GLuint *names;
+  GLuint capacity;
+} NameMap;
+
+typedef struct Uniform {
+  GLint captured;
+  GLint location;
+} Uniform;
+
+typedef struct Program {
+  GLuint captured;
+  GLuint program;
+  Uniform *uniforms;
+  int uniformCount;
+} Program;
+
+typedef struct Reader {
+  const uint8_t *data;
+  const uint8_t *end;
+  bool overrun;
+} Reader;
+
+static NameMap textures;
+static NameMap framebuffers;
+static Program *programs = NULL;
+static int programCount = 0;
+static Program *currentProgram = NULL;
+
+// Stands in for the window, which framebuffer 0 refers to in the capture
+static GLuint windowFramebuffer = 0;
+static GLuint windowTexture = 0;
+
+// Aligned copies of the client arrays of a draw
+static void *arrays[2] = { NULL, NULL };
+static uint32_t arraySizes[2] = { 0, 0 };
+
+static GLuint MapName(NameMap *map, GLuint captured) {
+  return captured < map->capacity ? map->names[captured] : 0;
+}
+
+static int SetName(NameMap *map, GLuint captured, GLuint name) {
+  if (captured >= map->capacity) {
+    GLuint capacity = map->capacity ? map->capacity : 64;
+    while (capacity <= captured) {
+      capacity *= 2;
+    }
+
+    GLuint *grown = realloc(map->names, capacity * sizeof(GLuint));
+    if (!grown) {
+      return -1;
+    }
+    memset(grown + map->capacity, 0, (capacity - map->capacity) * sizeof(GLuint));
+    map->names = grown;
+    map->capacity = capacity;
+  }
+
+  map->names[captured] = name;
+  return 0;
+}
+
+static Program *FindProgram(GLuint captured) {
+  for (int i = 0; i < programCount; i++) {
+    if (programs[i].captured == captured) {
+      return &programs[i];
+    }
+  }
+  return NULL;
+}
+
+static GLint MapUniform(GLint captured) {
+  if (currentProgram) {
+    for (int i = 0; i < currentProgram->uniformCount; i++) {
+      if (currentProgram->uniforms[i].captured == captured) {
+        return currentProgram->uniforms[i].location;
+      }
+    }
+  }
+  return -1;
+}
+
+static const void *Get(Reader *reader, uint32_t size) {
+  if (reader->overrun || (size_t) (reader->end - reader->data) < size) {
+    reader->overrun = true;
+    return NULL;
+  }
+
+  const void *data = reader->data;
+  reader->data += size;
+  return data;
+}
+
+static uint32_t Get32(Reader *reader) {
+  uint32_t value = 0;
+  const void *data = Get(reader, sizeof(value));
+  if (data) {
+    memcpy(&value, data, sizeof(value));
+  }
+  return value;
+}
+
+static GLfloat GetFloat(Reader *reader) {
+  GLfloat value = 0;
+  const void *data = Get(reader, sizeof(value));
+  if (data) {
+    memcpy(&value, data, sizeof(value));
+  }
+  return value;
+}
+
+static GLdouble GetDouble(Reader *reader) {
+  GLdouble value = 0;
+  const void *data = Get(reader, sizeof(value));
+  if (data) {
+    memcpy(&value, data, sizeof(value));
+  }
+  return value;
+}
+
+/* Gets a byte count and the bytes following it, or NULL if the count is 0 */
+static const void *GetData(Reader *reader, uint32_t *size) {
+  *size = Get32(reader);
+  return *size ? Get(reader, *size) : NULL;
+}
+
+/* Gets a string as a NUL-terminated copy, which the caller frees */
+static char *GetString(Reader *reader) {
+  uint32_t length;
+  const char *data = GetData(reader, &length);
+  char *string = malloc(length + 1);
+  if (string) {
+    memcpy(string, data ? data : "", length);
+    string[length] = '\0';
+  }
+  return string;
+}
+
+static GLuint CreateTexture(int width, int height) {
+  GLuint texture;
+  glGenTextures(1, &texture);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  return texture;
+}
+
+static GLuint CreateFramebuffer(GLuint texture) {
+  GLuint framebuffer;
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  return framebuffer;
+}
+
+/* Applies the filters and wrap modes recorded for the bound texture */
+static void LoadSampling(Reader *reader) {
+  static const GLenum parameters[] = { GL_TEXTURE_MIN_FILTER, GL_TEXTURE_MAG_FILTER, GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T };
+  for (int i = 0; i < 4; i++) {
+    glTexParameteri(GL_TEXTURE_2D, parameters[i], Get32(reader));
+  }
+}
+
+static int LoadTexture(Reader *reader) {
+  const GLuint captured = Get32(reader);
+  const GLsizei width = Get32(reader);
+  const GLsizei height = Get32(reader);
+  const GLint internalFormat = Get32(reader);
+  const GLenum format = Get32(reader);
+  const GLenum type = Get32(reader);
+
+  GLuint texture = CreateTexture(1, 1);
+  LoadSampling(reader);
+
+  uint32_t size;
+  const void *data = GetData(reader, &size);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  if (format) {
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, data);
+  } else {
+    glCompressedTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, size, data);
+  }
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  return SetName(&textures, captured, texture);
+}
+
+static int LoadFramebuffer(Reader *reader) {
+  const GLuint captured = Get32(reader);
+  const GLuint capturedTexture = Get32(reader);
+  const int width = Get32(reader);
+  const int height = Get32(reader);
+
+  // Framebuffers of canvases own their texture, whose contents are redrawn every frame
+  GLuint texture = MapName(&textures, capturedTexture);
+  if (!texture) {
+    texture = CreateTexture(width, height);
+    LoadSampling(reader);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (SetName(&textures, capturedTexture, texture) != 0) {
+      return -1;
+    }
+  }
+
+  return SetName(&framebuffers, captured, CreateFramebuffer(texture));
+}
+
+static int LoadProgram(Reader *reader) {
+  Program *grown = realloc(programs, (programCount + 1) * sizeof(Program));
+  if (!grown) {
+    return -1;
+  }
+  programs = grown;
+
+  Program *program = &programs[programCount++];
+  program->captured = Get32(reader);
+  program->program = glCreateProgram();
+  program->uniforms = NULL;
+  program->uniformCount = 0;
+
+  const int shaderCount = Get32(reader);
+  for (int i = 0; i < shaderCount && !reader->overrun; i++) {
+    const GLenum type = Get32(reader);
+    char *source = GetString(reader);
+    if (!source) {
+      return -1;
+    }
+
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, (const GLchar **) &source, NULL);
+    glCompileShader(shader);
+    glAttachShader(program->program, shader);
+    glDeleteShader(shader);
+    free(source);
+  }
+
+  GLint linked;
+  glLinkProgram(program->program);
+  glGetProgramiv(program->program, GL_LINK_STATUS, &linked);
+  if (!linked) {
+    fprintf(stderr, "Unable to link captured program %u\n", program->captured);
+    return -1;
+  }
+
+  const int uniformCount = Get32(reader);
+  if (uniformCount > 0 && !(program->uniforms = calloc(uniformCount, sizeof(Uniform)))) {
+    return -1;
+  }
+  for (int i = 0; i < uniformCount && !reader->overrun; i++) {
+    program->uniforms[i].captured = Get32(reader);
+    char *name = GetString(reader);
+    if (!name) {
+      return -1;
+    }
+    program->uniforms[i].location = glGetUniformLocation(program->program, name);
+    program->uniformCount++;
+    free(name);
+  }
+
+  return 0;
+}
+
+/* Points a client array at an aligned copy of its captured contents */
+static int SetClientArray(Reader *reader, int index) {
+  if (!Get32(reader)) {
+    return 0;
+  }
+
+  const GLint size = Get32(reader);
+  const GLenum type = Get32(reader);
+  const GLsizei stride = Get32(reader);
+  uint32_t bytes;
+  const void *data = GetData(reader, &bytes);
+  if (!data) {
+    return reader->overrun ? -1 : 0;
+  }
+
+  if (bytes > arraySizes[index]) {
+    void *grown = realloc(arrays[index], bytes);
+    if (!grown) {
+      return -1;
+    }
+    arrays[index] = grown;
+    arraySizes[index] = bytes;
+  }
+  memcpy(arrays[index], data, bytes);
+
+  if (index == 0) {
+    glVertexPointer(size, type, stride, arrays[index]);
+  } else {
+    glTexCoordPointer(size, type, stride, arrays[index]);
+  }
+  return 0;
+}
+
+/* Generates names for those the capture generated, releasing any left from an earlier loop */
+static int GenNames(Reader *reader, NameMap *map, bool framebuffer) {
+  const GLsizei count = Get32(reader);
+  for (GLsizei i = 0; i < count && !reader->overrun; i++) {
+    const GLuint captured = Get32(reader);
+    GLuint name = MapName(map, captured);
+    if (name) {
+      framebuffer ? glDeleteFramebuffers(1, &name) : glDeleteTextures(1, &name);
+    }
+
+    framebuffer ? glGenFramebuffers(1, &name) : glGenTextures(1, &name);
+    if (SetName(map, captured, name) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+static void DeleteNames(Reader *reader, NameMap *map, bool framebuffer) {
+  const GLsizei count = Get32(reader);
+  for (GLsizei i = 0; i < count && !reader->overrun; i++) {
+    const GLuint captured = Get32(reader);
+    GLuint name = MapName(map, captured);
+    if (name) {
+      framebuffer ? glDeleteFramebuffers(1, &name) : glDeleteTextures(1, &name);
+      SetName(map, captured, 0);
+    }
+  }
+}
+
+/* Executes one call record, returning -1 if it is malformed */
+static int Execute(uint8_t op, Reader *reader) {
+  switch (op) {
+    case GLOP_BIND_FRAMEBUFFER: {
+      const GLenum target = Get32(reader);
+      const GLuint captured = Get32(reader);
+      glBindFramebuffer(target, captured ? MapName(&framebuffers, captured) : windowFramebuffer);
+      break;
+    }
+    case GLOP_VIEWPORT: {
+      const GLint x = Get32(reader), y = Get32(reader);
+      const GLsizei width = Get32(reader), height = Get32(reader);
+      glViewport(x, y, width, height);
+      break;
+    }
+    case GLOP_MATRIX_MODE:
+      glMatrixMode(Get32(reader));
+      break;
+    case GLOP_LOAD_IDENTITY:
+      glLoadIdentity();
+      break;
+    case GLOP_ORTHO_2D: {
+      const GLdouble left = GetDouble(reader), right = GetDouble(reader);
+      const GLdouble bottom = GetDouble(reader), top = GetDouble(reader);
+      glOrtho(left, right, bottom, top, -1.0, 1.0); // As gluOrtho2D
+      break;
+    }
+    case GLOP_TRANSLATEF: {
+      const GLfloat x = GetFloat(reader), y = GetFloat(reader), z = GetFloat(reader);
+      glTranslatef(x, y, z);
+      break;
+    }
+    case GLOP_SCALEF: {
+      const GLfloat x = GetFloat(reader), y = GetFloat(reader), z = GetFloat(reader);
+      glScalef(x, y, z);
+      break;
+    }
+    case GLOP_ROTATEF: {
+      const GLfloat angle = GetFloat(reader);
+      const GLfloat x = GetFloat(reader), y = GetFloat(reader), z = GetFloat(reader);
+      glRotatef(angle, x, y, z);
+      break;
+    }
+    case GLOP_PUSH_MATRIX:
+      glPushMatrix();
+      break;
+    case GLOP_POP_MATRIX:
+      glPopMatrix();
+      break;
+    case GLOP_CLEAR_COLOR: {
+      const GLfloat r = GetFloat(reader), g = GetFloat(reader), b = GetFloat(reader), a = GetFloat(reader);
+      glClearColor(r, g, b, a);
+      break;
+    }
+    case GLOP_CLEAR:
+      glClear(Get32(reader));
+      break;
+    case GLOP_ENABLE:
+      glEnable(Get32(reader));
+      break;
+    case GLOP_DISABLE:
+      glDisable(Get32(reader));
+      break;
+    case GLOP_BLEND_FUNC: {
+      const GLenum sfactor = Get32(reader), dfactor = Get32(reader);
+      glBlendFunc(sfactor, dfactor);
+      break;
+    }
+    case GLOP_BLEND_FUNC_SEPARATE: {
+      const GLenum srcRGB = Get32(reader), dstRGB = Get32(reader);
+      const GLenum srcAlpha = Get32(reader), dstAlpha = Get32(reader);
+      glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+      break;
+    }
+    case GLOP_TEX_PARAMETERI: {
+      const GLenum target = Get32(reader), pname = Get32(reader);
+      const GLint param = Get32(reader);
+      glTexParameteri(target, pname, param);
+      break;
+    }
+    case GLOP_TEX_PARAMETERF: {
+      const GLenum target = Get32(reader), pname = Get32(reader);
+      const GLfloat param = GetFloat(reader);
+      glTexParameterf(target, pname, param);
+      break;
+    }
+    case GLOP_ENABLE_CLIENT_STATE:
+      glEnableClientState(Get32(reader));
+      break;
+    case GLOP_DISABLE_CLIENT_STATE:
+      glDisableClientState(Get32(reader));
+      break;
+    case GLOP_COLOR4UB: {
+      const GLubyte *color = Get(reader, 4);
+      if (color) {
+        glColor4ub(color[0], color[1], color[2], color[3]);
+      }
+      break;
+    }
+    case GLOP_SCISSOR: {
+      const GLint x = Get32(reader), y = Get32(reader);
+      const GLsizei width = Get32(reader), height = Get32(reader);
+      glScissor(x, y, width, height);
+      break;
+    }
+    case GLOP_LINE_WIDTH:
+      glLineWidth(GetFloat(reader));
+      break;
+    case GLOP_BIND_TEXTURE: {
+      const GLenum target = Get32(reader);
+      glBindTexture(target, MapName(&textures, Get32(reader)));
+      break;
+    }
+    case GLOP_DRAW_ARRAYS: {
+      const GLenum mode = Get32(reader);
+      const GLint first = Get32(reader);
+      const GLsizei count = Get32(reader);
+      if (SetClientArray(reader, 0) != 0 || SetClientArray(reader, 1) != 0) {
+        return -1;
+      }
+      glDrawArrays(mode, first, count);
+      break;
+    }
+    case GLOP_USE_PROGRAM: {
+      const GLuint captured = Get32(reader);
+      currentProgram = captured ? FindProgram(captured) : NULL;
+      glUseProgram(currentProgram ? currentProgram->program : 0);
+      break;
+    }
+    case GLOP_UNIFORM1I: {
+      const GLint location = MapUniform(Get32(reader));
+      glUniform1i(location, Get32(reader));
+      break;
+    }
+    case GLOP_UNIFORM2F: {
+      const GLint location = MapUniform(Get32(reader));
+      const GLfloat x = GetFloat(reader), y = GetFloat(reader);
+      glUniform2f(location, x, y);
+      break;
+    }
+    case GLOP_PIXEL_STOREI: {
+      const GLenum pname = Get32(reader);
+      glPixelStorei(pname, Get32(reader));
+      break;
+    }
+    case GLOP_TEX_IMAGE_2D: {
+      const GLenum target = Get32(reader);
+      const GLint level = Get32(reader), internalFormat = Get32(reader);
+      const GLsizei width = Get32(reader), height = Get32(reader);
+      const GLint border = Get32(reader);
+      const GLenum format = Get32(reader), type = Get32(reader);
+      uint32_t size;
+      const void *data = GetData(reader, &size);
+      glTexImage2D(target, level, internalFormat, width, height, border, format, type, data);
+      break;
+    }
+    case GLOP_TEX_SUB_IMAGE_2D: {
+      const GLenum target = Get32(reader);
+      const GLint level = Get32(reader), x = Get32(reader), y = Get32(reader);
+      const GLsizei width = Get32(reader), height = Get32(reader);
+      const GLenum format = Get32(reader), type = Get32(reader);
+      uint32_t size;
+      const void *data = GetData(reader, &size);
+      glTexSubImage2D(target, level, x, y, width, height, format, type, data);
+      break;
+    }
+    case GLOP_COMPRESSED_TEX_IMAGE_2D: {
+      const GLenum target = Get32(reader);
+      const GLint level = Get32(reader);
+      const GLenum internalFormat = Get32(reader);
+      const GLsizei width = Get32(reader), height = Get32(reader);
+      const GLint border = Get32(reader);
+      uint32_t size;
+      const void *data = GetData(reader, &size);
+      glCompressedTexImage2D(target, level, internalFormat, width, height, border, size, data);
+      break;
+    }
+    case GLOP_GEN_TEXTURES:
+      return GenNames(reader, &textures, false);
+    case GLOP_DELETE_TEXTURES:
+      DeleteNames(reader, &textures, false);
+      break;
+    case GLOP_GEN_FRAMEBUFFERS:
+      return GenNames(reader, &framebuffers, true);
+    case GLOP_DELETE_FRAMEBUFFERS:
+      DeleteNames(reader, &framebuffers, true);
+      break;
+    case GLOP_FRAMEBUFFER_TEXTURE_2D: {
+      const GLenum target = Get32(reader), attachment = Get32(reader), textarget = Get32(reader);
+      const GLuint texture = MapName(&textures, Get32(reader));
+      glFramebufferTexture2D(target, attachment, textarget, texture, Get32(reader));
+      break;
+    }
+    default:
+      fprintf(stderr, "Unknown record %u in capture\n", op);
+      return -1;
+  }
+
+  return reader->overrun ? -1 : 0;
+}
+
+/* Reads the next record header, leaving reader on its payload */
+static bool NextRecord(Reader *file, uint8_t *op, Reader *record) {
+  const uint8_t *opcode = Get(file, 1);
+  const uint32_t size = Get32(file);
+  const void *payload = Get(file, size);
+  if (!opcode || file->overrun) {
+    return false;
+  }
+
+  *op = *opcode;
+  record->data = payload;
+  record->end = record->data + size;
+  record->overrun = false;
+  return true;
+}
+
+static void *LoadFile(const char *path, size_t *size) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return NULL;
+  }
+
+  void *data = NULL;
+  if (fseek(file, 0, SEEK_END) == 0) {
+    const long length = ftell(file);
+    rewind(file);
+    if (length > 0 && (data = malloc(length)) && fread(data, length, 1, file) != 1) {
+      free(data);
+      data = NULL;
+    }
+    *size = length;
+  }
+
+  fclose(file);
+  return data;
+}
+
+static int CompareTimes(const void *a, const void *b) {
+  const double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+static void Usage(const char *program) {
+  fprintf(stderr, "Usage: %s [--loops N] [--hardware] CAPTURE\n", program);
+  fprintf(stderr, "  --loops N     Times to replay the captured frames (default 10)\n");
+  fprintf(stderr, "  --hardware    Use the default OpenGL driver instead of llvmpipe\n");
+}
+
+int main(int argc, char *argv[]) {
+  int loops = 10;
+  bool hardware = false;
+  const char *path = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--loops") == 0 && i + 1 < argc) {
+      loops = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--hardware") == 0) {
+      hardware = true;
+    } else if (argv[i][0] != '-' && !path) {
+      path = argv[i];
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (!path || loops < 1) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  size_t size = 0;
+  uint8_t *data = LoadFile(path, &size);
+  if (!data || size < 8 || memcmp(data, GLCAPTURE_MAGIC, 8) != 0) {
+    fprintf(stderr, "%s is not a GL capture\n", path);
+    free(data);
+    return 1;
+  }
+
+  Reader file = { data + 8, data + size, false };
+  Reader record;
+  uint8_t op;
+  if (!NextRecord(&file, &op, &record) || op != GLOP_BEGIN) {
+    fprintf(stderr, "%s does not start with a frame\n", path);
+    free(data);
+    return 1;
+  }
+  const int width = Get32(&record);
+  const int height = Get32(&record);
+
+  if (BenchPrepare(width, height, hardware) != 0) {
+    free(data);
+    return 1;
+  }
+
+  windowTexture = CreateTexture(width, height);
+  windowFramebuffer = CreateFramebuffer(windowTexture);
+
+  // Recreate the state the first frame started from
+  const uint8_t *calls = file.data;
+  int result = 0;
+  while (result == 0 && NextRecord(&file, &op, &record) && op >= GLOP_TEXTURE_STATE && op <= GLOP_PROGRAM_STATE) {
+    if (op == GLOP_TEXTURE_STATE) {
+      result = LoadTexture(&record);
+    } else if (op == GLOP_FRAMEBUFFER_STATE) {
+      result = LoadFramebuffer(&record);
+    } else {
+      result = LoadProgram(&record);
+    }
+    if (record.overrun) {
+      result = -1;
+    }
+    calls = file.data;
+  }
+
+  // Count the frames, so times can be kept without reallocating
+  int frameCount = 0;
+  file.data = calls;
+  while (NextRecord(&file, &op, &record)) {
+    frameCount += op == GLOP_FRAME_END;
+  }
+
+  double *times = frameCount ? malloc(frameCount * loops * sizeof(double)) : NULL;
+  if (result != 0 || !times) {
+    fprintf(stderr, "%s is malformed or has no complete frames\n", path);
+    free(data);
+    Splat_Finish();
+    return 1;
+  }
+
+  int frames = 0;
+  for (int loop = 0; loop < loops && result == 0; loop++) {
+    file.data = calls;
+    glFinish();
+    uint64_t start = BenchNanoseconds();
+    while (result == 0 && NextRecord(&file, &op, &record)) {
+      if (op == GLOP_FRAME_END) {
+        glFinish();
+        const uint64_t end = BenchNanoseconds();
+        times[frames++] = (end - start) / 1e6;
+        start = end;
+      } else {
+        result = Execute(op, &record);
+      }
+    }
+  }
+
+  if (result != 0) {
+    fprintf(stderr, "%s is malformed\n", path);
+  } else {
+    double total = 0;
+    for (int i = 0; i < frames; i++) {
+      total += times[i];
+    }
+    qsort(times, frames, sizeof(double), CompareTimes);
+
+    BenchBeginOutput("splatreplay");
+    BenchBeginResult(path);
+    BenchInteger("frames", frameCount);
+    BenchInteger("loops", loops);
+    BenchNumber("frame_ms_mean", total / frames);
+    BenchNumber("frame_ms_p50", times[frames * 50 / 100]);
+    BenchNumber("frame_ms_p95", times[frames * 95 / 100]);
+    BenchNumber("frame_ms_p99", times[frames * 99 / 100]);
+    BenchNumber("frame_ms_max", times[frames - 1]);
+    BenchEndResult();
+    BenchEndOutput();
+  }
+
+  free(times);
+  free(data);
+  Splat_Finish();
+  return result == 0 ? 0 : 1;
+}
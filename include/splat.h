@@ -26,6 +26,7 @@
  * Main include header for the Splat C API
  */
 
+#include <stddef.h>
 #include <stdint.h>
 #include <SDL2/begin_code.h>
 typedef struct SDL_Window SDL_Window;
@@ -37,6 +38,7 @@ typedef struct Splat_Image Splat_Image;
 typedef struct Splat_Layer Splat_Layer;
 typedef struct Splat_Instance Splat_Instance;
 typedef struct Splat_Canvas Splat_Canvas;
+typedef struct Splat_Animation Splat_Animation;
 typedef struct Splat_Shader Splat_Shader;
 typedef struct Splat_Program Splat_Program;
 
@@ -50,27 +52,194 @@ typedef enum {
   SPLAT_FILLED = 0x0020, // Only applies to debug rects
 } Splat_Flags;
 
+typedef enum {
+  SPLAT_IMAGE_COMPRESS = 0x0001, // Compress the texture if supported, trading quality for video memory
+  SPLAT_IMAGE_LOSSLESS = 0x0002, // Never compress the texture, overrides SPLAT_IMAGE_COMPRESS
+  SPLAT_IMAGE_DEDUPLICATE = 0x0004, // Share the texture of another deduplicated image with identical pixels
+} Splat_ImageFlags;
+
+typedef enum {
+  SPLAT_PIXELFORMAT_RGBA32 = 0, // Bytes R, G, B, A
+  SPLAT_PIXELFORMAT_BGRA32, // Bytes B, G, R, A
+  SPLAT_PIXELFORMAT_ARGB32, // Bytes A, R, G, B
+  SPLAT_PIXELFORMAT_ABGR32, // Bytes A, B, G, R
+  SPLAT_PIXELFORMAT_RGB24, // Bytes R, G, B
+  SPLAT_PIXELFORMAT_BGR24, // Bytes B, G, R
+  SPLAT_PIXELFORMAT_RGB565, // Native endian 16-bit, red in the high bits
+  SPLAT_PIXELFORMAT_RGBA4444, // Native endian 16-bit, red in the high bits
+  SPLAT_PIXELFORMAT_RGBA5551, // Native endian 16-bit, red in the high bits
+  SPLAT_PIXELFORMAT_A8, // Alpha only, color comes from the instance
+  SPLAT_PIXELFORMAT_L8, // Luminance only
+} Splat_PixelFormat;
+
+typedef enum {
+  SPLAT_PRESENT_VSYNC = 0, // Wait for vertical blank, the default
+  SPLAT_PRESENT_ADAPTIVE, // Wait for vertical blank unless the frame is late, falling back to vsync
+  SPLAT_PRESENT_IMMEDIATE, // Present as soon as the frame is done, which may tear
+} Splat_PresentMode;
+
 typedef enum {
   SPLAT_VERTEX_SHADER = 0,
   SPLAT_FRAGMENT_SHADER,
   SPLAT_GEOMETRY_SHADER,
 } Splat_ShaderType;
 
+typedef enum {
+  SPLAT_MEMORY_IMAGE = 0, // Images, their textures' bookkeeping, retained pixels and animations
+  SPLAT_MEMORY_LAYER,
+  SPLAT_MEMORY_INSTANCE,
+  SPLAT_MEMORY_CANVAS, // Canvases and their capture and program lists
+  SPLAT_MEMORY_RECT, // Debug rects
+  SPLAT_MEMORY_LINE, // Debug lines
+  SPLAT_MEMORY_OTHER, // Shaders, programs, timers and scratch buffers
+  SPLAT_MEMORY_TYPES
+} Splat_MemoryType;
+
+/**
+ * One frame of an animation: the bounds of the subimage to show and
+ * how long to show it.
+ */
+typedef struct Splat_AnimationFrame {
+  float s1;
+  float t1;
+  float s2;
+  float t2;
+  uint32_t duration; // Milliseconds
+} Splat_AnimationFrame;
+
+/**
+ * Texture memory statistics, as returned by Splat_GetTextureStats().
+ */
+typedef struct Splat_TextureStats {
+  uint64_t budget; // Texture budget in bytes, 0 if unlimited
+  uint64_t residentBytes; // Bytes of textures currently in video memory
+  uint64_t evictedBytes; // Bytes of textures currently evicted
+  uint32_t residentTextures; // Number of textures currently in video memory
+  uint32_t evictedTextures; // Number of textures currently evicted
+  uint32_t evictions; // Total number of evictions since Splat_Prepare
+  uint32_t reloads; // Total number of evicted textures uploaded again
+  uint32_t sharedImages; // Number of images sharing another image's texture
+  uint64_t savedBytes; // Video memory saved by sharing textures
+} Splat_TextureStats;
+
+/**
+ * Memory statistics, as returned by Splat_GetMemoryStats().
+ */
+typedef struct Splat_MemoryStats {
+  uint64_t cpuBytes; // Bytes held from the allocator, including pooled slots not in use
+  uint64_t gpuBytes; // Estimated bytes of textures and buffers in video memory
+  uint64_t bytes[SPLAT_MEMORY_TYPES]; // Live bytes per Splat_MemoryType
+  uint32_t objects[SPLAT_MEMORY_TYPES]; // Live objects per Splat_MemoryType, 0 for SPLAT_MEMORY_OTHER
+} Splat_MemoryStats;
+
+/**
+ * Statistics of the last render of a canvas, as returned by
+ * Splat_GetFrameStats().  Times are in milliseconds.
+ */
+typedef struct Splat_FrameStats {
+  uint32_t instancesVisited; // Instances considered for drawing
+  uint32_t instancesCulled; // Instances skipped as outside the view
+  uint32_t instancesDrawn;
+  uint32_t drawCalls;
+  uint32_t textureBinds;
+  uint32_t stateChanges; // Color, scissor, blend and program changes
+  uint64_t bytesUploaded; // Texture data uploaded for or since the previous render
+  float layerTime; // CPU time spent drawing layers
+  float debugTime; // CPU time spent drawing debug rects and lines
+  float blitTime; // CPU time spent drawing the canvas into its window
+  float swapTime; // CPU time spent presenting the frame
+  float debugGpuTime; // GPU time of the debug pass, see Splat_SetGpuProfiling()
+  float blitGpuTime; // GPU time of the blit, see Splat_SetGpuProfiling()
+  float frameTime; // Time between the last two frames
+  float frameTimeP50; // Percentiles of recent frame times
+  float frameTimeP95;
+  float frameTimeP99;
+  uint32_t frameCount; // Number of recent frame times the percentiles cover
+} Splat_FrameStats;
+
+/**
+ * Callback used to restore an evicted image that has no retained copy
+ * of its pixels.  Returns a surface with the image's contents, which
+ * Splat releases with SDL_FreeSurface once it has been uploaded, or
+ * NULL if the image could not be reloaded.
+ */
+typedef SDL_Surface *(*Splat_ReloadCallback)(Splat_Image *image, void *userdata);
+
+/**
+ * Callback invoked just before a canvas is rendered, after any wait
+ * for queued frames, so the application can sample input and set the
+ * view position as late as possible.
+ */
+typedef void (*Splat_LateLatchCallback)(Splat_Canvas *canvas, void *userdata);
+
+/**
+ * Callback receiving each captured frame of a canvas.  The pixels are
+ * only valid until the callback returns.  The pitch is negative when
+ * rows are stored bottom-up, so pixels always points at the top row.
+ * frame counts captured frames from 0.
+ */
+typedef void (*Splat_CaptureCallback)(Splat_Canvas *canvas, const void *pixels, int width, int height, int pitch, uint32_t format, uint64_t frame, void *userdata);
+
+/**
+ * Allocator used for all memory Splat allocates, returning NULL if the
+ * allocation fails.  Memory must be aligned for any type, as with
+ * malloc.
+ */
+typedef void *(*Splat_AllocFunction)(size_t size, void *userdata);
+
+/**
+ * Releases memory returned by a Splat_AllocFunction.
+ */
+typedef void (*Splat_FreeFunction)(void *ptr, void *userdata);
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+/**
+ *  Routes Splat's memory through the application's allocator.  Images,
+ *  layers, instances, canvases, debug rects and lines are carved from
+ *  pools of slots the allocator provides in chunks, while other memory
+ *  is requested from it directly.
+ *
+ *  Must be called before Splat_Prepare(), or after Splat_Finish() once
+ *  every object has been destroyed.
+ *
+ *  @param alloc Allocation function, or NULL to restore malloc.
+ *  @param free Release function, or NULL to restore free.
+ *  @param userdata Pointer passed to both functions.
+ *
+ *  Returns 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetAllocator(Splat_AllocFunction alloc, Splat_FreeFunction free, void *userdata);
+
 /**
  *  Prepares Splat for rendering.
  *
  *  The window argument is an SDL window already created by the
- *  application for Splat to use.
+ *  application for Splat to use.  Canvases that are not attached
+ *  to a window with Splat_AttachCanvas() render to this window,
+ *  at the given viewport size.
  *
  *  Returns 0 if successful, 1 otherwise.
  */
 DECLSPEC int SDLCALL Splat_Prepare(SDL_Window *window, int viewportWidth, int viewportHeight);
 
+/**
+ *  Prepares Splat for rendering without a display, for batch jobs
+ *  such as thumbnail generation.  Requires SplatGL to be built with
+ *  EGL, and uses a surfaceless context where available, such as
+ *  Mesa's llvmpipe.
+ *
+ *  Canvases are rendered into their framebuffers at the given size
+ *  and never presented; use Splat_ReadPixels() to retrieve the
+ *  results.  Splat_AttachCanvas() is unavailable in this mode.
+ *
+ *  Returns 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_PrepareOffscreen(int width, int height);
+
 /**
  *  Shuts down Splat and frees any unreleased resources.
  *
@@ -88,6 +257,35 @@ DECLSPEC void SDLCALL Splat_Finish();
  */
 DECLSPEC SDLCALL Splat_Image *Splat_CreateImage(SDL_Surface *surface);
 
+/**
+ * Creates a Splat image from the given SDL_Surface, using the given
+ * Splat_ImageFlags instead of the defaults.
+ *
+ * With SPLAT_IMAGE_COMPRESS, the surface is compressed to DXT1 (24-bit)
+ * or DXT5 (32-bit) when the driver supports S3TC textures, using 4 to 8
+ * times less video memory.  Large images are compressed on several
+ * threads.  If S3TC is unavailable the image is stored uncompressed.
+ * Compression is lossy, so use SPLAT_IMAGE_LOSSLESS for pixel art.
+ *
+ * With SPLAT_IMAGE_DEDUPLICATE, the pixels are hashed and the image
+ * shares the texture of any other deduplicated image with the same
+ * size, format and contents.  Textures with a matching hash are
+ * compared byte for byte, reading them back from video memory unless
+ * they are retained.  The shared texture is released when the
+ * last image using it is destroyed.  Updating a shared image gives it
+ * a texture of its own.
+ *
+ * Returns a pointer to a Splat_Image if successful, NULL otherwise.
+ */
+DECLSPEC SDLCALL Splat_Image *Splat_CreateImageWithFlags(SDL_Surface *surface, uint32_t flags);
+
+/**
+ * Sets the Splat_ImageFlags used by Splat_CreateImage().
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetDefaultImageFlags(uint32_t flags);
+
 /**
  * Updates a Splat image to use the given SDL_Surface. Intended for
  * dynamic reloading of image assets.
@@ -99,12 +297,48 @@ DECLSPEC SDLCALL Splat_Image *Splat_CreateImage(SDL_Surface *surface);
  */
 DECLSPEC SDLCALL int Splat_UpdateImage(Splat_Image *image, SDL_Surface *surface);
 
+/**
+ * Creates a Splat image directly from pixels in application memory,
+ * without an intermediate SDL_Surface.  The pixels are uploaded straight
+ * from the given buffer, which may be freed or unmapped after the call
+ * returns.
+ *
+ * @param pixels Pointer to the first row of pixels.
+ * @param width Width of the image in pixels.
+ * @param height Height of the image in pixels.
+ * @param pitch Distance in bytes between the start of each row.
+ * @param format Splat_PixelFormat of the pixels.
+ *
+ * Returns a pointer to a Splat_Image if successful, NULL otherwise.
+ */
+DECLSPEC SDLCALL Splat_Image *Splat_CreateImageFromPixels(const void *pixels, int width, int height, int pitch, uint32_t format);
+
+/**
+ * Creates an image to be rendered into by a canvas with
+ * Splat_RenderToImage(), such as a minimap or a reflection.  The
+ * contents stay on the GPU.  Target images cannot be updated,
+ * retained or reloaded, are never evicted, and must fit in one
+ * texture.
+ *
+ * Returns a pointer to a Splat_Image if successful, NULL otherwise.
+ */
+DECLSPEC SDLCALL Splat_Image *Splat_CreateTargetImage(int width, int height);
+
+/**
+ * Updates a Splat image with pixels from application memory.  The
+ * size and format may differ from the image's current contents.
+ *
+ * Returns 0 if successful, 1 otherwise.  The original image will
+ * remain in use if the update fails.
+ */
+DECLSPEC int SDLCALL Splat_UpdateImageFromPixels(Splat_Image *image, const void *pixels, int width, int height, int pitch, uint32_t format);
+
 /**
  * Destroys a Splat image previously created.
  *
- * This will invalidate any active Splat_Instance objects that still
- * reference this image.  Those instances must still be destroyed to
- * free the other resources associated with them.
+ * Fails while any instance still shows the image; destroy those
+ * instances or give them another image first.  Animations of the
+ * image are destroyed with it.
  *
  *  Returns 0 if successful, 1 otherwise.
  */
@@ -121,6 +355,175 @@ DECLSPEC int SDLCALL Splat_DestroyImage(Splat_Image *image);
  */
 DECLSPEC int SDLCALL Splat_GetImageSize(Splat_Image *image, uint32_t *width, uint32_t *height);
 
+/**
+ * Sets the largest texture Splat will create for an image.  Images
+ * wider or taller than this, or than GL_MAX_TEXTURE_SIZE, are split
+ * into a grid of tiles.  Instances of tiled images are drawn one tile
+ * at a time, skipping tiles outside the view.  Only affects images
+ * created or updated after the call.
+ *
+ * @param size Largest tile size in pixels, or 0 to use GL_MAX_TEXTURE_SIZE.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetImageTileSize(uint32_t size);
+
+/**
+ * Sets how long a tile of a tiled image may go without being rendered
+ * before it is released from video memory, regardless of the texture
+ * budget.  Released tiles are uploaded again when they come back into
+ * view.  As with the texture budget, only tiles of images with
+ * retained pixels or a reload callback are released.
+ *
+ * @param frames Number of frames, or 0 to keep tiles until the budget requires eviction.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetTileReleaseDelay(uint32_t frames);
+
+/**
+ * Sets the amount of video memory Splat may use for image textures.
+ *
+ * When the textures resident in video memory exceed the budget, the
+ * least recently rendered images are evicted at the end of
+ * Splat_Render().  Only images with a retained copy of their pixels
+ * or a reload callback can be evicted, and images rendered in the
+ * current frame are never evicted.  Evicted images are uploaded
+ * again the next time an instance of them is rendered.
+ *
+ * @param bytes Budget in bytes, or 0 to disable eviction.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetTextureBudget(uint64_t bytes);
+
+/**
+ * Sets whether Splat keeps a copy of the image's pixels in system
+ * memory, allowing the image to be evicted from video memory and
+ * restored without the application's help.  A texture shared with
+ * other deduplicated images keeps its copy while any of them is
+ * retained, and an evicted texture keeps its copy until it is
+ * restored.
+ *
+ * @param image Image to update.
+ * @param retain Non-zero to keep a copy of the pixels, 0 to release it.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetImageRetained(Splat_Image *image, int retain);
+
+/**
+ * Sets the callback used to reload the image's pixels after it has
+ * been evicted from video memory.  A retained copy of the pixels is
+ * preferred over the callback if both are available.
+ *
+ * @param image Image to update.
+ * @param callback Reload callback, or NULL to remove it.
+ * @param userdata Pointer passed to the callback.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetImageReloadCallback(Splat_Image *image, Splat_ReloadCallback callback, void *userdata);
+
+/**
+ * Retrieves texture memory statistics.
+ *
+ * @param stats Pointer to a Splat_TextureStats structure to fill.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_GetTextureStats(Splat_TextureStats *stats);
+
+/**
+ * Retrieves how much memory Splat holds, by type of object, and an
+ * estimate of its video memory.
+ *
+ * @param stats Pointer to a Splat_MemoryStats structure to fill.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_GetMemoryStats(Splat_MemoryStats *stats);
+
+/**
+ * Retrieves statistics of the last render of a canvas, along with
+ * percentiles of its last 256 frame times.
+ *
+ * @param canvas Canvas to query.
+ * @param stats Pointer to a Splat_FrameStats structure to fill.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_GetFrameStats(Splat_Canvas *canvas, Splat_FrameStats *stats);
+
+/**
+ * Starts writing a trace of rendering and image uploads to a file in
+ * the Chrome trace-event JSON format, which can be opened in
+ * chrome://tracing or Perfetto.  Events are buffered per thread and
+ * written by a background thread; if a thread records events faster
+ * than they are written, the excess is dropped and counted in the
+ * trace's droppedEvents field.  Up to 64 threads can hold a buffer at
+ * once; buffers of threads created with SDL_CreateThread() that have
+ * exited are reused from the next trace on.  Events from threads
+ * beyond the limit are not recorded.
+ *
+ * @param path File to write the trace to.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_StartTrace(const char *path);
+
+/**
+ * Stops the trace started by Splat_StartTrace() and closes its file.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_StopTrace();
+
+/**
+ * Starts recording the GL commands of the next frames rendered, along
+ * with the textures, framebuffers and shaders they start from, so the
+ * frames can be replayed later by splatreplay without the application.
+ * The capture stops by itself once the frames have been recorded.
+ *
+ * @param path Path of the capture file to write.
+ * @param frames Number of frames to record.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_StartGLCapture(const char *path, int frames);
+
+/**
+ * Stops a capture started by Splat_StartGLCapture() before all of its
+ * frames have been recorded, keeping the frames recorded so far.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_StopGLCapture();
+
+/**
+ * Enables or disables timing each layer, the debug pass and the blit
+ * of a canvas on the GPU.  Results are read back a few frames later,
+ * so profiling never waits for the GPU.  Profiling is off by default.
+ *
+ * @param canvas Canvas to profile.
+ * @param enable Non-zero to enable profiling, zero to disable it.
+ *
+ * @return 0 if successful, 1 otherwise, such as when timer queries
+ *         are not supported.
+ */
+DECLSPEC int SDLCALL Splat_SetGpuProfiling(Splat_Canvas *canvas, int enable);
+
+/**
+ * Retrieves the latest GPU time spent drawing a layer, while its
+ * canvas is being profiled.
+ *
+ * @param layer Layer to query.
+ * @param ms Receives the time in milliseconds.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_GetLayerGpuTime(Splat_Layer *layer, float *ms);
+
 /**
  * Create a Splat Layer.
  *
@@ -189,15 +592,53 @@ DECLSPEC int SDLCALL Splat_SetInstanceLayer(Splat_Instance *instance, Splat_Laye
 /**
  * Update the image the instance refers.
  *
- * If subimage is not NULL, it specifies the bounds of the image
- * to display.  If image is NULL, only the subimage is updated.
- * If both are NULL, the instance is updated to the full size of
- * the image.
+ * The s and t coordinates specify the bounds of the image to
+ * display.  If image is NULL, only the bounds are updated.  Any
+ * animation playing on the instance is stopped.
  *
  * Returns 0 if successful, 1 otherwise.
  */
 DECLSPEC int SDLCALL Splat_SetInstanceImage(Splat_Instance *instance, Splat_Image *image, float s1, float t1, float s2, float t2);
 
+/**
+ * Creates an animation from a table of frames within the given image,
+ * such as the cells of a sprite sheet.  The frames are copied.  The
+ * animation is destroyed along with the image.
+ *
+ * @param image Image containing the frames.
+ * @param frames Array of frames, played in order.
+ * @param count Number of frames.
+ *
+ * Returns a pointer to the new Splat_Animation, or NULL if an
+ * error occurs.
+ */
+DECLSPEC Splat_Animation *SDLCALL Splat_CreateAnimation(Splat_Image *image, const Splat_AnimationFrame *frames, int count);
+
+/**
+ * Destroys an animation.  Instances playing the animation stop on
+ * their current frame.
+ *
+ * Returns 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_DestroyAnimation(Splat_Animation *animation);
+
+/**
+ * Plays an animation on the instance, starting from its first frame.
+ * The instance switches to the animation's image.  Splat_Render
+ * advances the frame shown from the canvas clock, so no further calls
+ * are needed each frame.  A non-looping animation holds its last frame.
+ *
+ * Returns 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_PlayAnimation(Splat_Instance *instance, Splat_Animation *animation, int loop);
+
+/**
+ * Stops the instance's animation, leaving the current frame shown.
+ *
+ * Returns 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_StopAnimation(Splat_Instance *instance);
+
 /**
  * Sets the flags for the specified instance.
  *
@@ -205,6 +646,119 @@ DECLSPEC int SDLCALL Splat_SetInstanceImage(Splat_Instance *instance, Splat_Imag
  */
 DECLSPEC int SDLCALL Splat_SetInstanceFlags(Splat_Instance *instance, uint32_t flags);
 
+/**
+ * Sets the angle in degrees the instance is rotated by when it has
+ * the SPLAT_ROTATE flag.
+ *
+ * Returns 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetInstanceAngle(Splat_Instance *instance, float angle);
+
+/**
+ * Restricts drawing of the instance to a rect in canvas coordinates,
+ * or draws it unclipped if clip is NULL or empty.
+ *
+ * Returns 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetInstanceClip(Splat_Instance *instance, SDL_Rect *clip);
+
+/**
+ * Moves many instances at once, which costs far less per instance than
+ * Splat_SetInstancePosition() when called through a language binding.
+ * Nothing is changed if any instance is NULL.
+ *
+ * @param instances Array of count instances.
+ * @param positions Array of count x, y pairs.
+ * @param count Number of instances.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetInstancesPosition(Splat_Instance **instances, const int32_t *positions, int count);
+
+/**
+ * Sets the flags of many instances at once, as Splat_SetInstanceFlags().
+ * Nothing is changed if any instance is NULL.
+ *
+ * @param instances Array of count instances.
+ * @param flags Array of count flag sets.
+ * @param count Number of instances.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetInstancesFlags(Splat_Instance **instances, const uint32_t *flags, int count);
+
+/**
+ * Sets the subimage of many instances at once, as
+ * Splat_SetInstanceImage() with a NULL image, stopping any animation.
+ * Nothing is changed if any instance is NULL.
+ *
+ * @param instances Array of count instances.
+ * @param texcoords Array of count s1, t1, s2, t2 quadruples.
+ * @param count Number of instances.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetInstancesTexCoords(Splat_Instance **instances, const float *texcoords, int count);
+
+/**
+ * Number of queues threads may record instance updates in, see
+ * Splat_SetThreadQueue().
+ */
+#define SPLAT_MAX_THREAD_QUEUES 64
+
+/**
+ * Lets any thread call Splat_SetInstancePosition(),
+ * Splat_SetInstanceLayer(), Splat_SetInstanceImage(),
+ * Splat_SetInstanceFlags(), Splat_SetInstanceAngle(),
+ * Splat_SetInstanceClip(), Splat_PlayAnimation() and
+ * Splat_StopAnimation().
+ *
+ * Must be called from the thread that renders, whose calls still take
+ * effect immediately.  Calls from other threads are checked, recorded
+ * in a queue owned by the calling thread without taking locks, and
+ * applied at the start of the next Splat_Render(), queue by queue in
+ * index order.  A call made while a render is starting may land in
+ * that render or the next, so finish updating before rendering.
+ *
+ * Every other function, including creating and destroying instances,
+ * must still be called from the rendering thread only.  Destroying an
+ * instance, layer, image or animation drops the queued calls that
+ * refer to it, so the thread destroying an object must be sure no
+ * other thread is still queueing calls with it.
+ *
+ * @param enable Non-zero to enable queueing.  Disabling applies calls
+ *        already queued, and must also be done on the rendering thread.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetThreadedUpdates(int enable);
+
+/**
+ * Records the calling thread's instance updates in the given queue,
+ * so they are applied in the same order on every run.  Worker threads
+ * of a job system would typically claim their worker index.  Threads
+ * that queue updates without calling this claim the first free queue
+ * instead.  A queue is released when its thread exits only if the
+ * thread was created with SDL_CreateThread(); other threads, such as
+ * pthreads, std::thread or Python threads, must call
+ * Splat_ReleaseThreadQueue() before exiting.
+ *
+ * @param index Queue index, below SPLAT_MAX_THREAD_QUEUES.
+ *
+ * @return 0 if successful, 1 otherwise, such as when another thread
+ *         owns the queue.
+ */
+DECLSPEC int SDLCALL Splat_SetThreadQueue(int index);
+
+/**
+ * Releases the calling thread's queue so another thread may claim it.
+ * Calls already queued are still applied.  The thread claims a queue
+ * again if it queues another update.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_ReleaseThreadQueue();
+
 /**
  * Set the default background color.
  *
@@ -248,6 +802,139 @@ DECLSPEC int SDLCALL Splat_SetScale(Splat_Canvas *canvas, float x, float y);
  */
 DECLSPEC int SDLCALL Splat_Render(Splat_Canvas *canvas);
 
+/**
+ * Sets how frames are presented: SPLAT_PRESENT_VSYNC,
+ * SPLAT_PRESENT_ADAPTIVE or SPLAT_PRESENT_IMMEDIATE.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetPresentMode(int mode);
+
+/**
+ * Limits how many rendered frames may be queued on the GPU.  When the
+ * limit is reached, Splat_Render() waits for the oldest frame to
+ * finish before rendering, which reduces input latency at some cost
+ * in throughput.  1 gives the lowest latency.  Without OpenGL 3.2 or
+ * ARB_sync, any limit finishes each frame before the next is rendered.
+ *
+ * @param frames - Frames allowed in flight, up to 8, or 0 to leave
+ *          queueing to the driver.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetMaxFramesInFlight(int frames);
+
+/**
+ * Sets a callback run just before the canvas is rendered, to update
+ * its view position from the latest input.
+ *
+ * @param canvas - Canvas to watch.
+ * @param callback - Callback, or NULL to remove it.
+ * @param userdata - Passed to the callback.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetLateLatchCallback(Splat_Canvas *canvas, Splat_LateLatchCallback callback, void *userdata);
+
+/**
+ * Renders several canvases into one frame of a window, then presents
+ * it once.  Canvases are composited in order, each over the ones
+ * before it, so a HUD canvas cleared with a transparent color can be
+ * drawn over a world canvas.  Each canvas keeps its own origin and
+ * scale.  All canvases must be attached to the same window.
+ *
+ * @param canvases - Array of canvases, from bottom to top.
+ * @param count - Number of canvases.
+ * @param viewports - Array of rects in window coordinates, one per
+ *          canvas, into which each canvas is scaled.  If NULL, every
+ *          canvas fills the window.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_RenderCanvases(Splat_Canvas **canvases, int count, const SDL_Rect *viewports);
+
+/**
+ * Renders a canvas into an image created with Splat_CreateTargetImage()
+ * instead of a window.  Instances on other canvases may show the image
+ * right away.  The canvas is rendered at the start of each
+ * Splat_Render(), before the canvases being presented, once the
+ * interval has passed since it was last rendered.  A canvas must not
+ * show its own target image.
+ *
+ * @param canvas - Canvas to render into the image.
+ * @param image - Target image, or NULL to stop rendering into an image.
+ * @param interval - Milliseconds between renders, 0 to render every frame.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_RenderToImage(Splat_Canvas *canvas, Splat_Image *image, uint32_t interval);
+
+/**
+ * Reads the most recently rendered frame of a canvas, at the canvas'
+ * render size (see Splat_GetRenderSize()) and before it is scaled to
+ * the window.  Pixels are
+ * written top row first, in SPLAT_PIXELFORMAT_RGBA32.  This call waits
+ * for rendering to finish.
+ *
+ * @param canvas - Canvas to read.
+ * @param pixels - Buffer receiving the pixels.
+ * @param pitch - Bytes between rows of the buffer, a multiple of 4,
+ *          and at least 4 times the viewport width.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_ReadPixels(Splat_Canvas *canvas, void *pixels, int pitch);
+
+/**
+ * Enables dynamic resolution for a canvas.  The GPU time of each frame
+ * is measured, and the canvas is rendered at a fraction of its viewport
+ * size whenever it runs over the target, then scaled up to the window
+ * as usual.  The scale recovers once the GPU has headroom again.
+ *
+ * @param canvas - Canvas to scale.
+ * @param targetFrameTime - GPU milliseconds per frame to stay under,
+ *          or 0 to render at the full viewport size again.
+ * @param minScale - Smallest scale of each axis, greater than 0.
+ * @param maxScale - Largest scale of each axis, at most 1.
+ *
+ * @return 0 if successful, 1 otherwise, including when the driver
+ *         does not support timer queries.
+ */
+DECLSPEC int SDLCALL Splat_SetDynamicResolution(Splat_Canvas *canvas, float targetFrameTime, float minScale, float maxScale);
+
+/**
+ * Retrieves the size the canvas was last rendered at, which is its
+ * viewport size unless dynamic resolution is enabled.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_GetRenderSize(Splat_Canvas *canvas, int *width, int *height);
+
+/**
+ * Captures every frame rendered on the canvas without stalling the
+ * GPU.  Each frame is read back asynchronously and passed to the
+ * callback, in order, a few frames after it was rendered.  Frames are
+ * delivered from within Splat_Render(), in SPLAT_PIXELFORMAT_BGRA32.
+ * Starting a capture replaces any capture already running.  A canvas
+ * rendering into an image (see Splat_RenderToImage()) is captured each
+ * time it refreshes the image.
+ *
+ * @param canvas - Canvas to capture, which must already be attached or rendered.
+ * @param callback - Function receiving the frames.
+ * @param userdata - Passed to the callback.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_StartCapture(Splat_Canvas *canvas, Splat_CaptureCallback callback, void *userdata);
+
+/**
+ * Stops capturing a canvas.  Frames still in flight are delivered
+ * before this returns.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_StopCapture(Splat_Canvas *canvas);
+
 /**
  * Draw a rectangle outline.  Intended primarily for debugging.
  * Draws above all normal layers.
@@ -290,6 +977,25 @@ DECLSPEC int SDLCALL Splat_DrawLine(Splat_Canvas *canvas, SDL_Point *start, SDL_
  */
 DECLSPEC SDLCALL Splat_Canvas *Splat_CreateCanvas();
 
+/**
+ * Attaches a canvas to a window, so several windows can be rendered
+ * from one process.  The window must be created with SDL_WINDOW_OPENGL
+ * and the same pixel format as the window passed to Splat_Prepare().
+ * All windows share one OpenGL context, so every image is uploaded
+ * once and may be drawn in any window.
+ *
+ * The canvas is rendered at the viewport size, then scaled up to fill
+ * the window.  Attaching again changes the window or viewport size.
+ *
+ * @param canvas - Canvas to attach.
+ * @param window - Window to present the canvas in.
+ * @param viewportWidth - Width of the canvas' render target.
+ * @param viewportHeight - Height of the canvas' render target.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_AttachCanvas(Splat_Canvas *canvas, SDL_Window *window, int viewportWidth, int viewportHeight);
+
 /**
  * Destroys the given canvas to draw on.  All images, layers,
  * and instances associated with it will be invalidated and
@@ -302,7 +1008,8 @@ DECLSPEC SDLCALL Splat_Canvas *Splat_CreateCanvas();
 DECLSPEC int SDLCALL Splat_DestroyCanvas(Splat_Canvas *canvas);
 
 /**
- * Retrieve the current error string, if any.
+ * Retrieve the current error string, if any.  Each thread has its
+ * own error string.
  *
  * @return The current error string, or NULL if no error has occurred.
  */
@@ -320,17 +1027,102 @@ DECLSPEC void SDLCALL Splat_SetError(const char *error, ...);
  */
 #define Splat_ClearError() Splat_SetError(0)
 
-//TODO SPLAT_SHADERS_EXPERIMENTAL
-//DECLSPEC Splat_Shader *SDLCALL Splat_CreateShader(const char *source, int shaderType);
-//DECLSPEC int SDLCALL Splat_DestroyShader(Splat_Shader *shader);
-//
-//DECLSPEC Splat_Program *SDLCALL Splat_CreateProgram();
-//DECLSPEC int SDLCALL Splat_DestroyProgram(Splat_Program *program);
-//DECLSPEC int SDLCALL Splat_AttachShader(Splat_Program *program, Splat_Shader *shader);
-//DECLSPEC int SDLCALL Splat_LinkProgram(Splat_Program *program);
-//
-//DECLSPEC int SDLCALL Splat_SetCanvasProgram(Splat_Canvas *canvas, Splat_Program *program);
-//
+/**
+ * Creates a GLSL shader.  The source is compiled when a program it is
+ * attached to is linked, and only if that program is not found in the
+ * shader cache.
+ *
+ * @param source - GLSL source code, which is copied.
+ * @param shaderType - One of Splat_ShaderType.
+ *
+ * @return The new shader, or NULL if an error occurs.
+ */
+DECLSPEC Splat_Shader *SDLCALL Splat_CreateShader(const char *source, int shaderType);
+
+/**
+ * Destroys a shader.  Programs it is attached to keep a copy of
+ * its source and are unaffected.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_DestroyShader(Splat_Shader *shader);
+
+/**
+ * Creates an empty program.  Attach shaders, then link it.
+ *
+ * @return The new program, or NULL if an error occurs.
+ */
+DECLSPEC Splat_Program *SDLCALL Splat_CreateProgram();
+
+/**
+ * Destroys a program, removing it from any canvas using it.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_DestroyProgram(Splat_Program *program);
+
+/**
+ * Attaches a shader to a program.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_AttachShader(Splat_Program *program, Splat_Shader *shader);
+
+/**
+ * Links a program.  Post-process programs receive their input frame
+ * in texture unit 0, through the following optional uniforms:
+ *
+ *   sampler2D rubyTexture - The input frame.
+ *   vec2 rubyInputSize - Size of the input frame in pixels.
+ *   vec2 rubyTextureSize - Size of the texture holding the input frame.
+ *   vec2 rubyOutputSize - Size of the pass' output in pixels.
+ *   int rubyFrameCount - Number of frames rendered.
+ *
+ * If a shader cache directory is set, a binary of the linked program
+ * is loaded from it when present, skipping compilation, and stored in
+ * it otherwise.
+ *
+ * @return 0 if successful, 1 otherwise.  The compiler or linker log
+ *         is available from Splat_GetError().
+ */
+DECLSPEC int SDLCALL Splat_LinkProgram(Splat_Program *program);
+
+/**
+ * Sets the directory where linked program binaries are cached between
+ * runs.  Entries are keyed by the shader sources, the OpenGL vendor,
+ * renderer and version, and the SplatGL version, so driver updates
+ * simply miss the cache.  The directory must already exist.  Caching
+ * requires OpenGL 4.1 or ARB_get_program_binary and is skipped
+ * otherwise.
+ *
+ * @param path - Directory for cache files, or NULL to disable caching.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetShaderCacheDirectory(const char *path);
+
+/**
+ * Sets the chain of post-process programs applied as the canvas is
+ * scaled into its window.  Every pass but the last renders at the
+ * size of the canvas' rect in the window; the last draws into the
+ * window.  The chain is copied.
+ *
+ * @param canvas - Canvas to apply the programs to.
+ * @param programs - Linked programs, in the order applied.
+ * @param count - Number of programs, 0 to draw the canvas unfiltered.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetCanvasPrograms(Splat_Canvas *canvas, Splat_Program **programs, int count);
+
+/**
+ * Sets a single post-process program for the canvas, or NULL for none.
+ *
+ * @return 0 if successful, 1 otherwise.
+ */
+DECLSPEC int SDLCALL Splat_SetCanvasProgram(Splat_Canvas *canvas, Splat_Program *program);
+
+//TODO Per-image and per-instance programs
 //DECLSPEC int SDLCALL Splat_SetImageDefaultProgram(Splat_Image *image, Splat_Program *program);
 //DECLSPEC int SDLCALL Splat_SetInstanceProgram(Splat_Instance *instance, Splat_Program *program);
 
@@ -1,4 +1,22 @@
-from setuptools import setup
+import os
+import shlex
+import subprocess
+from setuptools import setup, Extension
+
+def sdl2_config(option):
+    try:
+        return shlex.split(subprocess.check_output(['sdl2-config', option]).decode())
+    except (OSError, subprocess.CalledProcessError):
+        return []
+
+# The native binding is optional: if it fails to build, splatgl falls back to ctypes
+sdl2_cflags = sdl2_config('--cflags')
+native = Extension('splatgl._splatgl',
+                   sources=['splatgl/_splatgl.c'],
+                   include_dirs=[os.path.join(os.pardir, 'include')] + [flag[2:] for flag in sdl2_cflags if flag.startswith('-I')],
+                   extra_compile_args=[flag for flag in sdl2_cflags if not flag.startswith('-I')],
+                   libraries=['splatgl'],
+                   optional=True)
 
 setup(name='splatgl',
       version='0.0.0',
@@ -9,11 +27,13 @@ setup(name='splatgl',
       author_email='mlong@digitalbytes.net',
       license='zlib',
       packages=['splatgl'],
+      ext_modules=[native],
       zip_safe=False,
       classifiers=[
           'Development Status :: 3 - Alpha',
           'License :: OSI Approved :: zlib/libpng License',
           'Programming Language :: Python :: 2.7',
+          'Programming Language :: Python :: 3',
           'Intended Audience :: Developers',
           'Topic :: Multimedia :: Graphics',
           ],
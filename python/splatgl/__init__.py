@@ -18,19 +18,25 @@
 #    misrepresented as being the original software.
 # 3. This notice may not be removed or altered from any source distribution.
 
-from ctypes import CDLL, c_char_p, c_uint32, c_int, c_float, Structure, POINTER, byref
+from ctypes import CDLL, CFUNCTYPE, c_char, c_char_p, c_uint32, c_uint64, c_int, c_float, c_void_p, Structure, POINTER, byref, sizeof, cast
 from ctypes.util import find_library
 from sdl2 import SDL_Rect, SDL_Point, SDL_Surface, SDL_Window, SDL_Color
 from enum import IntEnum
+from array import array
+
+# The native extension is optional; without it every call goes through ctypes
+try:
+	from . import _splatgl
+except ImportError:
+	_splatgl = None
 
 class error(Exception):
-	def __init__(self):
-		error = _get_error()
-		_set_error(None)
-		if error is not None:
-			super().__init__(error.decode())
-		else:
-			super().__init__("Undefined Splat error")
+	def __init__(self, message=None):
+		if message is None:
+			error = _get_error()
+			_set_error(None)
+			message = error.decode() if error is not None else "Undefined Splat error"
+		super().__init__(message)
 
 def _validate_ptr(result, func, arguments):
 	#print("{}{} => {}".format(func.name, arguments, result))
@@ -78,6 +84,98 @@ class Splat_Instance(Structure):
 class Splat_Canvas(Structure):
 	pass
 
+class Splat_Animation(Structure):
+	pass
+
+class Splat_Shader(Structure):
+	pass
+
+class Splat_Program(Structure):
+	pass
+
+class ImageFlags(IntEnum):
+    COMPRESS = 0x0001
+    LOSSLESS = 0x0002
+    DEDUPLICATE = 0x0004
+
+class PixelFormat(IntEnum):
+    RGBA32 = 0
+    BGRA32 = 1
+    ARGB32 = 2
+    ABGR32 = 3
+    RGB24 = 4
+    BGR24 = 5
+    RGB565 = 6
+    RGBA4444 = 7
+    RGBA5551 = 8
+    A8 = 9
+    L8 = 10
+
+class TextureStats(Structure):
+	_fields_ = [
+		("budget", c_uint64),
+		("resident_bytes", c_uint64),
+		("evicted_bytes", c_uint64),
+		("resident_textures", c_uint32),
+		("evicted_textures", c_uint32),
+		("evictions", c_uint32),
+		("reloads", c_uint32),
+		("shared_images", c_uint32),
+		("saved_bytes", c_uint64),
+	]
+
+class MemoryType(IntEnum):
+    IMAGE = 0
+    LAYER = 1
+    INSTANCE = 2
+    CANVAS = 3
+    RECT = 4
+    LINE = 5
+    OTHER = 6
+
+class MemoryStats(Structure):
+	_fields_ = [
+		("cpu_bytes", c_uint64),
+		("gpu_bytes", c_uint64),
+		("bytes", c_uint64 * len(MemoryType)),
+		("objects", c_uint32 * len(MemoryType)),
+	]
+
+class FrameStats(Structure):
+	_fields_ = [
+		("instances_visited", c_uint32),
+		("instances_culled", c_uint32),
+		("instances_drawn", c_uint32),
+		("draw_calls", c_uint32),
+		("texture_binds", c_uint32),
+		("state_changes", c_uint32),
+		("bytes_uploaded", c_uint64),
+		("layer_time", c_float),
+		("debug_time", c_float),
+		("blit_time", c_float),
+		("swap_time", c_float),
+		("debug_gpu_time", c_float),
+		("blit_gpu_time", c_float),
+		("frame_time", c_float),
+		("frame_time_p50", c_float),
+		("frame_time_p95", c_float),
+		("frame_time_p99", c_float),
+		("frame_count", c_uint32),
+	]
+
+class AnimationFrame(Structure):
+	_fields_ = [
+		("s1", c_float),
+		("t1", c_float),
+		("s2", c_float),
+		("t2", c_float),
+		("duration", c_uint32),
+	]
+
+ReloadCallback = CFUNCTYPE(POINTER(SDL_Surface), POINTER(Splat_Image), c_void_p)
+LateLatchCallback = CFUNCTYPE(None, POINTER(Splat_Canvas), c_void_p)
+CaptureCallback = CFUNCTYPE(None, POINTER(Splat_Canvas), c_void_p, c_int, c_int, c_int, c_uint32, c_uint64, c_void_p)
+
 class Flags(IntEnum):
     MIRROR_X = 0x0001
     MIRROR_Y = 0x0002
@@ -87,11 +185,41 @@ class Flags(IntEnum):
     STATIC = 0x0020
     FILLED = 0x0020
 
+class PresentMode(IntEnum):
+    VSYNC = 0
+    ADAPTIVE = 1
+    IMMEDIATE = 2
+
+class ShaderType(IntEnum):
+    VERTEX = 0
+    FRAGMENT = 1
+    GEOMETRY = 2
+
 prepare = _bind("Splat_Prepare", [POINTER(SDL_Window), c_int, c_int], c_int, _validate_int)
+prepare_offscreen = _bind("Splat_PrepareOffscreen", [c_int, c_int], c_int, _validate_int)
 finish = _bind("Splat_Finish")
 create_image = _bind("Splat_CreateImage", [POINTER(SDL_Surface)], POINTER(Splat_Image), _validate_ptr)
+create_image_with_flags = _bind("Splat_CreateImageWithFlags", [POINTER(SDL_Surface), c_uint32], POINTER(Splat_Image), _validate_ptr)
+create_image_from_pixels = _bind("Splat_CreateImageFromPixels", [c_void_p, c_int, c_int, c_int, c_uint32], POINTER(Splat_Image), _validate_ptr)
+create_target_image = _bind("Splat_CreateTargetImage", [c_int, c_int], POINTER(Splat_Image), _validate_ptr)
+update_image_from_pixels = _bind("Splat_UpdateImageFromPixels", [POINTER(Splat_Image), c_void_p, c_int, c_int, c_int, c_uint32], c_int, _validate_int)
+set_default_image_flags = _bind("Splat_SetDefaultImageFlags", [c_uint32], c_int, _validate_int)
 update_image = _bind("Splat_UpdateImage", [POINTER(Splat_Image), POINTER(SDL_Surface)], c_int, _validate_int)
 destroy_image = _bind("Splat_DestroyImage", [POINTER(Splat_Image)], c_int, _validate_int)
+set_image_tile_size = _bind("Splat_SetImageTileSize", [c_uint32], c_int, _validate_int)
+set_tile_release_delay = _bind("Splat_SetTileReleaseDelay", [c_uint32], c_int, _validate_int)
+set_texture_budget = _bind("Splat_SetTextureBudget", [c_uint64], c_int, _validate_int)
+set_image_retained = _bind("Splat_SetImageRetained", [POINTER(Splat_Image), c_int], c_int, _validate_int)
+_set_image_reload_callback = _bind("Splat_SetImageReloadCallback", [POINTER(Splat_Image), ReloadCallback, c_void_p], c_int, _validate_int)
+_get_texture_stats = _bind("Splat_GetTextureStats", [POINTER(TextureStats)], c_int, _validate_int)
+_get_memory_stats = _bind("Splat_GetMemoryStats", [POINTER(MemoryStats)], c_int, _validate_int)
+_get_frame_stats = _bind("Splat_GetFrameStats", [POINTER(Splat_Canvas), POINTER(FrameStats)], c_int, _validate_int)
+start_trace = _bind("Splat_StartTrace", [c_char_p], c_int, _validate_int)
+stop_trace = _bind("Splat_StopTrace", [], c_int, _validate_int)
+start_gl_capture = _bind("Splat_StartGLCapture", [c_char_p, c_int], c_int, _validate_int)
+stop_gl_capture = _bind("Splat_StopGLCapture", [], c_int, _validate_int)
+set_gpu_profiling = _bind("Splat_SetGpuProfiling", [POINTER(Splat_Canvas), c_int], c_int, _validate_int)
+_get_layer_gpu_time = _bind("Splat_GetLayerGpuTime", [POINTER(Splat_Layer), POINTER(c_float)], c_int, _validate_int)
 create_layer = _bind("Splat_CreateLayer", [POINTER(Splat_Canvas)], POINTER(Splat_Layer), _validate_ptr)
 destroy_layer = _bind("Splat_DestroyLayer", [POINTER(Splat_Layer)], c_int, _validate_int)
 move_layer = _bind("Splat_MoveLayer", [POINTER(Splat_Layer)], c_int, _validate_int)
@@ -100,16 +228,49 @@ destroy_instance = _bind("Splat_DestroyInstance", [POINTER(Splat_Instance)], c_i
 set_instance_position = _bind("Splat_SetInstancePosition", [POINTER(Splat_Instance), c_int, c_int], c_int, _validate_int)
 set_instance_layer = _bind("Splat_SetInstanceLayer", [POINTER(Splat_Instance), POINTER(Splat_Layer)], c_int, _validate_int)
 set_instance_image = _bind("Splat_SetInstanceImage", [POINTER(Splat_Instance), POINTER(Splat_Image), c_float, c_float, c_float, c_float], c_int, _validate_int)
+_create_animation = _bind("Splat_CreateAnimation", [POINTER(Splat_Image), POINTER(AnimationFrame), c_int], POINTER(Splat_Animation), _validate_ptr)
+destroy_animation = _bind("Splat_DestroyAnimation", [POINTER(Splat_Animation)], c_int, _validate_int)
+play_animation = _bind("Splat_PlayAnimation", [POINTER(Splat_Instance), POINTER(Splat_Animation), c_int], c_int, _validate_int)
+stop_animation = _bind("Splat_StopAnimation", [POINTER(Splat_Instance)], c_int, _validate_int)
 set_instance_flags = _bind("Splat_SetInstanceFlags", [POINTER(Splat_Instance), c_uint32], c_int, _validate_int)
+set_instance_angle = _bind("Splat_SetInstanceAngle", [POINTER(Splat_Instance), c_float], c_int, _validate_int)
+set_instance_clip = _bind("Splat_SetInstanceClip", [POINTER(Splat_Instance), POINTER(SDL_Rect)], c_int, _validate_int)
+_set_instances_position = _bind("Splat_SetInstancesPosition", [c_void_p, c_void_p, c_int], c_int, _validate_int)
+_set_instances_flags = _bind("Splat_SetInstancesFlags", [c_void_p, c_void_p, c_int], c_int, _validate_int)
+_set_instances_texcoords = _bind("Splat_SetInstancesTexCoords", [c_void_p, c_void_p, c_int], c_int, _validate_int)
+set_threaded_updates = _bind("Splat_SetThreadedUpdates", [c_int], c_int, _validate_int)
+set_thread_queue = _bind("Splat_SetThreadQueue", [c_int], c_int, _validate_int)
+release_thread_queue = _bind("Splat_ReleaseThreadQueue", [], c_int, _validate_int)
 set_clear_color = _bind("Splat_SetClearColor", [POINTER(Splat_Canvas), c_float, c_float, c_float, c_float], c_int, _validate_int)
 _get_view_position = _bind("Splat_GetViewPosition", [POINTER(Splat_Canvas), POINTER(SDL_Point)], c_int, _validate_int)
 set_view_position =  _bind("Splat_SetViewPosition", [POINTER(Splat_Canvas), POINTER(SDL_Point)], c_int, _validate_int)
 _get_scale = _bind("Splat_GetScale", [POINTER(Splat_Canvas), POINTER(c_float), POINTER(c_float)], c_int, _validate_int)
 set_scale = _bind("Splat_SetScale", [POINTER(Splat_Canvas), c_float, c_float], c_int, _validate_int)
 render = _bind("Splat_Render", [POINTER(Splat_Canvas)], c_int, _validate_int)
+_start_capture = _bind("Splat_StartCapture", [POINTER(Splat_Canvas), CaptureCallback, c_void_p], c_int, _validate_int)
+_stop_capture = _bind("Splat_StopCapture", [POINTER(Splat_Canvas)], c_int, _validate_int)
+render_to_image = _bind("Splat_RenderToImage", [POINTER(Splat_Canvas), POINTER(Splat_Image), c_uint32], c_int, _validate_int)
+set_dynamic_resolution = _bind("Splat_SetDynamicResolution", [POINTER(Splat_Canvas), c_float, c_float, c_float], c_int, _validate_int)
+_get_render_size = _bind("Splat_GetRenderSize", [POINTER(Splat_Canvas), POINTER(c_int), POINTER(c_int)], c_int, _validate_int)
+read_pixels = _bind("Splat_ReadPixels", [POINTER(Splat_Canvas), c_void_p, c_int], c_int, _validate_int)
+set_present_mode = _bind("Splat_SetPresentMode", [c_int], c_int, _validate_int)
+set_max_frames_in_flight = _bind("Splat_SetMaxFramesInFlight", [c_int], c_int, _validate_int)
+_set_late_latch_callback = _bind("Splat_SetLateLatchCallback", [POINTER(Splat_Canvas), LateLatchCallback, c_void_p], c_int, _validate_int)
+_render_canvases = _bind("Splat_RenderCanvases", [POINTER(POINTER(Splat_Canvas)), c_int, POINTER(SDL_Rect)], c_int, _validate_int)
 
 create_canvas = _bind("Splat_CreateCanvas", None, POINTER(Splat_Canvas), _validate_ptr)
 destroy_canvas = _bind("Splat_DestroyCanvas", [POINTER(Splat_Canvas)], c_int, _validate_int)
+attach_canvas = _bind("Splat_AttachCanvas", [POINTER(Splat_Canvas), POINTER(SDL_Window), c_int, c_int], c_int, _validate_int)
+
+create_shader = _bind("Splat_CreateShader", [c_char_p, c_int], POINTER(Splat_Shader), _validate_ptr)
+destroy_shader = _bind("Splat_DestroyShader", [POINTER(Splat_Shader)], c_int, _validate_int)
+create_program = _bind("Splat_CreateProgram", None, POINTER(Splat_Program), _validate_ptr)
+destroy_program = _bind("Splat_DestroyProgram", [POINTER(Splat_Program)], c_int, _validate_int)
+attach_shader = _bind("Splat_AttachShader", [POINTER(Splat_Program), POINTER(Splat_Shader)], c_int, _validate_int)
+link_program = _bind("Splat_LinkProgram", [POINTER(Splat_Program)], c_int, _validate_int)
+set_shader_cache_directory = _bind("Splat_SetShaderCacheDirectory", [c_char_p], c_int, _validate_int)
+set_canvas_program = _bind("Splat_SetCanvasProgram", [POINTER(Splat_Canvas), POINTER(Splat_Program)], c_int, _validate_int)
+_set_canvas_programs = _bind("Splat_SetCanvasPrograms", [POINTER(Splat_Canvas), POINTER(POINTER(Splat_Program)), c_int], c_int, _validate_int)
 
 draw_rect = _bind("Splat_DrawRect", [POINTER(Splat_Canvas), POINTER(SDL_Rect), POINTER(SDL_Color), c_int, c_int, c_int], c_int, _validate_int)
 draw_line = _bind("Splat_DrawLine", [POINTER(Splat_Canvas), POINTER(SDL_Point), POINTER(SDL_Point), POINTER(SDL_Color), c_int, c_int, c_int], c_int, _validate_int)
@@ -130,9 +291,174 @@ def get_scale(canvas):
 	_get_scale(canvas, byref(x), byref(y))
 	return x.value, y.value
 
+def get_render_size(canvas):
+	width = c_int()
+	height = c_int()
+	_get_render_size(canvas, byref(width), byref(height))
+	return width.value, height.value
+
 def get_image_size(image):
 	x = c_uint32()
 	y = c_uint32()
 	_get_image_size(image, byref(x), byref(y))
 	return x.value, y.value
 
+def _address(handle):
+	"""Returns the address of a native handle or a ctypes pointer."""
+	if _splatgl is not None and hasattr(handle, "address"):
+		return handle.address
+	return cast(handle, c_void_p).value or 0
+
+def _pointer(handle):
+	"""Returns a handle as a ctypes pointer, for building ctypes arrays."""
+	return getattr(handle, "_as_parameter_", handle)
+
+def _wrap(pointer, kind):
+	"""Returns a ctypes pointer from the library as a native handle when the extension is loaded."""
+	if _splatgl is None or not pointer:
+		return pointer
+	return getattr(_splatgl, kind)(cast(pointer, c_void_p).value)
+
+# Keep reload callbacks alive for as long as they are registered
+_reload_callbacks = {}
+
+def set_image_reload_callback(image, callback):
+	"""Sets a callable taking the image and returning an SDL_Surface pointer, or None to remove it."""
+	key = _address(image)
+	if callback is None:
+		_set_image_reload_callback(image, ReloadCallback(), None)
+		_reload_callbacks.pop(key, None)
+	else:
+		func = ReloadCallback(lambda img, userdata: callback(_wrap(img, "Image")))
+		_set_image_reload_callback(image, func, None)
+		_reload_callbacks[key] = func
+
+def create_animation(image, frames):
+	"""Creates an animation from a sequence of (s1, t1, s2, t2, duration) tuples."""
+	table = (AnimationFrame * len(frames))(*[AnimationFrame(*frame) for frame in frames])
+	return _wrap(_create_animation(image, table, len(frames)), "Animation")
+
+_late_latch_callbacks = {}
+
+def set_late_latch_callback(canvas, callback):
+	"""Sets a callable taking the canvas, run just before it renders, or None to remove it."""
+	key = _address(canvas)
+	if callback is None:
+		_set_late_latch_callback(canvas, LateLatchCallback(), None)
+		_late_latch_callbacks.pop(key, None)
+	else:
+		func = LateLatchCallback(lambda c, userdata: callback(_wrap(c, "Canvas")))
+		_set_late_latch_callback(canvas, func, None)
+		_late_latch_callbacks[key] = func
+
+_capture_callbacks = {}
+
+def start_capture(canvas, callback):
+	"""Sets a callable taking (pixels, width, height, pitch, format, frame); pixels is only valid during the call."""
+	func = CaptureCallback(lambda c, pixels, width, height, pitch, fmt, frame, userdata: callback(pixels, width, height, pitch, fmt, frame))
+	_start_capture(canvas, func, None)
+	_capture_callbacks[_address(canvas)] = func
+
+def stop_capture(canvas):
+	_stop_capture(canvas)
+	_capture_callbacks.pop(_address(canvas), None)
+
+def set_canvas_programs(canvas, programs):
+	"""Sets the post-process chain of a canvas from a sequence of linked programs."""
+	array = (POINTER(Splat_Program) * len(programs))(*map(_pointer, programs))
+	return _set_canvas_programs(canvas, array, len(programs))
+
+def render_canvases(canvases, viewports=None):
+	"""Renders canvases, bottom to top, into one frame.  viewports is an optional sequence of SDL_Rects.
+
+	With the native extension the GIL is released while rendering, so other threads must not create or destroy Splat objects until it returns."""
+	rects = None if viewports is None else (SDL_Rect * len(viewports))(*viewports)
+	if _splatgl is not None:
+		return _splatgl._render_canvases(canvases, rects)
+	array = (POINTER(Splat_Canvas) * len(canvases))(*map(_pointer, canvases))
+	return _render_canvases(array, len(canvases), rects)
+
+def get_texture_stats():
+	stats = TextureStats()
+	_get_texture_stats(byref(stats))
+	return stats
+
+def get_memory_stats():
+	stats = MemoryStats()
+	_get_memory_stats(byref(stats))
+	return stats
+
+def get_frame_stats(canvas):
+	stats = FrameStats()
+	_get_frame_stats(canvas, byref(stats))
+	return stats
+
+def get_layer_gpu_time(layer):
+	"""Returns the latest GPU milliseconds spent drawing a layer of a profiled canvas."""
+	ms = c_float()
+	_get_layer_gpu_time(layer, byref(ms))
+	return ms.value
+
+def _buffer(obj, formats, itemsize, width):
+	"""Returns the address and row count of a C-contiguous buffer of rows of width items, copying only read-only buffers."""
+	view = memoryview(obj)
+	if not view.c_contiguous:
+		raise ValueError("buffer must be C-contiguous")
+	if view.itemsize != itemsize or view.format.lstrip("@=<") not in formats:
+		raise TypeError("buffer has format {!r}, expected one of {!r}".format(view.format, formats))
+	if view.nbytes % (itemsize * width) != 0:
+		raise ValueError("buffer length is not a multiple of {}".format(width))
+	count = view.nbytes // (itemsize * width)
+	if count == 0:
+		return None, 0
+	interface = getattr(obj, "__array_interface__", None)
+	if interface is not None:
+		return interface["data"][0], count
+	view = view.cast("B")
+	if view.readonly:
+		data = (c_char * view.nbytes).from_buffer_copy(view)
+	else:
+		data = (c_char * view.nbytes).from_buffer(view)
+	# The array keeps the buffer alive and exported until the call returns
+	return data, count
+
+def _bulk(func, instances, values, formats, width):
+	handles, count = _buffer(instances, ("Q", "q", "L", "l") if sizeof(c_void_p) == 8 else ("I", "i", "L", "l"), sizeof(c_void_p), 1)
+	data, rows = _buffer(values, formats, 4, width)
+	if rows != count:
+		raise ValueError("{} instances but {} rows of values".format(count, rows))
+	return func(handles, data, count) if count else 0
+
+def instance_handles(instances):
+	"""Returns an array of instance addresses usable by the bulk setters, built once and reused across frames."""
+	return array("Q" if sizeof(c_void_p) == 8 else "I", map(_address, instances))
+
+def set_instances_position(instances, positions):
+	"""Moves many instances; instances is a buffer of handles, positions a buffer of int32 x, y pairs such as an (n, 2) NumPy array."""
+	return _bulk(_set_instances_position, instances, positions, ("i", "l"), 2)
+
+def set_instances_flags(instances, flags):
+	"""Sets the flags of many instances from a buffer of uint32."""
+	return _bulk(_set_instances_flags, instances, flags, ("I", "L"), 1)
+
+def set_instances_texcoords(instances, texcoords):
+	"""Sets the subimage of many instances from a buffer of float32 s1, t1, s2, t2 quadruples."""
+	return _bulk(_set_instances_texcoords, instances, texcoords, ("f",), 4)
+
+_pointer_types = {
+	"Image": POINTER(Splat_Image),
+	"Layer": POINTER(Splat_Layer),
+	"Instance": POINTER(Splat_Instance),
+	"Canvas": POINTER(Splat_Canvas),
+	"Animation": POINTER(Splat_Animation),
+	"Shader": POINTER(Splat_Shader),
+	"Program": POINTER(Splat_Program),
+}
+
+# Replace the ctypes bindings the extension implements, keeping wrappers that add Python-side behaviour
+if _splatgl is not None:
+	_splatgl._init(error, lambda handle: cast(c_void_p(handle.address), _pointer_types[type(handle).__name__]))
+	for _name in dir(_splatgl):
+		if not _name.startswith("_"):
+			globals()[_name] = getattr(_splatgl, _name)
+	del _name
@@ -0,0 +1,1283 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+/*
+ * Native binding for the hot paths of the splatgl package.  Every
+ * function here parses its arguments in C and raises splatgl.error
+ * directly, and Splat objects are typed handles rather than ctypes
+ * pointers.  Handles expose _as_parameter_ so the ctypes bindings in
+ * __init__.py accept them, and functions here accept ctypes pointers,
+ * so both halves of the package can be mixed freely.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#include "splat.h"
+
+typedef struct {
+  PyObject_HEAD
+  void *pointer; // Cleared when the object is destroyed
+  uintptr_t key; // Address the handle was created with, for equality and hashing
+} Handle;
+
+/* splatgl.error, and the callable turning a handle into a ctypes pointer */
+static PyObject *errorType = NULL;
+static PyObject *toCtypes = NULL;
+
+static PyObject *RaiseError() {
+  const char *message = Splat_GetError();
+  PyErr_SetString(errorType ? errorType : PyExc_RuntimeError, message ? message : "Undefined Splat error");
+  return NULL;
+}
+
+/* Returns 0 for a successful call, as the ctypes bindings do */
+static PyObject *Result(int result) {
+  if (result != 0) {
+    return RaiseError();
+  }
+
+  return PyLong_FromLong(0);
+}
+
+/* Handle types */
+
+static PyObject *HandleNew(PyTypeObject *type, PyObject *args, PyObject *kwargs) {
+  unsigned long long address;
+  if (!PyArg_ParseTuple(args, "K", &address)) {
+    return NULL;
+  }
+
+  Handle *handle = (Handle *) type->tp_alloc(type, 0);
+  if (handle) {
+    handle->pointer = (void *) (uintptr_t) address;
+    handle->key = (uintptr_t) address;
+  }
+  return (PyObject *) handle;
+}
+
+static PyObject *HandleRepr(Handle *handle) {
+  if (!handle->pointer) {
+    return PyUnicode_FromFormat("<%s (destroyed)>", Py_TYPE(handle)->tp_name);
+  }
+
+  return PyUnicode_FromFormat("<%s %p>", Py_TYPE(handle)->tp_name, handle->pointer);
+}
+
+/* Hashing and equality use the creation address, so they hold while a destroyed handle sits in a dict */
+static Py_hash_t HandleHash(Handle *handle) {
+  // Objects are at least 16-byte aligned, and -1 is reserved for errors
+  const Py_hash_t hash = (Py_hash_t) (handle->key >> 4);
+  return hash == -1 ? -2 : hash;
+}
+
+static PyObject *HandleCompare(PyObject *a, PyObject *b, int op) {
+  if ((op != Py_EQ && op != Py_NE) || Py_TYPE(a) != Py_TYPE(b)) {
+    Py_RETURN_NOTIMPLEMENTED;
+  }
+
+  const int equal = ((Handle *) a)->key == ((Handle *) b)->key;
+  return PyBool_FromLong(op == Py_EQ ? equal : !equal);
+}
+
+static int HandleBool(Handle *handle) {
+  return handle->pointer != NULL;
+}
+
+static PyObject *HandleAddress(Handle *handle, void *closure) {
+  return PyLong_FromVoidPtr(handle->pointer);
+}
+
+static PyObject *HandleAsParameter(Handle *handle, void *closure) {
+  if (!toCtypes) {
+    PyErr_SetString(PyExc_RuntimeError, "splatgl._splatgl is not initialized");
+    return NULL;
+  }
+
+  return PyObject_CallFunctionObjArgs(toCtypes, (PyObject *) handle, NULL);
+}
+
+static PyGetSetDef handleGetSet[] = {
+  { "address", (getter) HandleAddress, NULL, "Address of the Splat object, or 0 once destroyed.", NULL },
+  { "_as_parameter_", (getter) HandleAsParameter, NULL, "The handle as a ctypes pointer.", NULL },
+  { NULL }
+};
+
+static PyNumberMethods handleNumber = {
+  .nb_bool = (inquiry) HandleBool,
+};
+
+#define HANDLE_TYPE(name, doc) {                          \
+    PyVarObject_HEAD_INIT(NULL, 0)                        \
+    .tp_name = "splatgl." name,                           \
+    .tp_basicsize = sizeof(Handle),                       \
+    .tp_flags = Py_TPFLAGS_DEFAULT,                       \
+    .tp_doc = doc,                                        \
+    .tp_new = HandleNew,                                  \
+    .tp_repr = (reprfunc) HandleRepr,                     \
+    .tp_hash = (hashfunc) HandleHash,                     \
+    .tp_richcompare = HandleCompare,                      \
+    .tp_as_number = &handleNumber,                        \
+    .tp_getset = handleGetSet,                            \
+  }
+
+static PyTypeObject ImageType = HANDLE_TYPE("Image", "Handle to a Splat_Image.");
+static PyTypeObject LayerType = HANDLE_TYPE("Layer", "Handle to a Splat_Layer.");
+static PyTypeObject InstanceType = HANDLE_TYPE("Instance", "Handle to a Splat_Instance.");
+static PyTypeObject CanvasType = HANDLE_TYPE("Canvas", "Handle to a Splat_Canvas.");
+static PyTypeObject AnimationType = HANDLE_TYPE("Animation", "Handle to a Splat_Animation.");
+static PyTypeObject ShaderType = HANDLE_TYPE("Shader", "Handle to a Splat_Shader.");
+static PyTypeObject ProgramType = HANDLE_TYPE("Program", "Handle to a Splat_Program.");
+
+static PyTypeObject *handleTypes[] = {
+  &ImageType, &LayerType, &InstanceType, &CanvasType, &AnimationType, &ShaderType, &ProgramType
+};
+
+static PyObject *NewHandle(PyTypeObject *type, void *pointer) {
+  if (!pointer) {
+    return RaiseError();
+  }
+
+  Handle *handle = PyObject_New(Handle, type);
+  if (handle) {
+    handle->pointer = pointer;
+    handle->key = (uintptr_t) pointer;
+  }
+  return (PyObject *) handle;
+}
+
+/* Clears a handle once its object is destroyed, so later use raises instead of crashing */
+static void ReleaseHandle(PyObject *obj, PyTypeObject *type) {
+  if (Py_TYPE(obj) == type) {
+    ((Handle *) obj)->pointer = NULL;
+  }
+}
+
+/* Argument conversion */
+
+static int CheckArgs(const char *name, Py_ssize_t nargs, Py_ssize_t min, Py_ssize_t max) {
+  if (nargs < min || nargs > max) {
+    if (min == max) {
+      PyErr_Format(PyExc_TypeError, "%s() takes %zd arguments (%zd given)", name, min, nargs);
+    } else {
+      PyErr_Format(PyExc_TypeError, "%s() takes %zd to %zd arguments (%zd given)", name, min, max, nargs);
+    }
+    return -1;
+  }
+
+  return 0;
+}
+
+/* Accepts a handle of the given type, a ctypes pointer or None */
+static int ArgPointer(PyObject *obj, PyTypeObject *type, void **pointer) {
+  if (Py_TYPE(obj) == type) {
+    *pointer = ((Handle *) obj)->pointer;
+    if (!*pointer) {
+      PyErr_Format(PyExc_ValueError, "%s has been destroyed", type->tp_name);
+      return -1;
+    }
+    return 0;
+  }
+
+  if (obj == Py_None) {
+    *pointer = NULL;
+    return 0;
+  }
+
+  for (size_t i = 0; i < sizeof(handleTypes) / sizeof(handleTypes[0]); i++) {
+    if (Py_TYPE(obj) == handleTypes[i]) {
+      PyErr_Format(PyExc_TypeError, "expected %s, got %s", type->tp_name, Py_TYPE(obj)->tp_name);
+      return -1;
+    }
+  }
+
+  // A ctypes pointer exports the pointer itself, with a format beginning with '&'
+  Py_buffer view;
+  if (PyObject_GetBuffer(obj, &view, PyBUF_FORMAT) == 0) {
+    const int ok = view.len == sizeof(void *) && view.format && view.format[0] == '&';
+    if (ok) {
+      memcpy(pointer, view.buf, sizeof(void *));
+    }
+    PyBuffer_Release(&view);
+    if (ok) {
+      return 0;
+    }
+  }
+
+  PyErr_Clear();
+  PyErr_Format(PyExc_TypeError, "expected %s, got %s", type->tp_name, Py_TYPE(obj)->tp_name);
+  return -1;
+}
+
+static int ArgInt(PyObject *obj, int *value) {
+  const long result = PyLong_AsLong(obj);
+  if (result == -1 && PyErr_Occurred()) {
+    return -1;
+  }
+
+  if (result < INT_MIN || result > INT_MAX) {
+    PyErr_SetString(PyExc_OverflowError, "argument does not fit in an int");
+    return -1;
+  }
+
+  *value = (int) result;
+  return 0;
+}
+
+static int ArgUint32(PyObject *obj, uint32_t *value) {
+  const unsigned long result = PyLong_AsUnsignedLong(obj);
+  if (result == (unsigned long) -1 && PyErr_Occurred()) {
+    return -1;
+  }
+
+  if (result > UINT32_MAX) {
+    PyErr_SetString(PyExc_OverflowError, "argument does not fit in 32 bits");
+    return -1;
+  }
+
+  *value = (uint32_t) result;
+  return 0;
+}
+
+static int ArgFloat(PyObject *obj, float *value) {
+  const double result = PyFloat_AsDouble(obj);
+  if (result == -1.0 && PyErr_Occurred()) {
+    return -1;
+  }
+
+  *value = (float) result;
+  return 0;
+}
+
+/* Accepts bytes, str or None, as c_char_p does */
+static int ArgString(PyObject *obj, const char **value) {
+  if (obj == Py_None) {
+    *value = NULL;
+  } else if (PyBytes_Check(obj)) {
+    *value = PyBytes_AS_STRING(obj);
+  } else {
+    *value = PyUnicode_AsUTF8(obj);
+  }
+
+  return *value || obj == Py_None ? 0 : -1;
+}
+
+/* Accepts a buffer, an address or None; release the view with ReleaseData() */
+static int ArgData(PyObject *obj, int writable, Py_buffer *view, void **data) {
+  view->obj = NULL;
+  if (obj == Py_None) {
+    *data = NULL;
+    return 0;
+  }
+
+  if (PyLong_Check(obj)) {
+    *data = PyLong_AsVoidPtr(obj);
+    return PyErr_Occurred() ? -1 : 0;
+  }
+
+  if (PyObject_GetBuffer(obj, view, writable ? PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS : PyBUF_C_CONTIGUOUS) != 0) {
+    return -1;
+  }
+
+  *data = view->buf;
+  return 0;
+}
+
+static void ReleaseData(Py_buffer *view) {
+  if (view->obj) {
+    PyBuffer_Release(view);
+  }
+}
+
+/* Fails if a buffer from ArgData() holds fewer than pitch * height bytes; bare addresses are trusted */
+static int CheckDataSize(Py_buffer *view, int pitch, int height) {
+  if (view->obj && pitch > 0 && height > 0 && view->len < (Py_ssize_t) pitch * height) {
+    PyErr_Format(PyExc_ValueError, "buffer holds %zd bytes, but %zd are needed", view->len, (Py_ssize_t) pitch * height);
+    ReleaseData(view);
+    return -1;
+  }
+
+  return 0;
+}
+
+/* Gets a C-contiguous buffer of rows of width items of one of the formats, returning the row count */
+static Py_ssize_t ArgRows(PyObject *obj, Py_buffer *view, const char *formats, Py_ssize_t itemsize, Py_ssize_t width) {
+  if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+    return -1;
+  }
+
+  const char *format = view->format ? view->format : "B";
+  while (*format == '@' || *format == '=' || *format == '<') {
+    format++;
+  }
+
+  if (view->itemsize != itemsize || strlen(format) != 1 || !strchr(formats, format[0])) {
+    PyErr_Format(PyExc_TypeError, "buffer has format '%s', expected one of '%s'", view->format, formats);
+    PyBuffer_Release(view);
+    return -1;
+  }
+
+  if (view->len % (itemsize * width) != 0) {
+    PyErr_Format(PyExc_ValueError, "buffer length is not a multiple of %zd", width);
+    PyBuffer_Release(view);
+    return -1;
+  }
+
+  return view->len / (itemsize * width);
+}
+
+/* Library */
+
+static PyObject *Prepare(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *window;
+  int width, height;
+  if (CheckArgs("prepare", nargs, 3, 3) != 0 ||
+      ArgPointer(args[0], &PyBaseObject_Type, &window) != 0 ||
+      ArgInt(args[1], &width) != 0 ||
+      ArgInt(args[2], &height) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_Prepare(window, width, height));
+}
+
+static PyObject *PrepareOffscreen(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  int width, height;
+  if (CheckArgs("prepare_offscreen", nargs, 2, 2) != 0 ||
+      ArgInt(args[0], &width) != 0 ||
+      ArgInt(args[1], &height) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_PrepareOffscreen(width, height));
+}
+
+static PyObject *Finish(PyObject *self, PyObject *unused) {
+  Splat_Finish();
+  Py_RETURN_NONE;
+}
+
+/* Images */
+
+static PyObject *CreateImage(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *surface;
+  if (CheckArgs("create_image", nargs, 1, 1) != 0 ||
+      ArgPointer(args[0], &PyBaseObject_Type, &surface) != 0) {
+    return NULL;
+  }
+
+  return NewHandle(&ImageType, Splat_CreateImage(surface));
+}
+
+static PyObject *CreateImageWithFlags(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *surface;
+  uint32_t flags;
+  if (CheckArgs("create_image_with_flags", nargs, 2, 2) != 0 ||
+      ArgPointer(args[0], &PyBaseObject_Type, &surface) != 0 ||
+      ArgUint32(args[1], &flags) != 0) {
+    return NULL;
+  }
+
+  return NewHandle(&ImageType, Splat_CreateImageWithFlags(surface, flags));
+}
+
+static PyObject *CreateImageFromPixels(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  Py_buffer view;
+  void *pixels;
+  int width, height, pitch;
+  uint32_t format;
+  if (CheckArgs("create_image_from_pixels", nargs, 5, 5) != 0 ||
+      ArgInt(args[1], &width) != 0 ||
+      ArgInt(args[2], &height) != 0 ||
+      ArgInt(args[3], &pitch) != 0 ||
+      ArgUint32(args[4], &format) != 0 ||
+      ArgData(args[0], 0, &view, &pixels) != 0 ||
+      CheckDataSize(&view, pitch, height) != 0) {
+    return NULL;
+  }
+
+  Splat_Image *image = Splat_CreateImageFromPixels(pixels, width, height, pitch, format);
+  ReleaseData(&view);
+  return NewHandle(&ImageType, image);
+}
+
+static PyObject *CreateTargetImage(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  int width, height;
+  if (CheckArgs("create_target_image", nargs, 2, 2) != 0 ||
+      ArgInt(args[0], &width) != 0 ||
+      ArgInt(args[1], &height) != 0) {
+    return NULL;
+  }
+
+  return NewHandle(&ImageType, Splat_CreateTargetImage(width, height));
+}
+
+static PyObject *UpdateImage(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *image, *surface;
+  if (CheckArgs("update_image", nargs, 2, 2) != 0 ||
+      ArgPointer(args[0], &ImageType, &image) != 0 ||
+      ArgPointer(args[1], &PyBaseObject_Type, &surface) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_UpdateImage(image, surface));
+}
+
+static PyObject *UpdateImageFromPixels(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  Py_buffer view;
+  void *image, *pixels;
+  int width, height, pitch;
+  uint32_t format;
+  if (CheckArgs("update_image_from_pixels", nargs, 6, 6) != 0 ||
+      ArgPointer(args[0], &ImageType, &image) != 0 ||
+      ArgInt(args[2], &width) != 0 ||
+      ArgInt(args[3], &height) != 0 ||
+      ArgInt(args[4], &pitch) != 0 ||
+      ArgUint32(args[5], &format) != 0 ||
+      ArgData(args[1], 0, &view, &pixels) != 0 ||
+      CheckDataSize(&view, pitch, height) != 0) {
+    return NULL;
+  }
+
+  const int result = Splat_UpdateImageFromPixels(image, pixels, width, height, pitch, format);
+  ReleaseData(&view);
+  return Result(result);
+}
+
+static PyObject *DestroyImage(PyObject *self, PyObject *image) {
+  void *pointer;
+  if (ArgPointer(image, &ImageType, &pointer) != 0) {
+    return NULL;
+  }
+
+  if (Splat_DestroyImage(pointer) != 0) {
+    return RaiseError();
+  }
+
+  ReleaseHandle(image, &ImageType);
+  return PyLong_FromLong(0);
+}
+
+static PyObject *SetImageRetained(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *image;
+  int retain;
+  if (CheckArgs("set_image_retained", nargs, 2, 2) != 0 ||
+      ArgPointer(args[0], &ImageType, &image) != 0 ||
+      ArgInt(args[1], &retain) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetImageRetained(image, retain));
+}
+
+static PyObject *SetDefaultImageFlags(PyObject *self, PyObject *arg) {
+  uint32_t flags;
+  if (ArgUint32(arg, &flags) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetDefaultImageFlags(flags));
+}
+
+static PyObject *SetImageTileSize(PyObject *self, PyObject *arg) {
+  uint32_t size;
+  if (ArgUint32(arg, &size) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetImageTileSize(size));
+}
+
+static PyObject *SetTileReleaseDelay(PyObject *self, PyObject *arg) {
+  uint32_t frames;
+  if (ArgUint32(arg, &frames) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetTileReleaseDelay(frames));
+}
+
+static PyObject *SetTextureBudget(PyObject *self, PyObject *arg) {
+  const unsigned long long bytes = PyLong_AsUnsignedLongLong(arg);
+  if (bytes == (unsigned long long) -1 && PyErr_Occurred()) {
+    return NULL;
+  }
+
+  return Result(Splat_SetTextureBudget(bytes));
+}
+
+/* Diagnostics */
+
+static PyObject *StartTrace(PyObject *self, PyObject *arg) {
+  const char *path;
+  if (ArgString(arg, &path) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_StartTrace(path));
+}
+
+static PyObject *StopTrace(PyObject *self, PyObject *unused) {
+  return Result(Splat_StopTrace());
+}
+
+static PyObject *StartGLCapture(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  const char *path;
+  int frames;
+  if (CheckArgs("start_gl_capture", nargs, 2, 2) != 0 ||
+      ArgString(args[0], &path) != 0 ||
+      ArgInt(args[1], &frames) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_StartGLCapture(path, frames));
+}
+
+static PyObject *StopGLCapture(PyObject *self, PyObject *unused) {
+  return Result(Splat_StopGLCapture());
+}
+
+static PyObject *SetGpuProfiling(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *canvas;
+  int enable;
+  if (CheckArgs("set_gpu_profiling", nargs, 2, 2) != 0 ||
+      ArgPointer(args[0], &CanvasType, &canvas) != 0 ||
+      ArgInt(args[1], &enable) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetGpuProfiling(canvas, enable));
+}
+
+/* Layers */
+
+static PyObject *CreateLayer(PyObject *self, PyObject *canvas) {
+  void *pointer;
+  if (ArgPointer(canvas, &CanvasType, &pointer) != 0) {
+    return NULL;
+  }
+
+  return NewHandle(&LayerType, Splat_CreateLayer(pointer));
+}
+
+static PyObject *DestroyLayer(PyObject *self, PyObject *layer) {
+  void *pointer;
+  if (ArgPointer(layer, &LayerType, &pointer) != 0) {
+    return NULL;
+  }
+
+  if (Splat_DestroyLayer(pointer) != 0) {
+    return RaiseError();
+  }
+
+  ReleaseHandle(layer, &LayerType);
+  return PyLong_FromLong(0);
+}
+
+static PyObject *MoveLayer(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *layer, *other = NULL;
+  if (CheckArgs("move_layer", nargs, 1, 2) != 0 ||
+      ArgPointer(args[0], &LayerType, &layer) != 0 ||
+      (nargs > 1 && ArgPointer(args[1], &LayerType, &other) != 0)) {
+    return NULL;
+  }
+
+  return Result(Splat_MoveLayer(layer, other));
+}
+
+/* Instances */
+
+static PyObject *CreateInstance(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *image, *layer;
+  int x, y;
+  float s1, t1, s2, t2;
+  uint32_t flags;
+  if (CheckArgs("create_instance", nargs, 9, 9) != 0 ||
+      ArgPointer(args[0], &ImageType, &image) != 0 ||
+      ArgPointer(args[1], &LayerType, &layer) != 0 ||
+      ArgInt(args[2], &x) != 0 ||
+      ArgInt(args[3], &y) != 0 ||
+      ArgFloat(args[4], &s1) != 0 ||
+      ArgFloat(args[5], &t1) != 0 ||
+      ArgFloat(args[6], &s2) != 0 ||
+      ArgFloat(args[7], &t2) != 0 ||
+      ArgUint32(args[8], &flags) != 0) {
+    return NULL;
+  }
+
+  return NewHandle(&InstanceType, Splat_CreateInstance(image, layer, x, y, s1, t1, s2, t2, flags));
+}
+
+static PyObject *DestroyInstance(PyObject *self, PyObject *instance) {
+  void *pointer;
+  if (ArgPointer(instance, &InstanceType, &pointer) != 0) {
+    return NULL;
+  }
+
+  if (Splat_DestroyInstance(pointer) != 0) {
+    return RaiseError();
+  }
+
+  ReleaseHandle(instance, &InstanceType);
+  return PyLong_FromLong(0);
+}
+
+static PyObject *SetInstancePosition(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *instance;
+  int x, y;
+  if (CheckArgs("set_instance_position", nargs, 3, 3) != 0 ||
+      ArgPointer(args[0], &InstanceType, &instance) != 0 ||
+      ArgInt(args[1], &x) != 0 ||
+      ArgInt(args[2], &y) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetInstancePosition(instance, x, y));
+}
+
+static PyObject *SetInstanceLayer(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *instance, *layer;
+  if (CheckArgs("set_instance_layer", nargs, 2, 2) != 0 ||
+      ArgPointer(args[0], &InstanceType, &instance) != 0 ||
+      ArgPointer(args[1], &LayerType, &layer) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetInstanceLayer(instance, layer));
+}
+
+static PyObject *SetInstanceImage(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *instance, *image;
+  float s1, t1, s2, t2;
+  if (CheckArgs("set_instance_image", nargs, 6, 6) != 0 ||
+      ArgPointer(args[0], &InstanceType, &instance) != 0 ||
+      ArgPointer(args[1], &ImageType, &image) != 0 ||
+      ArgFloat(args[2], &s1) != 0 ||
+      ArgFloat(args[3], &t1) != 0 ||
+      ArgFloat(args[4], &s2) != 0 ||
+      ArgFloat(args[5], &t2) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetInstanceImage(instance, image, s1, t1, s2, t2));
+}
+
+static PyObject *SetInstanceFlags(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *instance;
+  uint32_t flags;
+  if (CheckArgs("set_instance_flags", nargs, 2, 2) != 0 ||
+      ArgPointer(args[0], &InstanceType, &instance) != 0 ||
+      ArgUint32(args[1], &flags) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetInstanceFlags(instance, flags));
+}
+
+static PyObject *SetInstanceAngle(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *instance;
+  float angle;
+  if (CheckArgs("set_instance_angle", nargs, 2, 2) != 0 ||
+      ArgPointer(args[0], &InstanceType, &instance) != 0 ||
+      ArgFloat(args[1], &angle) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetInstanceAngle(instance, angle));
+}
+
+/* Gets an array of instance pointers from a buffer of addresses, or from a sequence of handles into storage */
+static Py_ssize_t ArgInstances(PyObject *obj, Py_buffer *view, Splat_Instance ***instances) {
+  view->obj = NULL;
+  if (PyObject_CheckBuffer(obj)) {
+    const Py_ssize_t count = ArgRows(obj, view, sizeof(void *) == 8 ? "QqLl" : "IiLl", sizeof(void *), 1);
+    *instances = view->buf;
+    return count;
+  }
+
+  PyObject *sequence = PySequence_Fast(obj, "instances must be a buffer of addresses or a sequence of Instance handles");
+  if (!sequence) {
+    return -1;
+  }
+
+  const Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+  Splat_Instance **array = PyMem_Malloc((count ? count : 1) * sizeof(Splat_Instance *));
+  if (!array) {
+    Py_DECREF(sequence);
+    PyErr_NoMemory();
+    return -1;
+  }
+
+  for (Py_ssize_t i = 0; i < count; i++) {
+    if (ArgPointer(PySequence_Fast_GET_ITEM(sequence, i), &InstanceType, (void **) &array[i]) != 0) {
+      PyMem_Free(array);
+      Py_DECREF(sequence);
+      return -1;
+    }
+  }
+
+  Py_DECREF(sequence);
+  *instances = array;
+  return count;
+}
+
+static void ReleaseInstances(Py_buffer *view, Splat_Instance **instances) {
+  if (view->obj) {
+    PyBuffer_Release(view);
+  } else {
+    PyMem_Free(instances);
+  }
+}
+
+typedef int (*BulkSetter)(Splat_Instance **instances, const void *values, int count);
+
+static int SetPositions(Splat_Instance **instances, const void *values, int count) {
+  return Splat_SetInstancesPosition(instances, values, count);
+}
+
+static int SetFlags(Splat_Instance **instances, const void *values, int count) {
+  return Splat_SetInstancesFlags(instances, values, count);
+}
+
+static int SetTexCoords(Splat_Instance **instances, const void *values, int count) {
+  return Splat_SetInstancesTexCoords(instances, values, count);
+}
+
+/* Applies one of the bulk setters to instances and a buffer of rows of width items */
+static PyObject *SetInstances(const char *name, PyObject *const *args, Py_ssize_t nargs,
+                              const char *formats, Py_ssize_t width, BulkSetter set) {
+  if (CheckArgs(name, nargs, 2, 2) != 0) {
+    return NULL;
+  }
+
+  Py_buffer instancesView, valuesView;
+  Splat_Instance **instances;
+  const Py_ssize_t count = ArgInstances(args[0], &instancesView, &instances);
+  if (count < 0) {
+    return NULL;
+  }
+
+  const Py_ssize_t rows = ArgRows(args[1], &valuesView, formats, 4, width);
+  if (rows < 0) {
+    ReleaseInstances(&instancesView, instances);
+    return NULL;
+  }
+
+  int result = 0;
+  if (rows != count) {
+    PyErr_Format(PyExc_ValueError, "%zd instances but %zd rows of values", count, rows);
+  } else if (count > INT_MAX) {
+    PyErr_SetString(PyExc_OverflowError, "too many instances");
+  } else if (count > 0) {
+    result = set(instances, valuesView.buf, (int) count);
+  }
+
+  PyBuffer_Release(&valuesView);
+  ReleaseInstances(&instancesView, instances);
+  return PyErr_Occurred() ? NULL : Result(result);
+}
+
+static PyObject *SetInstancesPosition(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  return SetInstances("set_instances_position", args, nargs, "il", 2, SetPositions);
+}
+
+static PyObject *SetInstancesFlags(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  return SetInstances("set_instances_flags", args, nargs, "IL", 1, SetFlags);
+}
+
+static PyObject *SetInstancesTexCoords(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  return SetInstances("set_instances_texcoords", args, nargs, "f", 4, SetTexCoords);
+}
+
+static PyObject *SetThreadedUpdates(PyObject *self, PyObject *arg) {
+  int enable;
+  if (ArgInt(arg, &enable) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetThreadedUpdates(enable));
+}
+
+static PyObject *SetThreadQueue(PyObject *self, PyObject *arg) {
+  int index;
+  if (ArgInt(arg, &index) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetThreadQueue(index));
+}
+
+static PyObject *ReleaseThreadQueue(PyObject *self, PyObject *unused) {
+  return Result(Splat_ReleaseThreadQueue());
+}
+
+/* Animations */
+
+static PyObject *DestroyAnimation(PyObject *self, PyObject *animation) {
+  void *pointer;
+  if (ArgPointer(animation, &AnimationType, &pointer) != 0) {
+    return NULL;
+  }
+
+  if (Splat_DestroyAnimation(pointer) != 0) {
+    return RaiseError();
+  }
+
+  ReleaseHandle(animation, &AnimationType);
+  return PyLong_FromLong(0);
+}
+
+static PyObject *PlayAnimation(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *instance, *animation;
+  int loop;
+  if (CheckArgs("play_animation", nargs, 3, 3) != 0 ||
+      ArgPointer(args[0], &InstanceType, &instance) != 0 ||
+      ArgPointer(args[1], &AnimationType, &animation) != 0 ||
+      ArgInt(args[2], &loop) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_PlayAnimation(instance, animation, loop));
+}
+
+static PyObject *StopAnimation(PyObject *self, PyObject *instance) {
+  void *pointer;
+  if (ArgPointer(instance, &InstanceType, &pointer) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_StopAnimation(pointer));
+}
+
+/* Canvases */
+
+static PyObject *CreateCanvas(PyObject *self, PyObject *unused) {
+  return NewHandle(&CanvasType, Splat_CreateCanvas());
+}
+
+static PyObject *DestroyCanvas(PyObject *self, PyObject *canvas) {
+  void *pointer;
+  if (ArgPointer(canvas, &CanvasType, &pointer) != 0) {
+    return NULL;
+  }
+
+  if (Splat_DestroyCanvas(pointer) != 0) {
+    return RaiseError();
+  }
+
+  ReleaseHandle(canvas, &CanvasType);
+  return PyLong_FromLong(0);
+}
+
+static PyObject *AttachCanvas(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *canvas, *window;
+  int width, height;
+  if (CheckArgs("attach_canvas", nargs, 4, 4) != 0 ||
+      ArgPointer(args[0], &CanvasType, &canvas) != 0 ||
+      ArgPointer(args[1], &PyBaseObject_Type, &window) != 0 ||
+      ArgInt(args[2], &width) != 0 ||
+      ArgInt(args[3], &height) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_AttachCanvas(canvas, window, width, height));
+}
+
+static PyObject *SetClearColor(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *canvas;
+  float r, g, b, a;
+  if (CheckArgs("set_clear_color", nargs, 5, 5) != 0 ||
+      ArgPointer(args[0], &CanvasType, &canvas) != 0 ||
+      ArgFloat(args[1], &r) != 0 ||
+      ArgFloat(args[2], &g) != 0 ||
+      ArgFloat(args[3], &b) != 0 ||
+      ArgFloat(args[4], &a) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetClearColor(canvas, r, g, b, a));
+}
+
+static PyObject *SetScale(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *canvas;
+  float x, y;
+  if (CheckArgs("set_scale", nargs, 3, 3) != 0 ||
+      ArgPointer(args[0], &CanvasType, &canvas) != 0 ||
+      ArgFloat(args[1], &x) != 0 ||
+      ArgFloat(args[2], &y) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetScale(canvas, x, y));
+}
+
+static PyObject *SetDynamicResolution(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *canvas;
+  float target, minScale, maxScale;
+  if (CheckArgs("set_dynamic_resolution", nargs, 4, 4) != 0 ||
+      ArgPointer(args[0], &CanvasType, &canvas) != 0 ||
+      ArgFloat(args[1], &target) != 0 ||
+      ArgFloat(args[2], &minScale) != 0 ||
+      ArgFloat(args[3], &maxScale) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetDynamicResolution(canvas, target, minScale, maxScale));
+}
+
+/*
+ * Rendering runs without the GIL so other Python threads, and callbacks
+ * through ctypes, can proceed.  Only the instance setters may be called
+ * from other threads meanwhile, and only with Splat_SetThreadedUpdates()
+ * enabled; creating or destroying objects during a render is not safe.
+ */
+
+static PyObject *Render(PyObject *self, PyObject *canvas) {
+  void *pointer;
+  if (ArgPointer(canvas, &CanvasType, &pointer) != 0) {
+    return NULL;
+  }
+
+  int result;
+  Py_BEGIN_ALLOW_THREADS
+  result = Splat_Render(pointer);
+  Py_END_ALLOW_THREADS
+
+  return Result(result);
+}
+
+static PyObject *RenderCanvases(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  if (CheckArgs("_render_canvases", nargs, 1, 2) != 0) {
+    return NULL;
+  }
+
+  PyObject *sequence = PySequence_Fast(args[0], "canvases must be a sequence");
+  if (!sequence) {
+    return NULL;
+  }
+
+  const Py_ssize_t count = PySequence_Fast_GET_SIZE(sequence);
+  Splat_Canvas **canvases = PyMem_Malloc((count ? count : 1) * sizeof(Splat_Canvas *));
+  if (!canvases) {
+    Py_DECREF(sequence);
+    return PyErr_NoMemory();
+  }
+
+  for (Py_ssize_t i = 0; i < count; i++) {
+    if (ArgPointer(PySequence_Fast_GET_ITEM(sequence, i), &CanvasType, (void **) &canvases[i]) != 0) {
+      PyMem_Free(canvases);
+      Py_DECREF(sequence);
+      return NULL;
+    }
+  }
+  Py_DECREF(sequence);
+
+  // Viewports are a buffer of count SDL_Rects, such as a ctypes array
+  Py_buffer view;
+  void *viewports = NULL;
+  if (nargs > 1 && ArgData(args[1], 0, &view, &viewports) != 0) {
+    PyMem_Free(canvases);
+    return NULL;
+  }
+
+  if (nargs > 1 && view.obj && view.len < count * (Py_ssize_t) sizeof(SDL_Rect)) {
+    PyErr_SetString(PyExc_ValueError, "viewports must hold an SDL_Rect per canvas");
+    ReleaseData(&view);
+    PyMem_Free(canvases);
+    return NULL;
+  }
+
+  int result;
+  Py_BEGIN_ALLOW_THREADS
+  result = Splat_RenderCanvases(canvases, (int) count, viewports);
+  Py_END_ALLOW_THREADS
+
+  if (nargs > 1) {
+    ReleaseData(&view);
+  }
+  PyMem_Free(canvases);
+  return Result(result);
+}
+
+static PyObject *RenderToImage(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *canvas, *image;
+  uint32_t interval;
+  if (CheckArgs("render_to_image", nargs, 3, 3) != 0 ||
+      ArgPointer(args[0], &CanvasType, &canvas) != 0 ||
+      ArgPointer(args[1], &ImageType, &image) != 0 ||
+      ArgUint32(args[2], &interval) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_RenderToImage(canvas, image, interval));
+}
+
+static PyObject *ReadPixels(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  Py_buffer view;
+  void *canvas, *pixels;
+  int pitch, width, height;
+  if (CheckArgs("read_pixels", nargs, 3, 3) != 0 ||
+      ArgPointer(args[0], &CanvasType, &canvas) != 0 ||
+      ArgInt(args[2], &pitch) != 0) {
+    return NULL;
+  }
+
+  if (Splat_GetRenderSize(canvas, &width, &height) != 0) {
+    return RaiseError();
+  }
+
+  if (ArgData(args[1], 1, &view, &pixels) != 0 ||
+      CheckDataSize(&view, pitch, height) != 0) {
+    return NULL;
+  }
+
+  int result;
+  Py_BEGIN_ALLOW_THREADS
+  result = Splat_ReadPixels(canvas, pixels, pitch);
+  Py_END_ALLOW_THREADS
+
+  ReleaseData(&view);
+  return Result(result);
+}
+
+static PyObject *SetPresentMode(PyObject *self, PyObject *arg) {
+  int mode;
+  if (ArgInt(arg, &mode) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetPresentMode(mode));
+}
+
+static PyObject *SetMaxFramesInFlight(PyObject *self, PyObject *arg) {
+  int frames;
+  if (ArgInt(arg, &frames) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetMaxFramesInFlight(frames));
+}
+
+/* Shaders */
+
+static PyObject *CreateShader(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  const char *source;
+  int shaderType;
+  if (CheckArgs("create_shader", nargs, 2, 2) != 0 ||
+      ArgString(args[0], &source) != 0 ||
+      ArgInt(args[1], &shaderType) != 0) {
+    return NULL;
+  }
+
+  return NewHandle(&ShaderType, Splat_CreateShader(source, shaderType));
+}
+
+static PyObject *DestroyShader(PyObject *self, PyObject *shader) {
+  void *pointer;
+  if (ArgPointer(shader, &ShaderType, &pointer) != 0) {
+    return NULL;
+  }
+
+  if (Splat_DestroyShader(pointer) != 0) {
+    return RaiseError();
+  }
+
+  ReleaseHandle(shader, &ShaderType);
+  return PyLong_FromLong(0);
+}
+
+static PyObject *CreateProgram(PyObject *self, PyObject *unused) {
+  return NewHandle(&ProgramType, Splat_CreateProgram());
+}
+
+static PyObject *DestroyProgram(PyObject *self, PyObject *program) {
+  void *pointer;
+  if (ArgPointer(program, &ProgramType, &pointer) != 0) {
+    return NULL;
+  }
+
+  if (Splat_DestroyProgram(pointer) != 0) {
+    return RaiseError();
+  }
+
+  ReleaseHandle(program, &ProgramType);
+  return PyLong_FromLong(0);
+}
+
+static PyObject *AttachShader(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *program, *shader;
+  if (CheckArgs("attach_shader", nargs, 2, 2) != 0 ||
+      ArgPointer(args[0], &ProgramType, &program) != 0 ||
+      ArgPointer(args[1], &ShaderType, &shader) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_AttachShader(program, shader));
+}
+
+static PyObject *LinkProgram(PyObject *self, PyObject *program) {
+  void *pointer;
+  if (ArgPointer(program, &ProgramType, &pointer) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_LinkProgram(pointer));
+}
+
+static PyObject *SetShaderCacheDirectory(PyObject *self, PyObject *arg) {
+  const char *path;
+  if (ArgString(arg, &path) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetShaderCacheDirectory(path));
+}
+
+static PyObject *SetCanvasProgram(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  void *canvas, *program;
+  if (CheckArgs("set_canvas_program", nargs, 2, 2) != 0 ||
+      ArgPointer(args[0], &CanvasType, &canvas) != 0 ||
+      ArgPointer(args[1], &ProgramType, &program) != 0) {
+    return NULL;
+  }
+
+  return Result(Splat_SetCanvasProgram(canvas, program));
+}
+
+/* Module */
+
+static PyObject *Init(PyObject *self, PyObject *const *args, Py_ssize_t nargs) {
+  if (CheckArgs("_init", nargs, 2, 2) != 0) {
+    return NULL;
+  }
+
+  Py_INCREF(args[0]);
+  Py_XSETREF(errorType, args[0]);
+  Py_INCREF(args[1]);
+  Py_XSETREF(toCtypes, args[1]);
+  Py_RETURN_NONE;
+}
+
+#define FAST(name, func) { name, (PyCFunction) (void (*)(void)) func, METH_FASTCALL, NULL }
+#define ONE(name, func) { name, (PyCFunction) func, METH_O, NULL }
+#define NONE(name, func) { name, (PyCFunction) func, METH_NOARGS, NULL }
+
+static PyMethodDef methods[] = {
+  FAST("_init", Init),
+  FAST("prepare", Prepare),
+  FAST("prepare_offscreen", PrepareOffscreen),
+  NONE("finish", Finish),
+  FAST("create_image", CreateImage),
+  FAST("create_image_with_flags", CreateImageWithFlags),
+  FAST("create_image_from_pixels", CreateImageFromPixels),
+  FAST("create_target_image", CreateTargetImage),
+  FAST("update_image", UpdateImage),
+  FAST("update_image_from_pixels", UpdateImageFromPixels),
+  ONE("destroy_image", DestroyImage),
+  FAST("set_image_retained", SetImageRetained),
+  ONE("set_default_image_flags", SetDefaultImageFlags),
+  ONE("set_image_tile_size", SetImageTileSize),
+  ONE("set_tile_release_delay", SetTileReleaseDelay),
+  ONE("set_texture_budget", SetTextureBudget),
+  ONE("start_trace", StartTrace),
+  NONE("stop_trace", StopTrace),
+  FAST("start_gl_capture", StartGLCapture),
+  NONE("stop_gl_capture", StopGLCapture),
+  FAST("set_gpu_profiling", SetGpuProfiling),
+  ONE("create_layer", CreateLayer),
+  ONE("destroy_layer", DestroyLayer),
+  FAST("move_layer", MoveLayer),
+  FAST("create_instance", CreateInstance),
+  ONE("destroy_instance", DestroyInstance),
+  FAST("set_instance_position", SetInstancePosition),
+  FAST("set_instance_layer", SetInstanceLayer),
+  FAST("set_instance_image", SetInstanceImage),
+  FAST("set_instance_flags", SetInstanceFlags),
+  FAST("set_instance_angle", SetInstanceAngle),
+  FAST("set_instances_position", SetInstancesPosition),
+  FAST("set_instances_flags", SetInstancesFlags),
+  FAST("set_instances_texcoords", SetInstancesTexCoords),
+  ONE("set_threaded_updates", SetThreadedUpdates),
+  ONE("set_thread_queue", SetThreadQueue),
+  NONE("release_thread_queue", ReleaseThreadQueue),
+  ONE("destroy_animation", DestroyAnimation),
+  FAST("play_animation", PlayAnimation),
+  ONE("stop_animation", StopAnimation),
+  NONE("create_canvas", CreateCanvas),
+  ONE("destroy_canvas", DestroyCanvas),
+  FAST("attach_canvas", AttachCanvas),
+  FAST("set_clear_color", SetClearColor),
+  FAST("set_scale", SetScale),
+  FAST("set_dynamic_resolution", SetDynamicResolution),
+  { "render", (PyCFunction) Render, METH_O, "Renders a canvas with the GIL released.  Other threads must not create or destroy Splat objects until it returns." },
+  { "_render_canvases", (PyCFunction) (void (*)(void)) RenderCanvases, METH_FASTCALL, "Renders canvases with the GIL released, as render() does." },
+  FAST("render_to_image", RenderToImage),
+  FAST("read_pixels", ReadPixels),
+  ONE("set_present_mode", SetPresentMode),
+  ONE("set_max_frames_in_flight", SetMaxFramesInFlight),
+  FAST("create_shader", CreateShader),
+  ONE("destroy_shader", DestroyShader),
+  NONE("create_program", CreateProgram),
+  ONE("destroy_program", DestroyProgram),
+  FAST("attach_shader", AttachShader),
+  ONE("link_program", LinkProgram),
+  ONE("set_shader_cache_directory", SetShaderCacheDirectory),
+  FAST("set_canvas_program", SetCanvasProgram),
+  { NULL }
+};
+
+static struct PyModuleDef module = {
+  PyModuleDef_HEAD_INIT,
+  .m_name = "splatgl._splatgl",
+  .m_doc = "Native binding for the hot paths of the Splat Graphics Library.",
+  .m_size = -1,
+  .m_methods = methods,
+};
+
+PyMODINIT_FUNC PyInit__splatgl() {
+  PyObject *m = PyModule_Create(&module);
+  if (!m) {
+    return NULL;
+  }
+
+  for (size_t i = 0; i < sizeof(handleTypes) / sizeof(handleTypes[0]); i++) {
+    PyTypeObject *type = handleTypes[i];
+    if (PyType_Ready(type) != 0) {
+      Py_DECREF(m);
+      return NULL;
+    }
+
+    Py_INCREF(type);
+    if (PyModule_AddObject(m, strchr(type->tp_name, '.') + 1, (PyObject *) type) != 0) {
+      Py_DECREF(type);
+      Py_DECREF(m);
+      return NULL;
+    }
+  }
+
+  return m;
+}
@@ -0,0 +1,192 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <math.h>
+#include <SDL.h>
+#include "splat.h"
+#include "types.h"
+#include "animation.h"
+#include "canvas.h"
+#include "image.h"
+#include "memory.h"
+#include "queue.h"
+
+Splat_Animation *Splat_CreateAnimation(Splat_Image *image, const Splat_AnimationFrame *frames, int count) {
+  if (!image || !frames || count <= 0) {
+    Splat_SetError("Splat_CreateAnimation:  Invalid argument.");
+    return NULL;
+  }
+
+  // Allocate the animation and its frame table in one block
+  Splat_Animation *animation = MemoryAlloc(SPLAT_MEMORY_IMAGE, sizeof(Splat_Animation) + count * (sizeof(Splat_AnimationFrame) + sizeof(uint32_t)));
+  if (!animation) {
+    Splat_SetError("Splat_CreateAnimation:  Allocation failed.");
+    return NULL;
+  }
+
+  animation->image = image;
+  animation->count = count;
+  animation->frames = (Splat_AnimationFrame *) (animation + 1);
+  animation->ends = (uint32_t *) (animation->frames + count);
+  memcpy(animation->frames, frames, count * sizeof(Splat_AnimationFrame));
+
+  // Precompute when each frame ends, so frame lookup is a binary search
+  uint32_t time = 0;
+  for (int i = 0; i < count; i++) {
+    time += SDL_max(frames[i].duration, 1);
+    animation->ends[i] = time;
+  }
+  animation->duration = time;
+
+  // Place new animation at the top of the image's list.
+  animation->next = image->animations;
+  image->animations = animation;
+
+  return animation;
+}
+
+/* Stops every instance playing the animation, leaving it on its current frame */
+static void ForgetAnimation(const Splat_Animation *animation) {
+  for (Splat_Canvas *canvas = CanvasFirst(); canvas != NULL; canvas = canvas->next) {
+    for (Splat_Layer *layer = canvas->layers; layer != NULL; layer = layer->next) {
+      for (Splat_Instance *instance = layer->instances; instance != NULL; instance = instance->next) {
+        if (instance->animation == animation) {
+          instance->animation = NULL;
+        }
+      }
+    }
+  }
+}
+
+int Splat_DestroyAnimation(Splat_Animation *animation) {
+  if (!animation) {
+    Splat_SetError("Splat_DestroyAnimation:  Invalid argument.");
+    return -1;
+  }
+
+  Splat_Image *image = animation->image;
+  for (Splat_Animation *prev = NULL, *curr = image->animations; curr != NULL; prev = curr, curr = curr->next) {
+    if (curr == animation) {
+      if (prev) {
+        prev->next = curr->next;
+      } else {
+        image->animations = curr->next;
+      }
+
+      QueuePurge(animation);
+      ForgetAnimation(animation);
+      MemoryFree(animation);
+      return 0;
+    }
+  }
+
+  Splat_SetError("Splat_DestroyAnimation:  Animation not found.");
+  return -1;
+}
+
+void AnimationDestroyAll(Splat_Image *image) {
+  while (image->animations) {
+    Splat_Animation *next = image->animations->next;
+    QueuePurge(image->animations);
+    ForgetAnimation(image->animations);
+    MemoryFree(image->animations);
+    image->animations = next;
+  }
+}
+
+/* Shows the given frame of the instance's animation */
+static void SetFrame(Splat_Instance *instance, int frame) {
+  const Splat_AnimationFrame *f = &instance->animation->frames[frame];
+  Splat_Image *image = instance->animation->image;
+
+  instance->animationFrame = frame;
+  instance->s1 = f->s1;
+  instance->t1 = f->t1;
+  instance->s2 = f->s2;
+  instance->t2 = f->t2;
+  instance->rect.w = roundf(image->width * (f->s2 - f->s1));
+  instance->rect.h = roundf(image->height * (f->t2 - f->t1));
+}
+
+void AnimateInstance(Splat_Instance *instance, uint32_t time) {
+  const Splat_Animation *animation = instance->animation;
+  uint32_t elapsed = time - instance->animationStart;
+
+  if (elapsed >= animation->duration) {
+    if (instance->animationLoop) {
+      elapsed %= animation->duration;
+    } else {
+      elapsed = animation->duration - 1;
+    }
+  }
+
+  // Find the first frame ending after the elapsed time
+  int low = 0, high = animation->count - 1;
+  while (low < high) {
+    const int mid = (low + high) / 2;
+    if (animation->ends[mid] <= elapsed) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  // Only touch the instance when its frame actually changes
+  if (low != instance->animationFrame) {
+    SetFrame(instance, low);
+  }
+}
+
+int Splat_PlayAnimation(Splat_Instance *instance, Splat_Animation *animation, int loop) {
+  if (!instance || !animation) {
+    Splat_SetError("Splat_PlayAnimation:  Invalid argument.");
+    return -1;
+  }
+
+  if (QueueDeferred()) {
+    const Command command = { COMMAND_PLAY_ANIMATION, instance, { .play = { animation, loop } } };
+    return QueueCommand(&command);
+  }
+
+  ImageAttach(instance, animation->image);
+  instance->animation = animation;
+  instance->animationStart = SDL_GetTicks();
+  instance->animationLoop = loop != 0;
+  SetFrame(instance, 0);
+
+  return 0;
+}
+
+int Splat_StopAnimation(Splat_Instance *instance) {
+  if (!instance) {
+    Splat_SetError("Splat_StopAnimation:  Invalid argument.");
+    return -1;
+  }
+
+  if (QueueDeferred()) {
+    const Command command = { COMMAND_STOP_ANIMATION, instance, { .flags = 0 } };
+    return QueueCommand(&command);
+  }
+
+  instance->animation = NULL;
+  return 0;
+}
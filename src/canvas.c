@@ -20,26 +20,391 @@
   3. This notice may not be removed or altered from any source distribution.
 */
 
+#define GL_GLEXT_PROTOTYPES
 #include <math.h>
 #include <SDL_opengl.h>
 #include "splat.h"
 #include "canvas.h"
+#include "capture.h"
+#include "glcapture.h"
+#include "glrecord.h"
+#include "memory.h"
+#include "offscreen.h"
+#include "timer.h"
+
+extern SDL_GLContext window_glcontext;
 
 static Splat_Canvas *canvases = NULL;
 
+static inline float clamp(float value, float lower, float upper) {
+  return fminf(upper, fmaxf(lower, value));
+}
+
 void CanvasFinish() {
   while (canvases) {
     Splat_DestroyCanvas(canvases);
   }
 }
 
-static inline float clamp(float value, float lower, float upper) {
-  return fminf(upper, fmaxf(lower, value));
+Splat_Canvas *CanvasFirst() {
+  return canvases;
+}
+
+uint64_t CanvasGpuBytes() {
+  uint64_t bytes = 0;
+  for (Splat_Canvas *curr = canvases; curr != NULL; curr = curr->next) {
+    if (curr->frameTexture) {
+      bytes += (uint64_t) curr->viewportWidth * curr->viewportHeight * 4;
+    }
+    bytes += CaptureGpuBytes(curr);
+  }
+  return bytes;
+}
+
+void CanvasCaptureState() {
+  for (Splat_Canvas *curr = canvases; curr != NULL; curr = curr->next) {
+    if (curr->framebuffer) {
+      // Target canvases draw into their image's texture rather than one of their own
+      GLCaptureFramebuffer(curr->framebuffer, curr->target ? curr->target->texture->name : curr->frameTexture);
+    }
+  }
+}
+
+/* Releases the canvas' framebuffer */
+static void DetachCanvas(Splat_Canvas *canvas) {
+  if (canvas->framebuffer) {
+    glDeleteFramebuffers(1, &canvas->framebuffer);
+    canvas->framebuffer = 0;
+  }
+
+  if (canvas->frameTexture) {
+    glDeleteTextures(1, &canvas->frameTexture);
+    canvas->frameTexture = 0;
+  }
+
+  canvas->window = NULL;
+  canvas->target = NULL;
+}
+
+/* Creates the framebuffer the canvas is rendered into, drawing into texture if given */
+static int AttachFramebuffer(Splat_Canvas *canvas, SDL_Window *window, int viewportWidth, int viewportHeight, GLuint texture) {
+  DetachCanvas(canvas);
+
+  /* Create the frame buffer for rendering to texture*/
+  glGenFramebuffers(1, &canvas->framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, canvas->framebuffer);
+
+  /* Set up the texture to which we're going to render */
+  if (!texture) {
+    glGenTextures(1, &canvas->frameTexture);
+    glBindTexture(GL_TEXTURE_2D, canvas->frameTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, viewportWidth, viewportHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0); // Alpha for compositing
+    // There are no mipmaps, so the default minification filter would leave the texture incomplete
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    texture = canvas->frameTexture;
+  }
+
+  /* Configure the framebuffer texture */
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+  GLenum DrawBuffers[1] = { GL_COLOR_ATTACHMENT0 };
+  glDrawBuffers(1, DrawBuffers);
+
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  if (glGetError() != GL_NO_ERROR || status != GL_FRAMEBUFFER_COMPLETE) {
+    DetachCanvas(canvas);
+    return -1;
+  }
+
+  canvas->window = window;
+  canvas->viewportWidth = viewportWidth;
+  canvas->viewportHeight = viewportHeight;
+  canvas->renderWidth = viewportWidth;
+  canvas->renderHeight = viewportHeight;
+
+  return 0;
+}
+
+int Splat_AttachCanvas(Splat_Canvas *canvas, SDL_Window *window, int viewportWidth, int viewportHeight) {
+  if (!canvas || !window || viewportWidth <= 0 || viewportHeight <= 0) {
+    Splat_SetError("Splat_AttachCanvas:  Invalid argument.");
+    return -1;
+  }
+
+  if (!window_glcontext) {
+    Splat_SetError("Splat_AttachCanvas:  Splat_Prepare has not been called.");
+    return -1;
+  }
+
+  // Every window shares the one context, and so every texture
+  if (SDL_GL_MakeCurrent(window, window_glcontext) != 0) {
+    Splat_SetError("Splat_AttachCanvas:  Unable to render to window.  Check SDL_GetError() for more information.");
+    return -1;
+  }
+
+  if (AttachFramebuffer(canvas, window, viewportWidth, viewportHeight, 0) != 0) {
+    Splat_SetError("Splat_AttachCanvas:  Unable to create framebuffer.");
+    return -1;
+  }
+
+  return 0;
+}
+
+int CanvasAttachOffscreen(Splat_Canvas *canvas, int viewportWidth, int viewportHeight) {
+  if (AttachFramebuffer(canvas, NULL, viewportWidth, viewportHeight, 0) != 0) {
+    Splat_SetError("Splat_Render:  Unable to create framebuffer.");
+    return -1;
+  }
+
+  return 0;
+}
+
+int Splat_RenderToImage(Splat_Canvas *canvas, Splat_Image *image, uint32_t interval) {
+  if (!canvas) {
+    Splat_SetError("Splat_RenderToImage:  Invalid argument.");
+    return -1;
+  }
+
+  if (!image) {
+    DetachCanvas(canvas);
+    return 0;
+  }
+
+  if (!image->target) {
+    Splat_SetError("Splat_RenderToImage:  Image was not created with Splat_CreateTargetImage.");
+    return -1;
+  }
+
+  if (!window_glcontext && !OffscreenActive()) {
+    Splat_SetError("Splat_RenderToImage:  Splat_Prepare has not been called.");
+    return -1;
+  }
+
+  if (AttachFramebuffer(canvas, NULL, image->width, image->height, image->texture->name) != 0) {
+    Splat_SetError("Splat_RenderToImage:  Unable to create framebuffer.");
+    return -1;
+  }
+
+  canvas->target = image;
+  canvas->refreshInterval = interval;
+  canvas->nextRefresh = SDL_GetTicks();
+
+  return 0;
+}
+
+bool CanvasRefreshDue(Splat_Canvas *canvas, uint32_t now) {
+  // Compare through a signed difference so the schedule survives the tick counter wrapping
+  if (!canvas->target || (int32_t) (now - canvas->nextRefresh) < 0) {
+    return false;
+  }
+
+  canvas->nextRefresh = now + canvas->refreshInterval;
+  return true;
+}
+
+void CanvasReleaseTarget(Splat_Image *image) {
+  for (Splat_Canvas *curr = canvases; curr != NULL; curr = curr->next) {
+    if (curr->target == image) {
+      DetachCanvas(curr);
+    }
+  }
+}
+
+int Splat_SetDynamicResolution(Splat_Canvas *canvas, float targetFrameTime, float minScale, float maxScale) {
+  if (!canvas || targetFrameTime < 0.0f || minScale <= 0.0f || maxScale > 1.0f || minScale > maxScale) {
+    Splat_SetError("Splat_SetDynamicResolution:  Invalid argument.");
+    return -1;
+  }
+
+  if (targetFrameTime == 0.0f) {
+    TimerDestroy(canvas->timer);
+    canvas->timer = NULL;
+    canvas->targetFrameTime = 0.0f;
+    canvas->resolutionScale = 1.0f;
+    return 0;
+  }
+
+  if (!canvas->timer && !(canvas->timer = TimerCreate())) {
+    Splat_SetError("Splat_SetDynamicResolution:  GPU timer queries are not supported.");
+    return -1;
+  }
+
+  canvas->targetFrameTime = targetFrameTime;
+  canvas->minResolutionScale = minScale;
+  canvas->maxResolutionScale = maxScale;
+  canvas->resolutionScale = clamp(canvas->resolutionScale, minScale, maxScale);
+
+  return 0;
+}
+
+void CanvasUpdateResolution(Splat_Canvas *canvas) {
+  if (canvas->timer && !canvas->target) {
+    // Use the latest GPU time available; results lag a few frames behind
+    float gpuTime = 0.0f, result;
+    while (TimerResult(canvas->timer, &result)) {
+      gpuTime = result;
+    }
+
+    // GPU time follows the pixel count, so scale each axis by the square root.
+    // Shrink as soon as the frame is over budget, but only grow with clear headroom.
+    if (gpuTime > 0.0f) {
+      const float ratio = canvas->targetFrameTime / gpuTime;
+      if (ratio < 1.0f || ratio > 1.25f) {
+        const float scale = canvas->resolutionScale * sqrtf(ratio);
+        canvas->resolutionScale = clamp(fminf(scale, canvas->resolutionScale + 0.05f),
+                                        canvas->minResolutionScale, canvas->maxResolutionScale);
+      }
+    }
+  }
+
+  const float scale = canvas->target ? 1.0f : canvas->resolutionScale;
+  canvas->renderWidth = SDL_max((int) roundf(canvas->viewportWidth * scale), 1);
+  canvas->renderHeight = SDL_max((int) roundf(canvas->viewportHeight * scale), 1);
+}
+
+/* Replaces the latest time with any newer result from the timer */
+static void CollectTimer(struct GpuTimer *timer, float *ms) {
+  float result;
+  while (timer && TimerResult(timer, &result)) {
+    *ms = result;
+  }
+}
+
+static void StopProfiling(Splat_Canvas *canvas) {
+  for (Splat_Layer *layer = canvas->layers; layer != NULL; layer = layer->next) {
+    TimerDestroy(layer->timer);
+    layer->timer = NULL;
+    layer->gpuTime = 0.0f;
+  }
+
+  TimerDestroy(canvas->debugTimer);
+  TimerDestroy(canvas->blitTimer);
+  canvas->debugTimer = NULL;
+  canvas->blitTimer = NULL;
+  canvas->debugGpuTime = 0.0f;
+  canvas->blitGpuTime = 0.0f;
+  canvas->gpuProfiling = false;
+}
+
+int Splat_SetGpuProfiling(Splat_Canvas *canvas, int enable) {
+  if (!canvas) {
+    Splat_SetError("Splat_SetGpuProfiling:  Invalid argument.");
+    return -1;
+  }
+
+  if (!enable) {
+    StopProfiling(canvas);
+    return 0;
+  }
+
+  if (canvas->gpuProfiling) {
+    return 0;
+  }
+
+  if (!(canvas->debugTimer = TimerCreate()) || !(canvas->blitTimer = TimerCreate())) {
+    StopProfiling(canvas);
+    Splat_SetError("Splat_SetGpuProfiling:  GPU timer queries are not supported.");
+    return -1;
+  }
+
+  // Layer timers are created as each layer is first rendered
+  canvas->gpuProfiling = true;
+  return 0;
+}
+
+void CanvasCollectGpuTimes(Splat_Canvas *canvas) {
+  for (Splat_Layer *layer = canvas->layers; layer != NULL; layer = layer->next) {
+    if (!layer->timer) {
+      layer->timer = TimerCreate();
+    }
+    CollectTimer(layer->timer, &layer->gpuTime);
+  }
+
+  CollectTimer(canvas->debugTimer, &canvas->debugGpuTime);
+  CollectTimer(canvas->blitTimer, &canvas->blitGpuTime);
+}
+
+int Splat_GetLayerGpuTime(Splat_Layer *layer, float *ms) {
+  if (!layer || !ms) {
+    Splat_SetError("Splat_GetLayerGpuTime:  Invalid argument.");
+    return -1;
+  }
+
+  if (!layer->canvas->gpuProfiling) {
+    Splat_SetError("Splat_GetLayerGpuTime:  GPU profiling is not enabled on the canvas.");
+    return -1;
+  }
+
+  *ms = layer->gpuTime;
+  return 0;
+}
+
+int Splat_GetRenderSize(Splat_Canvas *canvas, int *width, int *height) {
+  if (!canvas || !width || !height) {
+    Splat_SetError("Splat_GetRenderSize:  Invalid argument.");
+    return -1;
+  }
+
+  *width = canvas->renderWidth;
+  *height = canvas->renderHeight;
+  return 0;
+}
+
+int Splat_ReadPixels(Splat_Canvas *canvas, void *pixels, int pitch) {
+  if (!canvas || !pixels || pitch < canvas->viewportWidth * 4 || (pitch % 4) != 0) {
+    Splat_SetError("Splat_ReadPixels:  Invalid argument.");
+    return -1;
+  }
+
+  if (!canvas->framebuffer) {
+    Splat_SetError("Splat_ReadPixels:  Canvas has not been rendered.");
+    return -1;
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, canvas->framebuffer);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glPixelStorei(GL_PACK_ROW_LENGTH, pitch / 4);
+  glReadPixels(0, 0, canvas->renderWidth, canvas->renderHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+  glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  if (glGetError() != GL_NO_ERROR) {
+    Splat_SetError("Splat_ReadPixels:  Unable to read framebuffer.");
+    return -1;
+  }
+
+  // Target canvases already store their top row first
+  if (canvas->target) {
+    return 0;
+  }
+
+  // The window framebuffer is stored bottom-up, so flip it in place
+  const size_t rowBytes = canvas->renderWidth * 4;
+  uint8_t *row = MemoryAlloc(SPLAT_MEMORY_OTHER, rowBytes);
+  if (!row) {
+    Splat_SetError("Splat_ReadPixels:  Allocation failed.");
+    return -1;
+  }
+
+  uint8_t *top = pixels;
+  uint8_t *bottom = top + (size_t) (canvas->renderHeight - 1) * pitch;
+  for (/**/; top < bottom; top += pitch, bottom -= pitch) {
+    memcpy(row, top, rowBytes);
+    memcpy(top, bottom, rowBytes);
+    memcpy(bottom, row, rowBytes);
+  }
+
+  MemoryFree(row);
+  return 0;
 }
 
 Splat_Canvas *Splat_CreateCanvas() {
   // Allocate the surface for this context
-  Splat_Canvas *canvas = malloc(sizeof(Splat_Canvas));
+  Splat_Canvas *canvas = PoolAlloc(&canvasPool);
   if (!canvas) {
     Splat_SetError("Splat_CreateCanvas:  Allocation failed.");
     return NULL;
@@ -53,6 +418,7 @@ Splat_Canvas *Splat_CreateCanvas() {
   canvas->clearColor[0] = canvas->clearColor[1] = canvas->clearColor[2] = 0.0f;
   canvas->clearColor[3] = 1.0f;
   canvas->scale[0] = canvas->scale[1] = 1.0f;
+  canvas->resolutionScale = 1.0f;
 
   return canvas;
 }
@@ -71,7 +437,12 @@ int Splat_DestroyCanvas(Splat_Canvas *canvas) {
         canvases = curr->next;
       }
 
-      free(canvas);
+      CaptureFinish(canvas);
+      StopProfiling(canvas);
+      TimerDestroy(canvas->timer);
+      DetachCanvas(canvas);
+      MemoryFree(canvas->programs);
+      PoolFree(&canvasPool, canvas);
       return 0;
     }
   }
@@ -80,7 +451,7 @@ int Splat_DestroyCanvas(Splat_Canvas *canvas) {
   return -1;
 }
 
-int Splat_SetClearColor(Splat_Canvas *canvas, float r, float b, float g, float a) {
+int Splat_SetClearColor(Splat_Canvas *canvas, float r, float g, float b, float a) {
   if (!canvas) {
     Splat_SetError("Splat_SetClearColor:  Invalid canvas.");
     return -1;
@@ -94,6 +465,17 @@ int Splat_SetClearColor(Splat_Canvas *canvas, float r, float b, float g, float a
   return 0;
 }
 
+int Splat_SetLateLatchCallback(Splat_Canvas *canvas, Splat_LateLatchCallback callback, void *userdata) {
+  if (!canvas) {
+    Splat_SetError("Splat_SetLateLatchCallback:  Invalid argument.");
+    return -1;
+  }
+
+  canvas->lateLatch = callback;
+  canvas->lateLatchData = userdata;
+  return 0;
+}
+
 int Splat_GetViewPosition(Splat_Canvas *canvas, SDL_Point *position) {
   if (!canvas || !position) {
     Splat_SetError("Splat_GetViewPosition:  Invalid argument");
@@ -24,12 +24,47 @@
 #define __SPLAT_CANVAS_H__
 
 #include <SDL.h>
+#include <SDL_opengl.h>
 #include "types.h"
 
+#define FRAME_HISTORY 256 // Frame times kept for percentiles
+
 typedef struct Splat_Canvas {
   float clearColor[4];
   SDL_Point origin;
   float scale[2]; // Scale factors for X and Y
+  uint32_t time; // Canvas clock, sampled once at the start of each render
+  SDL_Window *window; // Window the canvas is presented in, NULL if offscreen
+  GLuint framebuffer; // Framebuffer the canvas is rendered into, 0 until attached
+  GLuint frameTexture; // Color attachment of the framebuffer
+  int viewportWidth; // Size of the framebuffer, before upscaling to the window
+  int viewportHeight;
+  int renderWidth; // Part of the framebuffer rendered into, smaller under dynamic resolution
+  int renderHeight;
+  float resolutionScale; // Scale of the render size relative to the viewport
+  float targetFrameTime; // GPU milliseconds per frame dynamic resolution aims for, 0 if off
+  float minResolutionScale;
+  float maxResolutionScale;
+  struct GpuTimer *timer; // Measures GPU time of each render under dynamic resolution
+  bool gpuProfiling; // True if layers, debug primitives and the blit are timed on the GPU
+  struct GpuTimer *debugTimer;
+  struct GpuTimer *blitTimer;
+  float debugGpuTime; // Latest GPU milliseconds of each profiled phase
+  float blitGpuTime;
+  Splat_LateLatchCallback lateLatch; // Called just before the canvas is rendered
+  void *lateLatchData;
+  struct Capture *capture; // Frame capture in progress, or NULL
+  Splat_Image *target; // Image the canvas renders into instead of a window, or NULL
+  uint32_t refreshInterval; // Milliseconds between renders into the target
+  uint32_t nextRefresh; // Tick at which the target is next rendered
+  Splat_Program **programs; // Post-process passes applied when the canvas is drawn to its window
+  int programCount;
+  int programCapacity;
+  Splat_FrameStats stats; // Counters of the last render
+  float frameTimes[FRAME_HISTORY]; // Ring of recent frame times in milliseconds
+  int frameTimeIndex;
+  int frameTimeCount;
+  uint64_t lastFrameEnd; // SDL_GetPerformanceCounter() when the last frame completed
   Splat_Layer *layers;
   Splat_Rect *rects; // List of debug rects
   Splat_Line *lines; // List of debug lines
@@ -38,5 +73,26 @@ typedef struct Splat_Canvas {
 
 void CanvasFinish();
 
+/* Returns the first of all canvases, which are linked through next */
+Splat_Canvas *CanvasFirst();
+
+/* Returns the bytes of the frame textures and capture buffers canvases own */
+uint64_t CanvasGpuBytes();
+
+/* Picks the size to render the canvas at this frame */
+void CanvasUpdateResolution(Splat_Canvas *canvas);
+
+/* Reads back finished GPU profiling results, and starts timing new layers */
+void CanvasCollectGpuTimes(Splat_Canvas *canvas);
+
+/* Returns true if the canvas renders into an image and its interval has passed, scheduling the next render */
+bool CanvasRefreshDue(Splat_Canvas *canvas, uint32_t now);
+
+/* Stops any canvas rendering into the image */
+void CanvasReleaseTarget(Splat_Image *image);
+
+/* Creates the canvas' framebuffer without a window to present it in */
+int CanvasAttachOffscreen(Splat_Canvas *canvas, int viewportWidth, int viewportHeight);
+
 #endif // __SPLAT_CANVAS_H__
 
@@ -0,0 +1,247 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#define GL_GLEXT_PROTOTYPES
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "splat.h"
+#include "canvas.h"
+#include "capture.h"
+#include "memory.h"
+#include "present.h"
+
+/* Number of frames in flight between starting a readback and mapping it */
+#define CAPTURE_DEPTH 3
+
+typedef struct Capture {
+  Splat_CaptureCallback callback;
+  void *userdata;
+  int width; /* Size the buffers hold, the canvas' viewport size */
+  int height;
+  GLuint buffers[CAPTURE_DEPTH]; /* Pixel pack buffers, used as a ring */
+  GLsync fences[CAPTURE_DEPTH]; /* Signalled when the readback into each buffer completes */
+  uint64_t frames[CAPTURE_DEPTH]; /* Frame number held by each buffer */
+  int widths[CAPTURE_DEPTH]; /* Render size of the frame held by each buffer, at most the viewport */
+  int heights[CAPTURE_DEPTH];
+  bool bottomUp[CAPTURE_DEPTH]; /* True if the frame held by each buffer has its last row first */
+  int head; /* Next buffer to read into */
+  int pending; /* Number of buffers awaiting delivery */
+  uint64_t frame;
+} Capture;
+
+/* Maps the oldest pending buffer and hands it to the callback, waiting for it if asked */
+static int DeliverFrame(Splat_Canvas *canvas, bool wait) {
+  Capture *capture = canvas->capture;
+  const int tail = (capture->head + CAPTURE_DEPTH - capture->pending) % CAPTURE_DEPTH;
+
+  // Without sync objects the readback was finished when it was started
+  if (capture->fences[tail]) {
+    const GLenum status = glClientWaitSync(capture->fences[tail], GL_SYNC_FLUSH_COMMANDS_BIT, wait ? GL_TIMEOUT_IGNORED : 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+      return 0;
+    } else if (status == GL_WAIT_FAILED) {
+      Splat_SetError("Splat_Render:  Waiting for a captured frame failed.");
+      return -1;
+    }
+
+    glDeleteSync(capture->fences[tail]);
+    capture->fences[tail] = NULL;
+  }
+  capture->pending--;
+
+  const int width = capture->widths[tail];
+  const int height = capture->heights[tail];
+  const int pitch = width * 4;
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->buffers[tail]);
+  const uint8_t *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr) pitch * height, GL_MAP_READ_BIT);
+  if (!pixels) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    Splat_SetError("Splat_Render:  Unable to map a captured frame.");
+    return -1;
+  }
+
+  // Frames bound for a window are stored bottom-up, so hand out their last row with a negative pitch
+  if (capture->bottomUp[tail]) {
+    capture->callback(canvas, pixels + (size_t) (height - 1) * pitch, width, height, -pitch,
+                      SPLAT_PIXELFORMAT_BGRA32, capture->frames[tail], capture->userdata);
+  } else {
+    capture->callback(canvas, pixels, width, height, pitch,
+                      SPLAT_PIXELFORMAT_BGRA32, capture->frames[tail], capture->userdata);
+  }
+
+  glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  return 1;
+}
+
+/* Delivers every pending frame, then frees the ring */
+static void ReleaseBuffers(Splat_Canvas *canvas) {
+  Capture *capture = canvas->capture;
+
+  while (capture->pending > 0 && DeliverFrame(canvas, true) > 0) {
+    /**/
+  }
+
+  for (int i = 0; i < CAPTURE_DEPTH; i++) {
+    if (capture->fences[i]) {
+      glDeleteSync(capture->fences[i]);
+      capture->fences[i] = NULL;
+    }
+  }
+
+  glDeleteBuffers(CAPTURE_DEPTH, capture->buffers);
+  memset(capture->buffers, 0, sizeof(capture->buffers));
+  capture->pending = 0;
+  capture->head = 0;
+}
+
+/* Allocates a ring of buffers large enough for any render size of the canvas */
+static int AllocateBuffers(Splat_Canvas *canvas) {
+  Capture *capture = canvas->capture;
+
+  capture->width = canvas->viewportWidth;
+  capture->height = canvas->viewportHeight;
+
+  glGenBuffers(CAPTURE_DEPTH, capture->buffers);
+  for (int i = 0; i < CAPTURE_DEPTH; i++) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->buffers[i]);
+    glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr) capture->width * capture->height * 4, NULL, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  if (glGetError() != GL_NO_ERROR) {
+    Splat_SetError("Splat_Render:  Unable to allocate capture buffers.");
+    return -1;
+  }
+
+  return 0;
+}
+
+int CaptureFrame(Splat_Canvas *canvas) {
+  Capture *capture = canvas->capture;
+
+  // Only reattaching at a new viewport size reallocates; dynamic resolution reads a smaller rectangle
+  if (capture->width != canvas->viewportWidth || capture->height != canvas->viewportHeight) {
+    ReleaseBuffers(canvas);
+    if (AllocateBuffers(canvas) != 0) {
+      return -1;
+    }
+  }
+
+  // Hand over whatever has finished, then make room if the ring is full
+  while (capture->pending > 0) {
+    const int delivered = DeliverFrame(canvas, capture->pending == CAPTURE_DEPTH);
+    if (delivered < 0) {
+      return -1;
+    } else if (delivered == 0) {
+      break;
+    }
+  }
+
+  // Start reading this frame into the next buffer; glReadPixels returns without waiting
+  glBindFramebuffer(GL_FRAMEBUFFER, canvas->framebuffer);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->buffers[capture->head]);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, canvas->renderWidth, canvas->renderHeight, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  capture->widths[capture->head] = canvas->renderWidth;
+  capture->heights[capture->head] = canvas->renderHeight;
+  capture->bottomUp[capture->head] = !canvas->target; // Target canvases render without the window Y flip
+  if (PresentSyncSupported()) {
+    capture->fences[capture->head] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  } else {
+    glFinish();
+  }
+  capture->frames[capture->head] = capture->frame++;
+  capture->head = (capture->head + 1) % CAPTURE_DEPTH;
+  capture->pending++;
+
+  if (glGetError() != GL_NO_ERROR) {
+    Splat_SetError("Splat_Render:  Unable to capture frame.");
+    return -1;
+  }
+
+  return 0;
+}
+
+void CaptureFinish(Splat_Canvas *canvas) {
+  if (canvas->capture) {
+    ReleaseBuffers(canvas);
+    MemoryFree(canvas->capture);
+    canvas->capture = NULL;
+  }
+}
+
+uint64_t CaptureGpuBytes(Splat_Canvas *canvas) {
+  Capture *capture = canvas->capture;
+  if (!capture || !capture->buffers[0]) {
+    return 0;
+  }
+  return (uint64_t) CAPTURE_DEPTH * capture->width * capture->height * 4;
+}
+
+int Splat_StartCapture(Splat_Canvas *canvas, Splat_CaptureCallback callback, void *userdata) {
+  if (!canvas || !callback) {
+    Splat_SetError("Splat_StartCapture:  Invalid argument.");
+    return -1;
+  }
+
+  if (!canvas->framebuffer) {
+    Splat_SetError("Splat_StartCapture:  Canvas is not attached.");
+    return -1;
+  }
+
+  CaptureFinish(canvas);
+
+  Capture *capture = MemoryAlloc(SPLAT_MEMORY_CANVAS, sizeof(Capture));
+  if (!capture) {
+    Splat_SetError("Splat_StartCapture:  Allocation failed.");
+    return -1;
+  }
+  memset(capture, 0, sizeof(Capture));
+
+  capture->callback = callback;
+  capture->userdata = userdata;
+  canvas->capture = capture;
+
+  if (AllocateBuffers(canvas) != 0) {
+    Splat_SetError("Splat_StartCapture:  Unable to allocate capture buffers.");
+    glDeleteBuffers(CAPTURE_DEPTH, capture->buffers);
+    MemoryFree(capture);
+    canvas->capture = NULL;
+    return -1;
+  }
+
+  return 0;
+}
+
+int Splat_StopCapture(Splat_Canvas *canvas) {
+  if (!canvas) {
+    Splat_SetError("Splat_StopCapture:  Invalid argument.");
+    return -1;
+  }
+
+  CaptureFinish(canvas);
+  return 0;
+}
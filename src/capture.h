@@ -0,0 +1,37 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_CAPTURE_H__
+#define __SPLAT_CAPTURE_H__
+
+#include "canvas.h"
+
+/* Starts reading back the canvas' latest frame and delivers any frames that have arrived */
+int CaptureFrame(Splat_Canvas *canvas);
+
+/* Delivers outstanding frames and releases the canvas' capture buffers */
+void CaptureFinish(Splat_Canvas *canvas);
+
+/* Returns the bytes of the canvas' capture buffers */
+uint64_t CaptureGpuBytes(Splat_Canvas *canvas);
+
+#endif // __SPLAT_CAPTURE_H__
@@ -0,0 +1,259 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#define GL_GLEXT_PROTOTYPES
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "splat.h"
+#include "compress.h"
+
+/*
+ * Real-time DXT1/DXT5 encoder.  Endpoints are taken from the inset
+ * bounding box of each 4x4 block and every texel picks the closest
+ * palette entry.  The per-block loops work on fixed arrays of 16 texels
+ * so the compiler can vectorize them.
+ */
+
+/* Images with at least this many blocks are compressed on several threads */
+#define THREADED_BLOCKS 4096
+#define MAX_THREADS 8
+
+typedef struct CompressJob {
+  const uint8_t *pixels;
+  int pitch;
+  int bytesPerPixel;
+  int redOffset;
+  int width;
+  int height;
+  int firstRow; /* First row of blocks to compress */
+  int lastRow; /* One past the last row of blocks to compress */
+  uint8_t *blocks;
+} CompressJob;
+
+static int supported = -1;
+
+bool CompressionSupported() {
+  if (supported < 0) {
+    supported = SDL_GL_ExtensionSupported("GL_EXT_texture_compression_s3tc") ? 1 : 0;
+  }
+
+  return supported != 0;
+}
+
+bool IsCompressedFormat(GLint internalFormat) {
+  return internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+GLint CompressedFormat(int bytesPerPixel) {
+  return bytesPerPixel == 4 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+
+int CompressedSize(GLint internalFormat, int width, int height) {
+  const int blockSize = internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 8 : 16;
+  return ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+}
+
+static inline uint16_t To565(const uint8_t *color) {
+  return ((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3);
+}
+
+static inline void From565(uint16_t value, int *color) {
+  color[0] = ((value >> 11) & 0x1F) * 255 / 31;
+  color[1] = ((value >> 5) & 0x3F) * 255 / 63;
+  color[2] = (value & 0x1F) * 255 / 31;
+}
+
+/* Copies a 4x4 block into RGBA order, repeating edge texels for partial blocks */
+static void ExtractBlock(const CompressJob *job, int bx, int by, uint8_t block[16][4]) {
+  for (int y = 0; y < 4; y++) {
+    const int sy = SDL_min(by * 4 + y, job->height - 1);
+    for (int x = 0; x < 4; x++) {
+      const int sx = SDL_min(bx * 4 + x, job->width - 1);
+      const uint8_t *p = job->pixels + sy * job->pitch + sx * job->bytesPerPixel;
+      uint8_t *texel = block[y * 4 + x];
+      texel[0] = p[job->redOffset];
+      texel[1] = p[1];
+      texel[2] = p[2 - job->redOffset];
+      texel[3] = job->bytesPerPixel == 4 ? p[3] : 255;
+    }
+  }
+}
+
+static void EncodeColor(uint8_t block[16][4], uint8_t *out) {
+  uint8_t minColor[3] = { 255, 255, 255 };
+  uint8_t maxColor[3] = { 0, 0, 0 };
+
+  for (int i = 0; i < 16; i++) {
+    for (int c = 0; c < 3; c++) {
+      minColor[c] = SDL_min(minColor[c], block[i][c]);
+      maxColor[c] = SDL_max(maxColor[c], block[i][c]);
+    }
+  }
+
+  // Inset the bounding box to reduce the error of the endpoints
+  for (int c = 0; c < 3; c++) {
+    const int inset = (maxColor[c] - minColor[c]) >> 4;
+    minColor[c] += inset;
+    maxColor[c] -= inset;
+  }
+
+  const uint16_t color0 = To565(maxColor);
+  const uint16_t color1 = To565(minColor);
+
+  int palette[4][3];
+  From565(color0, palette[0]);
+  From565(color1, palette[1]);
+  for (int c = 0; c < 3; c++) {
+    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+  }
+
+  uint32_t indices = 0;
+  if (color0 != color1) {
+    for (int i = 0; i < 16; i++) {
+      int best = 0, bestError = INT32_MAX;
+      for (int p = 0; p < 4; p++) {
+        const int dr = block[i][0] - palette[p][0];
+        const int dg = block[i][1] - palette[p][1];
+        const int db = block[i][2] - palette[p][2];
+        const int error = dr * dr + dg * dg + db * db;
+        if (error < bestError) {
+          best = p;
+          bestError = error;
+        }
+      }
+      indices |= (uint32_t) best << (i * 2);
+    }
+  }
+
+  out[0] = color0 & 0xFF;
+  out[1] = color0 >> 8;
+  out[2] = color1 & 0xFF;
+  out[3] = color1 >> 8;
+  out[4] = indices & 0xFF;
+  out[5] = (indices >> 8) & 0xFF;
+  out[6] = (indices >> 16) & 0xFF;
+  out[7] = indices >> 24;
+}
+
+static void EncodeAlpha(uint8_t block[16][4], uint8_t *out) {
+  uint8_t minAlpha = 255, maxAlpha = 0;
+  for (int i = 0; i < 16; i++) {
+    minAlpha = SDL_min(minAlpha, block[i][3]);
+    maxAlpha = SDL_max(maxAlpha, block[i][3]);
+  }
+
+  // Eight alpha mode, alpha0 > alpha1
+  int palette[8];
+  palette[0] = maxAlpha;
+  palette[1] = minAlpha;
+  for (int p = 1; p < 7; p++) {
+    palette[p + 1] = ((7 - p) * maxAlpha + p * minAlpha) / 7;
+  }
+
+  uint64_t indices = 0;
+  if (maxAlpha != minAlpha) {
+    for (int i = 0; i < 16; i++) {
+      int best = 0, bestError = INT32_MAX;
+      for (int p = 0; p < 8; p++) {
+        const int error = abs(block[i][3] - palette[p]);
+        if (error < bestError) {
+          best = p;
+          bestError = error;
+        }
+      }
+      indices |= ((uint64_t) best) << (i * 3);
+    }
+  }
+
+  out[0] = maxAlpha;
+  out[1] = minAlpha;
+  for (int i = 0; i < 6; i++) {
+    out[2 + i] = (indices >> (i * 8)) & 0xFF;
+  }
+}
+
+static int SDLCALL CompressRows(void *data) {
+  const CompressJob *job = data;
+  const int blocksWide = (job->width + 3) / 4;
+  const int blockSize = job->bytesPerPixel == 4 ? 16 : 8;
+  uint8_t block[16][4];
+
+  for (int by = job->firstRow; by < job->lastRow; by++) {
+    uint8_t *out = job->blocks + by * blocksWide * blockSize;
+    for (int bx = 0; bx < blocksWide; bx++) {
+      ExtractBlock(job, bx, by, block);
+      if (blockSize == 16) {
+        EncodeAlpha(block, out);
+        out += 8;
+      }
+      EncodeColor(block, out);
+      out += 8;
+    }
+  }
+
+  return 0;
+}
+
+int CompressImage(const void *pixels, GLenum format, int bytesPerPixel, int width, int height, int pitch, void *blocks) {
+  const int blocksWide = (width + 3) / 4;
+  const int blocksHigh = (height + 3) / 4;
+
+  CompressJob jobs[MAX_THREADS];
+  SDL_Thread *threads[MAX_THREADS];
+
+  // Large images are split into bands of block rows, one per worker
+  int count = 1;
+  if (blocksWide * blocksHigh >= THREADED_BLOCKS) {
+    count = SDL_max(1, SDL_min(SDL_min(SDL_GetCPUCount(), MAX_THREADS), blocksHigh));
+  }
+
+  for (int i = 0; i < count; i++) {
+    jobs[i].pixels = pixels;
+    jobs[i].pitch = pitch;
+    jobs[i].bytesPerPixel = bytesPerPixel;
+    jobs[i].redOffset = (format == GL_BGR || format == GL_BGRA) ? 2 : 0;
+    jobs[i].width = width;
+    jobs[i].height = height;
+    jobs[i].firstRow = blocksHigh * i / count;
+    jobs[i].lastRow = blocksHigh * (i + 1) / count;
+    jobs[i].blocks = blocks;
+  }
+
+  // The calling thread takes the first band, falling back to it if a worker can't start
+  for (int i = 1; i < count; i++) {
+    threads[i] = SDL_CreateThread(CompressRows, "SplatCompress", &jobs[i]);
+    if (!threads[i]) {
+      CompressRows(&jobs[i]);
+    }
+  }
+
+  CompressRows(&jobs[0]);
+
+  for (int i = 1; i < count; i++) {
+    if (threads[i]) {
+      SDL_WaitThread(threads[i], NULL);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,44 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_COMPRESS_H__
+#define __SPLAT_COMPRESS_H__
+
+#include <stdbool.h>
+#include <SDL_opengl.h>
+
+/* Returns true if the driver can sample S3TC compressed textures */
+bool CompressionSupported();
+
+/* Returns true if the internal format is one produced by CompressImage */
+bool IsCompressedFormat(GLint internalFormat);
+
+/* Returns the compressed format used for pixels with the given bytes per pixel */
+GLint CompressedFormat(int bytesPerPixel);
+
+/* Returns the size in bytes of an image compressed to the given format */
+int CompressedSize(GLint internalFormat, int width, int height);
+
+/* Compresses RGB(A)/BGR(A) pixels to DXT1 (24-bit) or DXT5 (32-bit) blocks */
+int CompressImage(const void *pixels, GLenum format, int bytesPerPixel, int width, int height, int pitch, void *blocks);
+
+#endif // __SPLAT_COMPRESS_H__
@@ -23,6 +23,7 @@
 #include "splat.h"
 #include "types.h"
 #include "canvas.h"
+#include "memory.h"
 
 int Splat_DrawRect(Splat_Canvas *canvas, SDL_Rect *rect, SDL_Color *color, int width, int flags, int ttl) {
   if (!canvas || !rect || !color) {
@@ -31,7 +32,7 @@ int Splat_DrawRect(Splat_Canvas *canvas, SDL_Rect *rect, SDL_Color *color, int w
   }
 
   // Allocate the rect
-  Splat_Rect *r = malloc(sizeof(Splat_Rect));
+  Splat_Rect *r = PoolAlloc(&rectPool);
   if (!r) {
     Splat_SetError("Splat_DrawRect:  Allocation failed.");
     return -1;
@@ -62,7 +63,7 @@ int Splat_DrawLine(Splat_Canvas *canvas, SDL_Point *start, SDL_Point *end, SDL_C
   }
 
   // Allocate the line
-  Splat_Line *line = malloc(sizeof(Splat_Line));
+  Splat_Line *line = PoolAlloc(&linePool);
   if (!line) {
     Splat_SetError("Splat_DrawLine:  Allocation failed.");
     return -1;
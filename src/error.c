@@ -23,32 +23,71 @@
 #include <assert.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <SDL.h>
 #include "splat.h"
 
-static const char *error = NULL;
-static char buffer[256];
+/* Error state of one thread */
+typedef struct ErrorState {
+  const char *error;
+  char buffer[256];
+} ErrorState;
+
+static SDL_SpinLock keyLock = 0;
+static SDL_atomic_t errorKey; // SDL_TLSID of each thread's ErrorState, 0 until first used
+static ErrorState shared = { NULL }; // Used by threads whose state could not be allocated
+
+/* Returns the calling thread's error state, creating it if needed */
+static ErrorState *ThreadError() {
+  SDL_TLSID key = SDL_AtomicGet(&errorKey);
+  if (!key) {
+    SDL_AtomicLock(&keyLock);
+    if (!(key = SDL_AtomicGet(&errorKey))) {
+      key = SDL_TLSCreate();
+      SDL_AtomicSet(&errorKey, key);
+    }
+    SDL_AtomicUnlock(&keyLock);
+
+    if (!key) {
+      return &shared;
+    }
+  }
+
+  ErrorState *state = SDL_TLSGet(key);
+  if (!state) {
+    if (!(state = malloc(sizeof(ErrorState)))) {
+      return &shared;
+    }
+    state->error = NULL;
+    SDL_TLSSet(key, state, free);
+  }
+
+  return state;
+}
 
 const char *Splat_GetError() {
-  if (error) {
-    assert(error == buffer);
-    error = NULL;
-    return buffer;
+  ErrorState *state = ThreadError();
+  if (state->error) {
+    assert(state->error == state->buffer);
+    state->error = NULL;
+    return state->buffer;
   }
 
   return NULL;
 }
 
 void Splat_SetError(const char *errorMsg, ...) {
+  ErrorState *state = ThreadError();
   if (!errorMsg) {
-    error = NULL;
+    state->error = NULL;
     return;
   }
 
   va_list args;
   va_start(args, errorMsg);
-  vsnprintf(buffer, 256, errorMsg, args);
+  vsnprintf(state->buffer, sizeof(state->buffer), errorMsg, args);
   va_end(args);
 
-  error = buffer;
+  state->error = state->buffer;
 }
 
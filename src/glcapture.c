@@ -0,0 +1,584 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#define GL_GLEXT_PROTOTYPES
+#define GLRECORD_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include <GL/glu.h>
+#include "splat.h"
+#include "glcapture.h"
+#include "glformat.h"
+#include "glrecord.h"
+#include "memory.h"
+
+bool glRecording = false;
+
+static FILE *file = NULL;
+static char *filePath = NULL; // Removed if the capture cannot be completed
+static int framesLeft = 0;
+static int frameCount = 0;
+static bool failed = false; // True once a write has failed
+
+// Payload of the record being written
+static uint8_t opcode;
+static uint8_t *payload = NULL;
+static size_t payloadSize = 0;
+static size_t payloadCapacity = 0;
+
+static void Begin(uint8_t op) {
+  opcode = op;
+  payloadSize = 0;
+}
+
+static void Put(const void *data, size_t size) {
+  if (payloadSize + size > payloadCapacity) {
+    size_t capacity = payloadCapacity ? payloadCapacity : 256;
+    while (capacity < payloadSize + size) {
+      capacity *= 2;
+    }
+
+    uint8_t *grown = MemoryRealloc(SPLAT_MEMORY_OTHER, payload, capacity);
+    if (!grown) {
+      failed = true;
+      return;
+    }
+    payload = grown;
+    payloadCapacity = capacity;
+  }
+
+  memcpy(payload + payloadSize, data, size);
+  payloadSize += size;
+}
+
+static void Put32(uint32_t value) {
+  Put(&value, sizeof(value));
+}
+
+static void PutFloat(GLfloat value) {
+  Put(&value, sizeof(value));
+}
+
+static void PutDouble(GLdouble value) {
+  Put(&value, sizeof(value));
+}
+
+static void PutString(const char *string) {
+  const uint32_t length = strlen(string);
+  Put32(length);
+  Put(string, length);
+}
+
+/* Puts a byte count followed by the bytes, or just a count of 0 without data */
+static void PutData(const void *data, uint32_t size) {
+  Put32(data ? size : 0);
+  if (data) {
+    Put(data, size);
+  }
+}
+
+static void End() {
+  if (failed) {
+    return;
+  }
+
+  const uint32_t size = payloadSize;
+  if (fwrite(&opcode, 1, 1, file) != 1 || fwrite(&size, sizeof(size), 1, file) != 1 ||
+      (size && fwrite(payload, size, 1, file) != 1)) {
+    failed = true;
+  }
+}
+
+/* Bytes per pixel of client pixel data */
+static int PixelSize(GLenum format, GLenum type) {
+  switch (type) {
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+      return 2;
+    case GL_UNSIGNED_INT_8_8_8_8:
+    case GL_UNSIGNED_INT_8_8_8_8_REV:
+      return 4;
+  }
+
+  switch (format) {
+    case GL_RGBA:
+    case GL_BGRA:
+      return 4;
+    case GL_RGB:
+    case GL_BGR:
+      return 3;
+    case GL_LUMINANCE_ALPHA:
+      return 2;
+    default:
+      return 1;
+  }
+}
+
+/* Size of the client pixel data an upload reads, following the current unpack state */
+static uint32_t UploadSize(GLsizei width, GLsizei height, GLenum format, GLenum type) {
+  if (width <= 0 || height <= 0) {
+    return 0;
+  }
+
+  GLint alignment, rowLength;
+  glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+  glGetIntegerv(GL_UNPACK_ROW_LENGTH, &rowLength);
+
+  const uint32_t pixelSize = PixelSize(format, type);
+  const uint32_t rowBytes = (rowLength > 0 ? rowLength : width) * pixelSize;
+  const uint32_t pitch = (rowBytes + alignment - 1) / alignment * alignment;
+  return pitch * (height - 1) + width * pixelSize;
+}
+
+static uint32_t TypeSize(GLenum type) {
+  switch (type) {
+    case GL_SHORT:
+      return 2;
+    case GL_DOUBLE:
+      return 8;
+    default:
+      return 4;
+  }
+}
+
+/* Puts the state and contents of a client array used by a draw */
+static void PutClientArray(GLenum array, GLenum sizeQuery, GLenum typeQuery, GLenum strideQuery, GLenum pointerQuery, GLint first, GLsizei count) {
+  const bool enabled = glIsEnabled(array) && count > 0;
+  Put32(enabled);
+  if (!enabled) {
+    return;
+  }
+
+  GLint size, type, stride;
+  GLvoid *pointer;
+  glGetIntegerv(sizeQuery, &size);
+  glGetIntegerv(typeQuery, &type);
+  glGetIntegerv(strideQuery, &stride);
+  glGetPointerv(pointerQuery, &pointer);
+  Put32(size);
+  Put32(type);
+  Put32(stride);
+
+  // Everything from the start of the array up to the last vertex drawn
+  const uint32_t elementSize = size * TypeSize(type);
+  const uint32_t step = stride ? stride : elementSize;
+  PutData(pointer, (first + count - 1) * step + elementSize);
+}
+
+static void PutNames(GLsizei count, const GLuint *names) {
+  Put32(count);
+  Put(names, count * sizeof(GLuint));
+}
+
+void RecordBindFramebuffer(GLenum target, GLuint framebuffer) {
+  Begin(GLOP_BIND_FRAMEBUFFER); Put32(target); Put32(framebuffer); End();
+  glBindFramebuffer(target, framebuffer);
+}
+
+void RecordViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  Begin(GLOP_VIEWPORT); Put32(x); Put32(y); Put32(width); Put32(height); End();
+  glViewport(x, y, width, height);
+}
+
+void RecordMatrixMode(GLenum mode) {
+  Begin(GLOP_MATRIX_MODE); Put32(mode); End();
+  glMatrixMode(mode);
+}
+
+void RecordLoadIdentity() {
+  Begin(GLOP_LOAD_IDENTITY); End();
+  glLoadIdentity();
+}
+
+void RecordOrtho2D(GLdouble left, GLdouble right, GLdouble bottom, GLdouble top) {
+  Begin(GLOP_ORTHO_2D); PutDouble(left); PutDouble(right); PutDouble(bottom); PutDouble(top); End();
+  gluOrtho2D(left, right, bottom, top);
+}
+
+void RecordTranslatef(GLfloat x, GLfloat y, GLfloat z) {
+  Begin(GLOP_TRANSLATEF); PutFloat(x); PutFloat(y); PutFloat(z); End();
+  glTranslatef(x, y, z);
+}
+
+void RecordScalef(GLfloat x, GLfloat y, GLfloat z) {
+  Begin(GLOP_SCALEF); PutFloat(x); PutFloat(y); PutFloat(z); End();
+  glScalef(x, y, z);
+}
+
+void RecordRotatef(GLfloat angle, GLfloat x, GLfloat y, GLfloat z) {
+  Begin(GLOP_ROTATEF); PutFloat(angle); PutFloat(x); PutFloat(y); PutFloat(z); End();
+  glRotatef(angle, x, y, z);
+}
+
+void RecordPushMatrix() {
+  Begin(GLOP_PUSH_MATRIX); End();
+  glPushMatrix();
+}
+
+void RecordPopMatrix() {
+  Begin(GLOP_POP_MATRIX); End();
+  glPopMatrix();
+}
+
+void RecordClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+  Begin(GLOP_CLEAR_COLOR); PutFloat(r); PutFloat(g); PutFloat(b); PutFloat(a); End();
+  glClearColor(r, g, b, a);
+}
+
+void RecordClear(GLbitfield mask) {
+  Begin(GLOP_CLEAR); Put32(mask); End();
+  glClear(mask);
+}
+
+void RecordEnable(GLenum cap) {
+  Begin(GLOP_ENABLE); Put32(cap); End();
+  glEnable(cap);
+}
+
+void RecordDisable(GLenum cap) {
+  Begin(GLOP_DISABLE); Put32(cap); End();
+  glDisable(cap);
+}
+
+void RecordBlendFunc(GLenum sfactor, GLenum dfactor) {
+  Begin(GLOP_BLEND_FUNC); Put32(sfactor); Put32(dfactor); End();
+  glBlendFunc(sfactor, dfactor);
+}
+
+void RecordBlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha) {
+  Begin(GLOP_BLEND_FUNC_SEPARATE); Put32(srcRGB); Put32(dstRGB); Put32(srcAlpha); Put32(dstAlpha); End();
+  glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+}
+
+void RecordTexParameteri(GLenum target, GLenum pname, GLint param) {
+  Begin(GLOP_TEX_PARAMETERI); Put32(target); Put32(pname); Put32(param); End();
+  glTexParameteri(target, pname, param);
+}
+
+void RecordTexParameterf(GLenum target, GLenum pname, GLfloat param) {
+  Begin(GLOP_TEX_PARAMETERF); Put32(target); Put32(pname); PutFloat(param); End();
+  glTexParameterf(target, pname, param);
+}
+
+void RecordEnableClientState(GLenum array) {
+  Begin(GLOP_ENABLE_CLIENT_STATE); Put32(array); End();
+  glEnableClientState(array);
+}
+
+void RecordDisableClientState(GLenum array) {
+  Begin(GLOP_DISABLE_CLIENT_STATE); Put32(array); End();
+  glDisableClientState(array);
+}
+
+void RecordColor4ub(GLubyte r, GLubyte g, GLubyte b, GLubyte a) {
+  const GLubyte color[4] = { r, g, b, a };
+  Begin(GLOP_COLOR4UB); Put(color, sizeof(color)); End();
+  glColor4ub(r, g, b, a);
+}
+
+void RecordScissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+  Begin(GLOP_SCISSOR); Put32(x); Put32(y); Put32(width); Put32(height); End();
+  glScissor(x, y, width, height);
+}
+
+void RecordLineWidth(GLfloat width) {
+  Begin(GLOP_LINE_WIDTH); PutFloat(width); End();
+  glLineWidth(width);
+}
+
+void RecordBindTexture(GLenum target, GLuint texture) {
+  Begin(GLOP_BIND_TEXTURE); Put32(target); Put32(texture); End();
+  glBindTexture(target, texture);
+}
+
+void RecordDrawArrays(GLenum mode, GLint first, GLsizei count) {
+  Begin(GLOP_DRAW_ARRAYS);
+  Put32(mode);
+  Put32(first);
+  Put32(count);
+  PutClientArray(GL_VERTEX_ARRAY, GL_VERTEX_ARRAY_SIZE, GL_VERTEX_ARRAY_TYPE, GL_VERTEX_ARRAY_STRIDE, GL_VERTEX_ARRAY_POINTER, first, count);
+  PutClientArray(GL_TEXTURE_COORD_ARRAY, GL_TEXTURE_COORD_ARRAY_SIZE, GL_TEXTURE_COORD_ARRAY_TYPE, GL_TEXTURE_COORD_ARRAY_STRIDE, GL_TEXTURE_COORD_ARRAY_POINTER, first, count);
+  End();
+  glDrawArrays(mode, first, count);
+}
+
+void RecordUseProgram(GLuint program) {
+  Begin(GLOP_USE_PROGRAM); Put32(program); End();
+  glUseProgram(program);
+}
+
+void RecordUniform1i(GLint location, GLint value) {
+  Begin(GLOP_UNIFORM1I); Put32(location); Put32(value); End();
+  glUniform1i(location, value);
+}
+
+void RecordUniform2f(GLint location, GLfloat x, GLfloat y) {
+  Begin(GLOP_UNIFORM2F); Put32(location); PutFloat(x); PutFloat(y); End();
+  glUniform2f(location, x, y);
+}
+
+void RecordPixelStorei(GLenum pname, GLint param) {
+  Begin(GLOP_PIXEL_STOREI); Put32(pname); Put32(param); End();
+  glPixelStorei(pname, param);
+}
+
+void RecordTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid *data) {
+  Begin(GLOP_TEX_IMAGE_2D);
+  Put32(target);
+  Put32(level);
+  Put32(internalFormat);
+  Put32(width);
+  Put32(height);
+  Put32(border);
+  Put32(format);
+  Put32(type);
+  PutData(data, UploadSize(width, height, format, type));
+  End();
+  glTexImage2D(target, level, internalFormat, width, height, border, format, type, data);
+}
+
+void RecordTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *data) {
+  Begin(GLOP_TEX_SUB_IMAGE_2D);
+  Put32(target);
+  Put32(level);
+  Put32(x);
+  Put32(y);
+  Put32(width);
+  Put32(height);
+  Put32(format);
+  Put32(type);
+  PutData(data, UploadSize(width, height, format, type));
+  End();
+  glTexSubImage2D(target, level, x, y, width, height, format, type, data);
+}
+
+void RecordCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLint border, GLsizei size, const GLvoid *data) {
+  Begin(GLOP_COMPRESSED_TEX_IMAGE_2D);
+  Put32(target);
+  Put32(level);
+  Put32(internalFormat);
+  Put32(width);
+  Put32(height);
+  Put32(border);
+  PutData(data, size);
+  End();
+  glCompressedTexImage2D(target, level, internalFormat, width, height, border, size, data);
+}
+
+void RecordGenTextures(GLsizei count, GLuint *names) {
+  glGenTextures(count, names);
+  Begin(GLOP_GEN_TEXTURES); PutNames(count, names); End();
+}
+
+void RecordDeleteTextures(GLsizei count, const GLuint *names) {
+  Begin(GLOP_DELETE_TEXTURES); PutNames(count, names); End();
+  glDeleteTextures(count, names);
+}
+
+void RecordGenFramebuffers(GLsizei count, GLuint *names) {
+  glGenFramebuffers(count, names);
+  Begin(GLOP_GEN_FRAMEBUFFERS); PutNames(count, names); End();
+}
+
+void RecordDeleteFramebuffers(GLsizei count, const GLuint *names) {
+  Begin(GLOP_DELETE_FRAMEBUFFERS); PutNames(count, names); End();
+  glDeleteFramebuffers(count, names);
+}
+
+void RecordFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
+  Begin(GLOP_FRAMEBUFFER_TEXTURE_2D); Put32(target); Put32(attachment); Put32(textarget); Put32(texture); Put32(level); End();
+  glFramebufferTexture2D(target, attachment, textarget, texture, level);
+}
+
+/* Writes the filters and wrap modes of texture, which the replayer must sample with */
+static void PutSampling(GLuint texture) {
+  GLint bound = 0;
+  glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound);
+  glBindTexture(GL_TEXTURE_2D, texture);
+
+  static const GLenum parameters[] = { GL_TEXTURE_MIN_FILTER, GL_TEXTURE_MAG_FILTER, GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T };
+  for (int i = 0; i < 4; i++) {
+    GLint value = 0;
+    glGetTexParameteriv(GL_TEXTURE_2D, parameters[i], &value);
+    Put32(value);
+  }
+
+  glBindTexture(GL_TEXTURE_2D, bound);
+}
+
+void GLCaptureTexture(GLuint name, int width, int height, GLint internalFormat, GLenum format, GLenum type, const void *data, uint32_t size) {
+  Begin(GLOP_TEXTURE_STATE);
+  Put32(name);
+  Put32(width);
+  Put32(height);
+  Put32(internalFormat);
+  Put32(format);
+  Put32(type);
+  PutSampling(name);
+  PutData(data, size);
+  End();
+}
+
+void GLCaptureFramebuffer(GLuint framebuffer, GLuint texture) {
+  // The attachment's own size, which outlives viewport and resolution changes
+  GLint bound = 0, width = 0, height = 0;
+  glGetIntegerv(GL_TEXTURE_BINDING_2D, &bound);
+  glBindTexture(GL_TEXTURE_2D, texture);
+  glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+  glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+  glBindTexture(GL_TEXTURE_2D, bound);
+
+  Begin(GLOP_FRAMEBUFFER_STATE);
+  Put32(framebuffer);
+  Put32(texture);
+  Put32(width);
+  Put32(height);
+  PutSampling(texture);
+  End();
+}
+
+void GLCaptureProgram(GLuint program, int count, const GLenum *types, char **sources) {
+  Begin(GLOP_PROGRAM_STATE);
+  Put32(program);
+  Put32(count);
+  for (int i = 0; i < count; i++) {
+    Put32(types[i]);
+    PutString(sources[i]);
+  }
+
+  // Uniforms are set by location, which the replayer finds again by name
+  GLint uniforms = 0;
+  glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniforms);
+  Put32(uniforms);
+  for (GLint i = 0; i < uniforms; i++) {
+    char name[256];
+    GLint size;
+    GLenum type;
+    glGetActiveUniform(program, i, sizeof(name), NULL, &size, &type, name);
+    Put32(glGetUniformLocation(program, name));
+    PutString(name);
+  }
+  End();
+}
+
+/* Closes the capture file, removing it if the capture is incomplete */
+static int CloseCapture(bool complete) {
+  glRecording = false;
+  framesLeft = 0;
+
+  const bool written = !failed && fflush(file) == 0 && !ferror(file);
+  fclose(file);
+  file = NULL;
+
+  if (!written || !complete) {
+    remove(filePath);
+  }
+  MemoryFree(filePath);
+  filePath = NULL;
+
+  MemoryFree(payload);
+  payload = NULL;
+  payloadSize = payloadCapacity = 0;
+
+  return written ? 0 : -1;
+}
+
+void GLCaptureBeginFrame(int width, int height) {
+  if (!file || glRecording) {
+    return;
+  }
+
+  Begin(GLOP_BEGIN); Put32(width); Put32(height); Put32(frameCount); End();
+
+  ImageCaptureState();
+  CanvasCaptureState();
+  ShaderCaptureState();
+
+  glRecording = true;
+}
+
+void GLCaptureEndFrame() {
+  if (!glRecording) {
+    return;
+  }
+
+  Begin(GLOP_FRAME_END); End();
+  if (--framesLeft == 0) {
+    CloseCapture(true);
+  }
+}
+
+int Splat_StartGLCapture(const char *path, int frames) {
+  if (!path || frames <= 0) {
+    Splat_SetError("Splat_StartGLCapture:  Invalid argument.");
+    return -1;
+  }
+
+  if (file) {
+    Splat_SetError("Splat_StartGLCapture:  A capture is already in progress.");
+    return -1;
+  }
+
+  filePath = MemoryAlloc(SPLAT_MEMORY_OTHER, strlen(path) + 1);
+  if (!filePath) {
+    Splat_SetError("Splat_StartGLCapture:  Allocation failed.");
+    return -1;
+  }
+  strcpy(filePath, path);
+
+  file = fopen(path, "wb");
+  if (!file) {
+    MemoryFree(filePath);
+    filePath = NULL;
+    Splat_SetError("Splat_StartGLCapture:  Unable to open %s.", path);
+    return -1;
+  }
+
+  failed = fwrite(GLCAPTURE_MAGIC, 8, 1, file) != 1;
+  framesLeft = frameCount = frames;
+  return 0;
+}
+
+int Splat_StopGLCapture() {
+  if (!file) {
+    Splat_SetError("Splat_StopGLCapture:  No capture is in progress.");
+    return -1;
+  }
+
+  // Frames already recorded are kept, but a capture that never started is discarded
+  if (CloseCapture(glRecording) != 0) {
+    Splat_SetError("Splat_StopGLCapture:  Unable to write the capture.");
+    return -1;
+  }
+
+  return 0;
+}
+
+void GLCaptureFinish() {
+  if (file) {
+    CloseCapture(false);
+  }
+}
@@ -0,0 +1,56 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_GLCAPTURE_H__
+#define __SPLAT_GLCAPTURE_H__
+
+#include <SDL.h>
+#include <SDL_opengl.h>
+
+/*
+ * Starts recording at the first frame after Splat_StartGLCapture, first
+ * writing the state that already exists.  width and height are the size
+ * of the default framebuffer frames are presented to.
+ */
+void GLCaptureBeginFrame(int width, int height);
+
+/* Marks the end of a frame, ending the capture after its last frame */
+void GLCaptureEndFrame();
+
+/* Records a texture that existed before the capture started, with its sampling state and its contents if data is not NULL */
+void GLCaptureTexture(GLuint name, int width, int height, GLint internalFormat, GLenum format, GLenum type, const void *data, uint32_t size);
+
+/* Records a framebuffer that existed before the capture started, with the size and sampling state of its color attachment */
+void GLCaptureFramebuffer(GLuint framebuffer, GLuint texture);
+
+/* Records a program that existed before the capture started, with its shader types and sources */
+void GLCaptureProgram(GLuint program, int count, const GLenum *types, char **sources);
+
+/* Ends any capture in progress */
+void GLCaptureFinish();
+
+/* Called by GLCaptureBeginFrame to record the objects each module owns */
+void ImageCaptureState();
+void CanvasCaptureState();
+void ShaderCaptureState();
+
+#endif // __SPLAT_GLCAPTURE_H__
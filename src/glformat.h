@@ -0,0 +1,92 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_GLFORMAT_H__
+#define __SPLAT_GLFORMAT_H__
+
+/*
+ * Layout of GL capture files, shared by the library and the replayer.
+ *
+ * A capture starts with the 8-byte magic, followed by records.  Each
+ * record is a one-byte opcode, a 32-bit payload length and the
+ * payload.  Values are stored in the byte order of the machine that
+ * made the capture: GLenum, GLint, GLuint and GLsizei as 32 bits,
+ * GLfloat as 32-bit and GLdouble as 64-bit IEEE floats, and strings
+ * as a 32-bit length followed by the bytes.  Object names are those of
+ * the capturing context, which the replayer maps to names of its own.
+ */
+
+#define GLCAPTURE_MAGIC "SPLATGC2"
+
+typedef enum {
+  /* Start of the capture: window width, height and frame count */
+  GLOP_BEGIN = 1,
+
+  /* State that existed before the capture started */
+  GLOP_TEXTURE_STATE, /* name, width, height, internalFormat, format, type, minFilter, magFilter, wrapS, wrapT, size, data; format 0 for compressed data */
+  GLOP_FRAMEBUFFER_STATE, /* framebuffer, texture, width, height, minFilter, magFilter, wrapS, wrapT; the size is that of the texture */
+  GLOP_PROGRAM_STATE, /* program, shader count, (type, source) per shader, uniform count, (location, name) per uniform */
+
+  /* End of a frame, where the replayer waits for the GPU and times it */
+  GLOP_FRAME_END,
+
+  /* Calls, with the same arguments as the GL function unless noted */
+  GLOP_BIND_FRAMEBUFFER,
+  GLOP_VIEWPORT,
+  GLOP_MATRIX_MODE,
+  GLOP_LOAD_IDENTITY,
+  GLOP_ORTHO_2D, /* Four doubles, as gluOrtho2D */
+  GLOP_TRANSLATEF,
+  GLOP_SCALEF,
+  GLOP_ROTATEF,
+  GLOP_PUSH_MATRIX,
+  GLOP_POP_MATRIX,
+  GLOP_CLEAR_COLOR,
+  GLOP_CLEAR,
+  GLOP_ENABLE,
+  GLOP_DISABLE,
+  GLOP_BLEND_FUNC,
+  GLOP_BLEND_FUNC_SEPARATE,
+  GLOP_TEX_PARAMETERI,
+  GLOP_TEX_PARAMETERF,
+  GLOP_ENABLE_CLIENT_STATE,
+  GLOP_DISABLE_CLIENT_STATE,
+  GLOP_COLOR4UB, /* Four bytes */
+  GLOP_SCISSOR,
+  GLOP_LINE_WIDTH,
+  GLOP_BIND_TEXTURE,
+  GLOP_DRAW_ARRAYS, /* mode, first, count, then for the vertex and texcoord arrays: enabled, and if so size, type, stride, byte count, data */
+  GLOP_USE_PROGRAM,
+  GLOP_UNIFORM1I,
+  GLOP_UNIFORM2F,
+  GLOP_PIXEL_STOREI,
+  GLOP_TEX_IMAGE_2D, /* target, level, internalFormat, width, height, border, format, type, byte count, data; count 0 for no data */
+  GLOP_TEX_SUB_IMAGE_2D, /* target, level, x, y, width, height, format, type, byte count, data */
+  GLOP_COMPRESSED_TEX_IMAGE_2D, /* target, level, internalFormat, width, height, border, byte count, data */
+  GLOP_GEN_TEXTURES, /* count, names */
+  GLOP_DELETE_TEXTURES, /* count, names */
+  GLOP_GEN_FRAMEBUFFERS, /* count, names */
+  GLOP_DELETE_FRAMEBUFFERS, /* count, names */
+  GLOP_FRAMEBUFFER_TEXTURE_2D,
+} GLCaptureOp;
+
+#endif // __SPLAT_GLFORMAT_H__
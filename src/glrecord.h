@@ -0,0 +1,124 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_GLRECORD_H__
+#define __SPLAT_GLRECORD_H__
+
+/*
+ * Routes the OpenGL calls made while rendering through the GL capture
+ * recorder.  Include after SDL_opengl.h in files whose calls should be
+ * captured.  When no capture is in progress each call costs one extra
+ * branch.  A macro's own name is not expanded again within it, so the
+ * second branch calls the real function.  Client array pointers and
+ * unpack state are read back from OpenGL when a draw or upload is
+ * recorded, so those calls need no wrapper.
+ */
+
+#include <stdbool.h>
+#include <SDL_opengl.h>
+#include <GL/glu.h>
+
+extern bool glRecording;
+
+void RecordBindFramebuffer(GLenum target, GLuint framebuffer);
+void RecordViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+void RecordMatrixMode(GLenum mode);
+void RecordLoadIdentity();
+void RecordOrtho2D(GLdouble left, GLdouble right, GLdouble bottom, GLdouble top);
+void RecordTranslatef(GLfloat x, GLfloat y, GLfloat z);
+void RecordScalef(GLfloat x, GLfloat y, GLfloat z);
+void RecordRotatef(GLfloat angle, GLfloat x, GLfloat y, GLfloat z);
+void RecordPushMatrix();
+void RecordPopMatrix();
+void RecordClearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+void RecordClear(GLbitfield mask);
+void RecordEnable(GLenum cap);
+void RecordDisable(GLenum cap);
+void RecordBlendFunc(GLenum sfactor, GLenum dfactor);
+void RecordBlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha);
+void RecordTexParameteri(GLenum target, GLenum pname, GLint param);
+void RecordTexParameterf(GLenum target, GLenum pname, GLfloat param);
+void RecordEnableClientState(GLenum array);
+void RecordDisableClientState(GLenum array);
+void RecordColor4ub(GLubyte r, GLubyte g, GLubyte b, GLubyte a);
+void RecordScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+void RecordLineWidth(GLfloat width);
+void RecordBindTexture(GLenum target, GLuint texture);
+void RecordDrawArrays(GLenum mode, GLint first, GLsizei count);
+void RecordUseProgram(GLuint program);
+void RecordUniform1i(GLint location, GLint value);
+void RecordUniform2f(GLint location, GLfloat x, GLfloat y);
+void RecordPixelStorei(GLenum pname, GLint param);
+void RecordTexImage2D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid *data);
+void RecordTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *data);
+void RecordCompressedTexImage2D(GLenum target, GLint level, GLenum internalFormat, GLsizei width, GLsizei height, GLint border, GLsizei size, const GLvoid *data);
+void RecordGenTextures(GLsizei count, GLuint *names);
+void RecordDeleteTextures(GLsizei count, const GLuint *names);
+void RecordGenFramebuffers(GLsizei count, GLuint *names);
+void RecordDeleteFramebuffers(GLsizei count, const GLuint *names);
+void RecordFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+
+#ifndef GLRECORD_IMPLEMENTATION
+
+#define RECORDED(call, record) (glRecording ? record : call)
+
+#define glBindFramebuffer(t, f) RECORDED(glBindFramebuffer(t, f), RecordBindFramebuffer(t, f))
+#define glViewport(x, y, w, h) RECORDED(glViewport(x, y, w, h), RecordViewport(x, y, w, h))
+#define glMatrixMode(m) RECORDED(glMatrixMode(m), RecordMatrixMode(m))
+#define glLoadIdentity() RECORDED(glLoadIdentity(), RecordLoadIdentity())
+#define gluOrtho2D(l, r, b, t) RECORDED(gluOrtho2D(l, r, b, t), RecordOrtho2D(l, r, b, t))
+#define glTranslatef(x, y, z) RECORDED(glTranslatef(x, y, z), RecordTranslatef(x, y, z))
+#define glScalef(x, y, z) RECORDED(glScalef(x, y, z), RecordScalef(x, y, z))
+#define glRotatef(a, x, y, z) RECORDED(glRotatef(a, x, y, z), RecordRotatef(a, x, y, z))
+#define glPushMatrix() RECORDED(glPushMatrix(), RecordPushMatrix())
+#define glPopMatrix() RECORDED(glPopMatrix(), RecordPopMatrix())
+#define glClearColor(r, g, b, a) RECORDED(glClearColor(r, g, b, a), RecordClearColor(r, g, b, a))
+#define glClear(m) RECORDED(glClear(m), RecordClear(m))
+#define glEnable(c) RECORDED(glEnable(c), RecordEnable(c))
+#define glDisable(c) RECORDED(glDisable(c), RecordDisable(c))
+#define glBlendFunc(s, d) RECORDED(glBlendFunc(s, d), RecordBlendFunc(s, d))
+#define glBlendFuncSeparate(s, d, sa, da) RECORDED(glBlendFuncSeparate(s, d, sa, da), RecordBlendFuncSeparate(s, d, sa, da))
+#define glTexParameteri(t, n, p) RECORDED(glTexParameteri(t, n, p), RecordTexParameteri(t, n, p))
+#define glTexParameterf(t, n, p) RECORDED(glTexParameterf(t, n, p), RecordTexParameterf(t, n, p))
+#define glEnableClientState(a) RECORDED(glEnableClientState(a), RecordEnableClientState(a))
+#define glDisableClientState(a) RECORDED(glDisableClientState(a), RecordDisableClientState(a))
+#define glColor4ub(r, g, b, a) RECORDED(glColor4ub(r, g, b, a), RecordColor4ub(r, g, b, a))
+#define glScissor(x, y, w, h) RECORDED(glScissor(x, y, w, h), RecordScissor(x, y, w, h))
+#define glLineWidth(w) RECORDED(glLineWidth(w), RecordLineWidth(w))
+#define glBindTexture(t, n) RECORDED(glBindTexture(t, n), RecordBindTexture(t, n))
+#define glDrawArrays(m, f, c) RECORDED(glDrawArrays(m, f, c), RecordDrawArrays(m, f, c))
+#define glUseProgram(p) RECORDED(glUseProgram(p), RecordUseProgram(p))
+#define glUniform1i(l, v) RECORDED(glUniform1i(l, v), RecordUniform1i(l, v))
+#define glUniform2f(l, x, y) RECORDED(glUniform2f(l, x, y), RecordUniform2f(l, x, y))
+#define glPixelStorei(n, p) RECORDED(glPixelStorei(n, p), RecordPixelStorei(n, p))
+#define glTexImage2D(t, l, i, w, h, b, f, ty, d) RECORDED(glTexImage2D(t, l, i, w, h, b, f, ty, d), RecordTexImage2D(t, l, i, w, h, b, f, ty, d))
+#define glTexSubImage2D(t, l, x, y, w, h, f, ty, d) RECORDED(glTexSubImage2D(t, l, x, y, w, h, f, ty, d), RecordTexSubImage2D(t, l, x, y, w, h, f, ty, d))
+#define glCompressedTexImage2D(t, l, i, w, h, b, s, d) RECORDED(glCompressedTexImage2D(t, l, i, w, h, b, s, d), RecordCompressedTexImage2D(t, l, i, w, h, b, s, d))
+#define glGenTextures(c, n) RECORDED(glGenTextures(c, n), RecordGenTextures(c, n))
+#define glDeleteTextures(c, n) RECORDED(glDeleteTextures(c, n), RecordDeleteTextures(c, n))
+#define glGenFramebuffers(c, n) RECORDED(glGenFramebuffers(c, n), RecordGenFramebuffers(c, n))
+#define glDeleteFramebuffers(c, n) RECORDED(glDeleteFramebuffers(c, n), RecordDeleteFramebuffers(c, n))
+#define glFramebufferTexture2D(t, a, tt, n, l) RECORDED(glFramebufferTexture2D(t, a, tt, n, l), RecordFramebufferTexture2D(t, a, tt, n, l))
+
+#endif // GLRECORD_IMPLEMENTATION
+
+#endif // __SPLAT_GLRECORD_H__
@@ -0,0 +1,145 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <string.h>
+#include "hash.h"
+
+/* Implementation of the XXH64 hash by Yann Collet */
+
+#define PRIME1 0x9E3779B185EBCA87ULL
+#define PRIME2 0xC2B2AE3D27D4EB4FULL
+#define PRIME3 0x165667B19E3779F9ULL
+#define PRIME4 0x85EBCA77C2B2AE63ULL
+#define PRIME5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t Rotate(uint64_t value, int bits) {
+  return (value << bits) | (value >> (64 - bits));
+}
+
+static inline uint64_t Read64(const uint8_t *p) {
+  return ((uint64_t) p[0]) | ((uint64_t) p[1] << 8) | ((uint64_t) p[2] << 16) | ((uint64_t) p[3] << 24) |
+         ((uint64_t) p[4] << 32) | ((uint64_t) p[5] << 40) | ((uint64_t) p[6] << 48) | ((uint64_t) p[7] << 56);
+}
+
+static inline uint32_t Read32(const uint8_t *p) {
+  return ((uint32_t) p[0]) | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline uint64_t Round(uint64_t acc, uint64_t input) {
+  acc += input * PRIME2;
+  acc = Rotate(acc, 31);
+  return acc * PRIME1;
+}
+
+static inline uint64_t Merge(uint64_t acc, uint64_t value) {
+  acc ^= Round(0, value);
+  return acc * PRIME1 + PRIME4;
+}
+
+void HashInit(HashState *state, uint64_t seed) {
+  memset(state, 0, sizeof(HashState));
+  state->seed = seed;
+  state->v[0] = seed + PRIME1 + PRIME2;
+  state->v[1] = seed + PRIME2;
+  state->v[2] = seed;
+  state->v[3] = seed - PRIME1;
+}
+
+void HashUpdate(HashState *state, const void *data, size_t length) {
+  const uint8_t *p = data;
+  const uint8_t *end = p + length;
+
+  state->total += length;
+
+  // Top up a partially filled stripe first
+  if (state->buffered) {
+    const size_t fill = 32 - state->buffered < length ? 32 - state->buffered : length;
+    memcpy(state->buffer + state->buffered, p, fill);
+    state->buffered += fill;
+    p += fill;
+
+    if (state->buffered < 32) {
+      return;
+    }
+
+    for (int i = 0; i < 4; i++) {
+      state->v[i] = Round(state->v[i], Read64(state->buffer + i * 8));
+    }
+    state->buffered = 0;
+  }
+
+  while (end - p >= 32) {
+    for (int i = 0; i < 4; i++) {
+      state->v[i] = Round(state->v[i], Read64(p + i * 8));
+    }
+    p += 32;
+  }
+
+  if (p < end) {
+    memcpy(state->buffer, p, end - p);
+    state->buffered = end - p;
+  }
+}
+
+uint64_t HashFinal(const HashState *state) {
+  uint64_t hash;
+
+  if (state->total >= 32) {
+    hash = Rotate(state->v[0], 1) + Rotate(state->v[1], 7) + Rotate(state->v[2], 12) + Rotate(state->v[3], 18);
+    for (int i = 0; i < 4; i++) {
+      hash = Merge(hash, state->v[i]);
+    }
+  } else {
+    hash = state->seed + PRIME5;
+  }
+
+  hash += state->total;
+
+  const uint8_t *p = state->buffer;
+  const uint8_t *end = p + state->buffered;
+
+  while (end - p >= 8) {
+    hash ^= Round(0, Read64(p));
+    hash = Rotate(hash, 27) * PRIME1 + PRIME4;
+    p += 8;
+  }
+
+  if (end - p >= 4) {
+    hash ^= (uint64_t) Read32(p) * PRIME1;
+    hash = Rotate(hash, 23) * PRIME2 + PRIME3;
+    p += 4;
+  }
+
+  while (p < end) {
+    hash ^= (*p) * PRIME5;
+    hash = Rotate(hash, 11) * PRIME1;
+    p++;
+  }
+
+  hash ^= hash >> 33;
+  hash *= PRIME2;
+  hash ^= hash >> 29;
+  hash *= PRIME3;
+  hash ^= hash >> 32;
+
+  return hash;
+}
@@ -0,0 +1,42 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_HASH_H__
+#define __SPLAT_HASH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Streaming state for the 64-bit hash, compatible with XXH64 */
+typedef struct HashState {
+  uint64_t total;
+  uint64_t v[4];
+  uint8_t buffer[32];
+  size_t buffered;
+  uint64_t seed;
+} HashState;
+
+void HashInit(HashState *state, uint64_t seed);
+void HashUpdate(HashState *state, const void *data, size_t length);
+uint64_t HashFinal(const HashState *state);
+
+#endif // __SPLAT_HASH_H__
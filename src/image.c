@@ -20,139 +20,945 @@
   3. This notice may not be removed or altered from any source distribution.
 */
 
+#define GL_GLEXT_PROTOTYPES
 #include <SDL.h>
 #include <SDL_opengl.h>
 #include "splat.h"
 #include "types.h"
+#include "image.h"
+#include "animation.h"
+#include "canvas.h"
+#include "compress.h"
+#include "glcapture.h"
+#include "glrecord.h"
+#include "hash.h"
+#include "memory.h"
+#include "queue.h"
+#include "stats.h"
+#include "trace.h"
 
 static Splat_Image *images = NULL;
+static Splat_Texture *textures = NULL;
 
-Splat_Image *Splat_CreateImage(SDL_Surface *surface) {
-  if (!surface) {
-    Splat_SetError("Splat_CreateImage:  Invalid argument.");
-    return NULL;
-  }
+static uint32_t defaultFlags = 0;
+static uint32_t tileSizeLimit = 0;
+static uint32_t tileReleaseDelay = 0;
+static GLint maxTextureSize = 0;
+static uint32_t frame = 0;
+static uint64_t budget = 0;
+static uint64_t residentBytes = 0;
+static uint64_t evictedBytes = 0;
+static uint32_t residentTextures = 0;
+static uint32_t evictedTextures = 0;
+static uint32_t evictions = 0;
+static uint32_t reloads = 0;
 
-  // Allocate the surface for this context
-  Splat_Image *image = malloc(sizeof(Splat_Image));
-  if (!image) {
-    Splat_SetError("Splat_CreateImage:  Allocation failed.");
-    return NULL;
-  }
+/* Pixels to upload, from an SDL_Surface or application memory */
+typedef struct PixelSource {
+  const void *pixels;
+  int width;
+  int height;
+  int pitch;
+  uint32_t format;
+} PixelSource;
 
-  // Place new image at the top of the list.
-  image->next = images;
-  images = image;
+/* OpenGL layout of each Splat_PixelFormat */
+static const struct {
+  GLint internalFormat;
+  GLenum format;
+  GLenum type;
+  int bytesPerPixel;
+} pixelFormats[] = {
+  { 4, GL_RGBA, GL_UNSIGNED_BYTE, 4 },  /* SPLAT_PIXELFORMAT_RGBA32 */
+  { 4, GL_BGRA, GL_UNSIGNED_BYTE, 4 },  /* SPLAT_PIXELFORMAT_BGRA32 */
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+  { 4, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8, 4 },  /* SPLAT_PIXELFORMAT_ARGB32 */
+  { 4, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, 4 },  /* SPLAT_PIXELFORMAT_ABGR32 */
+#else
+  { 4, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, 4 },  /* SPLAT_PIXELFORMAT_ARGB32 */
+  { 4, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, 4 },  /* SPLAT_PIXELFORMAT_ABGR32 */
+#endif
+  { 3, GL_RGB, GL_UNSIGNED_BYTE, 3 },  /* SPLAT_PIXELFORMAT_RGB24 */
+  { 3, GL_BGR, GL_UNSIGNED_BYTE, 3 },  /* SPLAT_PIXELFORMAT_BGR24 */
+  { GL_RGB, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 2 },  /* SPLAT_PIXELFORMAT_RGB565 */
+  { GL_RGBA, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, 2 },  /* SPLAT_PIXELFORMAT_RGBA4444 */
+  { GL_RGBA, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, 2 },  /* SPLAT_PIXELFORMAT_RGBA5551 */
+  { GL_ALPHA, GL_ALPHA, GL_UNSIGNED_BYTE, 1 },  /* SPLAT_PIXELFORMAT_A8 */
+  { GL_LUMINANCE, GL_LUMINANCE, GL_UNSIGNED_BYTE, 1 },  /* SPLAT_PIXELFORMAT_L8 */
+};
+
+static int GetSurfaceFormat(SDL_Surface *surface, uint32_t *format) {
+  const SDL_PixelFormat *pf = surface->format;
 
   // Get the number of channels in the SDL surface
-  GLenum format;
-  if (surface->format->BytesPerPixel == 4) {     // contains an alpha channel
-    if (surface->format->Rmask == 0x000000FF) {
-      format = GL_RGBA;
+  if (pf->BytesPerPixel == 4) {     // contains an alpha channel
+    if (pf->Rmask == 0x000000FF) {
+      *format = SPLAT_PIXELFORMAT_RGBA32;
     } else {
-      format = GL_BGRA;
+      *format = SPLAT_PIXELFORMAT_BGRA32;
     }
-  } else if (surface->format->BytesPerPixel == 3) {    // no alpha channel
-    if (surface->format->Rmask == 0x000000FF) {
-      format = GL_RGB;
+  } else if (pf->BytesPerPixel == 3) {    // no alpha channel
+    if (pf->Rmask == 0x000000FF) {
+      *format = SPLAT_PIXELFORMAT_RGB24;
     } else {
-      format = GL_BGR;
+      *format = SPLAT_PIXELFORMAT_BGR24;
     }
+  } else if (pf->BytesPerPixel == 2 && pf->Rmask == 0xF800 && pf->Gmask == 0x07E0 && pf->Bmask == 0x001F) {
+    *format = SPLAT_PIXELFORMAT_RGB565;
+  } else if (pf->BytesPerPixel == 2 && pf->Rmask == 0xF000 && pf->Amask == 0x000F) {
+    *format = SPLAT_PIXELFORMAT_RGBA4444;
+  } else if (pf->BytesPerPixel == 2 && pf->Rmask == 0xF800 && pf->Amask == 0x0001) {
+    *format = SPLAT_PIXELFORMAT_RGBA5551;
   } else {
-    Splat_SetError("SDL_Surface is not true color (24 or 32-bit).");
-    return NULL;
+    Splat_SetError("SDL_Surface is not true color (24 or 32-bit) or a supported 16-bit format.");
+    return -1;
   }
 
-  if (SDL_MUSTLOCK(surface)) {
-    if (!SDL_LockSurface(surface)) {
-      Splat_SetError("Failed to lock surface to upload to OpenGL");
-      return NULL;
+  return 0;
+}
+
+/* Describes the row layout of the source pixels to OpenGL.  Returns false if the pitch can't be expressed. */
+static bool SetUnpackLayout(int rowBytes, int pitch, int bytesPerPixel) {
+  if (pitch % bytesPerPixel == 0) {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / bytesPerPixel);
+    return true;
+  }
+
+  // Rows padded to a power of two, as with 24-bit surfaces
+  for (int alignment = 8; alignment > 1; alignment /= 2) {
+    if (pitch % alignment == 0 && pitch >= rowBytes && pitch - rowBytes < alignment) {
+      glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/* Uploads texture data to the texture, creating the OpenGL texture if needed */
+static int UploadTexture(Splat_Texture *texture, const void *data, GLint internalFormat, uint32_t pixelFormat, int width, int height, int pitch) {
+  const uint64_t trace = TraceBegin();
+
+  if (!texture->name) {
+    // Have OpenGL generate a texture object handle for us
+    glGenTextures(1, &texture->name);
+
+    // Bind the texture object
+    glBindTexture(GL_TEXTURE_2D, texture->name);
+
+    // Set the texture's stretching properties
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1.0f);
+    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+  } else {
+    // Bind the texture object
+    glBindTexture(GL_TEXTURE_2D, texture->name);
+  }
+
+  uint32_t bytes;
+  if (IsCompressedFormat(internalFormat)) {
+    bytes = CompressedSize(internalFormat, width, height);
+    glCompressedTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, bytes, data);
+  } else {
+    const GLenum format = pixelFormats[pixelFormat].format;
+    const GLenum type = pixelFormats[pixelFormat].type;
+    const int bytesPerPixel = pixelFormats[pixelFormat].bytesPerPixel;
+
+    // Upload straight from the caller's rows when OpenGL can describe the pitch, otherwise one row at a time
+    if (SetUnpackLayout(width * bytesPerPixel, pitch, bytesPerPixel)) {
+      glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, data);
+    } else {
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, NULL);
+      for (int y = 0; y < height; y++) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width, 1, format, type, ((const uint8_t *) data) + y * pitch);
+      }
+    }
+
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // Drivers store 24-bit and 16-bit textures padded to 32 bits
+    bytes = width * height * (bytesPerPixel == 1 ? 1 : 4);
+  }
+
+  GLenum err = glGetError();
+  if (err != GL_NO_ERROR) {
+    Splat_SetError("An OpenGL (%d) error occurred while uploading an image", err);
+    return -1;
+  }
+
+  // Update texture memory accounting
+  if (texture->resident) {
+    residentBytes -= texture->bytes;
+  } else {
+    residentTextures++;
+  }
+  texture->bytes = bytes;
+  texture->resident = true;
+  residentBytes += texture->bytes;
+  StatsUpload(bytes);
+  TraceEnd(trace, "UploadTexture", "bytes", bytes);
+
+  texture->width = width;
+  texture->height = height;
+  texture->internalFormat = internalFormat;
+  texture->pixelFormat = pixelFormat;
+
+  return 0;
+}
+
+/* Returns the size of the texture's retained data */
+static int RetainedSize(Splat_Texture *texture) {
+  if (IsCompressedFormat(texture->internalFormat)) {
+    return CompressedSize(texture->internalFormat, texture->width, texture->height);
+  }
+
+  return texture->width * texture->height * pixelFormats[texture->pixelFormat].bytesPerPixel;
+}
+
+/* Replaces the retained copy of the texture's pixels */
+static int RetainPixels(Splat_Texture *texture, const PixelSource *source) {
+  const int rowBytes = source->width * pixelFormats[source->format].bytesPerPixel;
+  uint8_t *copy = MemoryRealloc(SPLAT_MEMORY_IMAGE, texture->pixels, rowBytes * source->height);
+  if (!copy) {
+    Splat_SetError("Allocation failed while retaining image pixels.");
+    return -1;
+  }
+
+  for (int y = 0; y < source->height; y++) {
+    memcpy(copy + y * rowBytes, ((const uint8_t *) source->pixels) + y * source->pitch, rowBytes);
+  }
+
+  texture->pixels = copy;
+  return 0;
+}
+
+/* Returns true if pixels in the given format should be compressed for an image with the given flags */
+static bool WantsCompression(uint32_t flags, uint32_t pixelFormat) {
+  // Only byte-ordered RGB(A) pixels can be fed to the compressor
+  return (flags & SPLAT_IMAGE_COMPRESS) && !(flags & SPLAT_IMAGE_LOSSLESS) &&
+         pixelFormats[pixelFormat].type == GL_UNSIGNED_BYTE && pixelFormats[pixelFormat].bytesPerPixel >= 3 &&
+         CompressionSupported();
+}
+
+/* Uploads new pixels for the texture, compressing them first if requested */
+static int UploadPixels(Splat_Texture *texture, uint32_t flags, const PixelSource *source) {
+  if (WantsCompression(flags, source->format)) {
+    const GLint internalFormat = CompressedFormat(pixelFormats[source->format].bytesPerPixel);
+    uint8_t *blocks = MemoryAlloc(SPLAT_MEMORY_IMAGE, CompressedSize(internalFormat, source->width, source->height));
+    if (!blocks) {
+      Splat_SetError("Allocation failed while compressing image.");
+      return -1;
     }
+
+    CompressImage(source->pixels, pixelFormats[source->format].format, pixelFormats[source->format].bytesPerPixel,
+                  source->width, source->height, source->pitch, blocks);
+
+    int result = UploadTexture(texture, blocks, internalFormat, source->format, source->width, source->height, 0);
+
+    // A retained copy keeps the compressed blocks, so restoring needs no recompression
+    if (result == 0 && texture->retainCount) {
+      MemoryFree(texture->pixels);
+      texture->pixels = blocks;
+    } else {
+      MemoryFree(blocks);
+    }
+
+    return result;
+  }
+
+  int result = UploadTexture(texture, source->pixels, pixelFormats[source->format].internalFormat, source->format,
+                             source->width, source->height, source->pitch);
+  if (result == 0 && texture->retainCount) {
+    result = RetainPixels(texture, source);
   }
 
-  // Have OpenGL generate a texture object handle for us
-  glGenTextures(1, &image->texture);
+  return result;
+}
 
-  // Bind the texture object
-  glBindTexture(GL_TEXTURE_2D, image->texture);
+/* Locks the surface and describes its pixels.  UnlockSurfaceSource must be called if successful. */
+static int LockSurfaceSource(SDL_Surface *surface, PixelSource *source) {
+  if (GetSurfaceFormat(surface, &source->format) != 0) {
+    return -1;
+  }
 
-  // Set the texture's stretching properties
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1.0f);
-  glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+  if (SDL_MUSTLOCK(surface)) {
+    if (SDL_LockSurface(surface) != 0) {
+      Splat_SetError("Failed to lock surface to upload to OpenGL");
+      return -1;
+    }
+  }
 
-  // Edit the texture object's surface data using the information SDL_Surface gives us
-  glTexImage2D(GL_TEXTURE_2D, 0, surface->format->BytesPerPixel, surface->w, surface->h, 0, format, GL_UNSIGNED_BYTE, surface->pixels);
+  source->pixels = surface->pixels;
+  source->width = surface->w;
+  source->height = surface->h;
+  source->pitch = surface->pitch;
+  return 0;
+}
 
+static void UnlockSurfaceSource(SDL_Surface *surface) {
   if (SDL_MUSTLOCK(surface)) {
     SDL_UnlockSurface(surface);
   }
+}
 
-  // Set the surface width and height
-  image->width = surface->w;
-  image->height = surface->h;
+static bool ValidPixelSource(const PixelSource *source) {
+  return source->pixels && source->width > 0 && source->height > 0 && source->format < SDL_arraysize(pixelFormats) &&
+         source->pitch >= source->width * pixelFormats[source->format].bytesPerPixel;
+}
 
-  return image;
+/* Hashes the dimensions, format and pixels of the source.  Never returns 0, which marks unshared textures. */
+static uint64_t HashSource(const PixelSource *source, bool compressed) {
+  const uint32_t header[4] = { source->width, source->height, source->format, compressed };
+  const int rowBytes = source->width * pixelFormats[source->format].bytesPerPixel;
+  HashState state;
+
+  HashInit(&state, 0);
+  HashUpdate(&state, header, sizeof(header));
+  for (int y = 0; y < source->height; y++) {
+    HashUpdate(&state, ((const uint8_t *) source->pixels) + y * source->pitch, rowBytes);
+  }
+
+  const uint64_t hash = HashFinal(&state);
+  return hash ? hash : 1;
 }
 
-int Splat_UpdateImage(Splat_Image *image, SDL_Surface *surface) {
-  if (!surface || !image) {
-    Splat_SetError("Splat_CreateImage:  Invalid argument.");
-    return 1;
+/* Returns true if the texture holds exactly what uploading the source would, so a hash collision is never shared */
+static bool TextureMatches(Splat_Texture *texture, uint32_t flags, const PixelSource *source) {
+  const bool compressed = WantsCompression(flags, source->format);
+  if (texture->width != (uint32_t) source->width || texture->height != (uint32_t) source->height ||
+      texture->pixelFormat != source->format || IsCompressedFormat(texture->internalFormat) != compressed) {
+    return false;
   }
 
-  // Get the number of channels in the SDL surface
-  GLenum format;
-  if (surface->format->BytesPerPixel == 4) {     // contains an alpha channel
-    if (surface->format->Rmask == 0x000000FF) {
-      format = GL_RGBA;
+  // Compare against the retained copy, or read the texture back if there is none
+  const int size = RetainedSize(texture);
+  uint8_t *readback = NULL;
+  const uint8_t *contents = texture->pixels;
+  if (!contents) {
+    if (!texture->resident || !(readback = MemoryAlloc(SPLAT_MEMORY_OTHER, size))) {
+      return false;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texture->name);
+    if (compressed) {
+      glGetCompressedTexImage(GL_TEXTURE_2D, 0, readback);
     } else {
-      format = GL_BGRA;
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+      glGetTexImage(GL_TEXTURE_2D, 0, pixelFormats[source->format].format, pixelFormats[source->format].type, readback);
+      glPixelStorei(GL_PACK_ALIGNMENT, 4);
     }
-  } else if (surface->format->BytesPerPixel == 3) {    // no alpha channel
-    if (surface->format->Rmask == 0x000000FF) {
-      format = GL_RGB;
+    contents = readback;
+  }
+
+  bool matches = true;
+  if (compressed) {
+    // Compression is deterministic, so identical pixels give identical blocks
+    uint8_t *blocks = MemoryAlloc(SPLAT_MEMORY_OTHER, size);
+    if (blocks) {
+      CompressImage(source->pixels, pixelFormats[source->format].format, pixelFormats[source->format].bytesPerPixel,
+                    source->width, source->height, source->pitch, blocks);
+      matches = memcmp(blocks, contents, size) == 0;
+      MemoryFree(blocks);
     } else {
-      format = GL_BGR;
+      matches = false;
     }
   } else {
-    Splat_SetError("SDL_Surface is not true color (24 or 32-bit).");
-    return 1;
+    const int rowBytes = source->width * pixelFormats[source->format].bytesPerPixel;
+    for (int y = 0; matches && y < source->height; y++) {
+      matches = memcmp(contents + y * rowBytes, ((const uint8_t *) source->pixels) + y * source->pitch, rowBytes) == 0;
+    }
   }
 
-  if (SDL_MUSTLOCK(surface)) {
-    if (!SDL_LockSurface(surface)) {
-      Splat_SetError("Failed to lock surface to upload to OpenGL");
-      return 1;
+  MemoryFree(readback);
+  return matches;
+}
+
+/* Returns a shareable texture with the same contents as the source, or NULL */
+static Splat_Texture *FindTexture(uint64_t hash, uint32_t flags, const PixelSource *source) {
+  for (Splat_Texture *curr = textures; curr != NULL; curr = curr->next) {
+    if (curr->hash == hash && TextureMatches(curr, flags, source)) {
+      return curr;
     }
   }
 
-  // Bind the texture object
-  glBindTexture(GL_TEXTURE_2D, image->texture);
+  return NULL;
+}
 
-  // Edit the texture object's surface data using the information SDL_Surface gives us
-  glTexImage2D(GL_TEXTURE_2D, 0, surface->format->BytesPerPixel, surface->w, surface->h, 0, format, GL_UNSIGNED_BYTE, surface->pixels);
+static Splat_Texture *CreateTexture() {
+  Splat_Texture *texture = MemoryAlloc(SPLAT_MEMORY_IMAGE, sizeof(Splat_Texture));
+  if (!texture) {
+    Splat_SetError("Allocation failed while creating texture.");
+    return NULL;
+  }
+  memset(texture, 0, sizeof(Splat_Texture));
+  texture->refcount = 1;
+  texture->lastUsed = frame;
 
-  if (SDL_MUSTLOCK(surface)) {
-    SDL_UnlockSurface(surface);
+  // Place new texture at the top of the list.
+  texture->next = textures;
+  textures = texture;
+
+  return texture;
+}
+
+/* Drops a reference to the texture, deleting it once no image uses it */
+static void ReleaseTexture(Splat_Texture *texture) {
+  if (--texture->refcount > 0) {
+    return;
+  }
+
+  for (Splat_Texture *prev = NULL, *curr = textures; curr != NULL; prev = curr, curr = curr->next) {
+    if (curr == texture) {
+      if (prev) {
+        prev->next = curr->next;
+      } else {
+        textures = curr->next;
+      }
+      break;
+    }
+  }
+
+  if (texture->resident) {
+    glDeleteTextures(1, &texture->name);
+    residentBytes -= texture->bytes;
+    residentTextures--;
+  } else if (texture->bytes) {
+    evictedBytes -= texture->bytes;
+    evictedTextures--;
+  }
+
+  MemoryFree(texture->pixels);
+  MemoryFree(texture);
+}
+
+/* Returns the image's textures, either its single texture or its grid of tiles */
+static Splat_Texture **ImageTextures(Splat_Image *image, int *count) {
+  if (image->tiles) {
+    *count = image->columns * image->rows;
+    return image->tiles;
+  }
+
+  *count = image->texture ? 1 : 0;
+  return &image->texture;
+}
+
+/* Drops one image's request to keep the texture's pixels, freeing them once no image asks for them */
+static void UnretainTexture(Splat_Texture *texture) {
+  // An evicted texture may have no other way back, so it keeps its copy until it is restored
+  if (--texture->retainCount == 0 && texture->resident) {
+    MemoryFree(texture->pixels);
+    texture->pixels = NULL;
+  }
+}
+
+static bool ImageUsesTexture(Splat_Image *image, Splat_Texture *texture) {
+  int count;
+  Splat_Texture **list = ImageTextures(image, &count);
+  for (int i = 0; i < count; i++) {
+    if (list[i] == texture) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/* Releases the image's texture or tiles */
+static void ReleaseImageTextures(Splat_Image *image) {
+  int count;
+  Splat_Texture **list = ImageTextures(image, &count);
+  for (int i = 0; i < count; i++) {
+    if (list[i]) {
+      if (image->retained) {
+        UnretainTexture(list[i]);
+      }
+      ReleaseTexture(list[i]);
+    }
+  }
+
+  MemoryFree(image->tiles);
+  image->texture = NULL;
+  image->tiles = NULL;
+  image->columns = image->rows = image->tileSize = 0;
+}
+
+/* Keeps a copy of the texture's contents in system memory, reading it back from video memory */
+static int RetainTexture(Splat_Texture *texture) {
+  if (texture->pixels) {
+    return 0;
+  }
+
+  // Restore the texture if needed, then read its contents back
+  if (TextureBind(texture) != 0) {
+    return -1;
+  }
+
+  texture->pixels = MemoryAlloc(SPLAT_MEMORY_IMAGE, RetainedSize(texture));
+  if (!texture->pixels) {
+    Splat_SetError("Splat_SetImageRetained:  Allocation failed.");
+    return -1;
+  }
+
+  if (IsCompressedFormat(texture->internalFormat)) {
+    glGetCompressedTexImage(GL_TEXTURE_2D, 0, texture->pixels);
+  } else {
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, 0, pixelFormats[texture->pixelFormat].format, pixelFormats[texture->pixelFormat].type, texture->pixels);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  }
+
+  GLenum err = glGetError();
+  if (err != GL_NO_ERROR) {
+    MemoryFree(texture->pixels);
+    texture->pixels = NULL;
+    Splat_SetError("Splat_SetImageRetained:  An OpenGL (%d) error occurred reading the image", err);
+    return -1;
+  }
+
+  return 0;
+}
+
+/* Returns the largest texture size an image may use before it is split into tiles */
+static uint32_t GetTileSize() {
+  if (!maxTextureSize) {
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+  }
+
+  if (tileSizeLimit && tileSizeLimit < (uint32_t) maxTextureSize) {
+    return tileSizeLimit;
+  }
+
+  return maxTextureSize;
+}
+
+/* Describes the part of the source covered by a tile */
+static PixelSource TileSource(const PixelSource *source, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+  PixelSource tile = *source;
+  tile.pixels = ((const uint8_t *) source->pixels) + y * source->pitch + x * pixelFormats[source->format].bytesPerPixel;
+  tile.width = width;
+  tile.height = height;
+  return tile;
+}
+
+/* Splits an image too large for one texture into a grid of tiles */
+static int SetImageTiles(Splat_Image *image, const PixelSource *source, uint32_t tileSize) {
+  const uint32_t columns = (source->width + tileSize - 1) / tileSize;
+  const uint32_t rows = (source->height + tileSize - 1) / tileSize;
+  Splat_Texture **tiles = MemoryCalloc(SPLAT_MEMORY_IMAGE, columns * rows, sizeof(Splat_Texture *));
+  if (!tiles) {
+    Splat_SetError("Allocation failed while tiling image.");
+    return -1;
+  }
+
+  for (uint32_t i = 0; i < columns * rows; i++) {
+    Splat_Texture *tile = CreateTexture();
+    if (!tile) {
+      goto fail;
+    }
+    tiles[i] = tile;
+
+    tile->retainCount = image->retained ? 1 : 0;
+    tile->tile = true;
+    tile->x = (i % columns) * tileSize;
+    tile->y = (i / columns) * tileSize;
+
+    const PixelSource part = TileSource(source, tile->x, tile->y,
+                                        SDL_min(tileSize, source->width - tile->x), SDL_min(tileSize, source->height - tile->y));
+    if (UploadPixels(tile, image->flags, &part) != 0) {
+      goto fail;
+    }
+  }
+
+  ReleaseImageTextures(image);
+  image->tiles = tiles;
+  image->columns = columns;
+  image->rows = rows;
+  image->tileSize = tileSize;
+  image->width = source->width;
+  image->height = source->height;
+  return 0;
+
+fail:
+  for (uint32_t i = 0; i < columns * rows; i++) {
+    if (tiles[i]) {
+      ReleaseTexture(tiles[i]);
+    }
+  }
+  MemoryFree(tiles);
+  return -1;
+}
+
+/* Gives the image new contents, sharing an identical texture if the image allows it */
+static int SetImagePixels(Splat_Image *image, const PixelSource *source) {
+  uint64_t hash = 0;
+
+  if (image->target) {
+    Splat_SetError("Image is rendered into by a canvas and cannot be updated.");
+    return -1;
+  }
+
+  const uint32_t tileSize = GetTileSize();
+  if ((uint32_t) source->width > tileSize || (uint32_t) source->height > tileSize) {
+    return SetImageTiles(image, source, tileSize);
+  }
+
+  if (image->flags & SPLAT_IMAGE_DEDUPLICATE) {
+    hash = HashSource(source, WantsCompression(image->flags, source->format));
+
+    Splat_Texture *existing = FindTexture(hash, image->flags, source);
+    if (existing) {
+      if (existing != image->texture) {
+        if (image->retained && RetainTexture(existing) != 0) {
+          return -1;
+        }
+        existing->refcount++;
+        existing->retainCount += image->retained ? 1 : 0;
+        ReleaseImageTextures(image);
+        image->texture = existing;
+      }
+
+      image->width = source->width;
+      image->height = source->height;
+      return 0;
+    }
+  }
+
+  // Never overwrite a texture that other images are still using
+  Splat_Texture *texture = image->texture;
+  const bool fresh = !texture || texture->refcount > 1;
+  if (fresh) {
+    texture = CreateTexture();
+    if (!texture) {
+      return -1;
+    }
+    texture->retainCount = image->retained ? 1 : 0;
+  }
+
+  const bool evicted = !texture->resident && texture->bytes;
+  const uint32_t bytes = texture->bytes;
+
+  if (UploadPixels(texture, image->flags, source) != 0) {
+    if (fresh) {
+      ReleaseTexture(texture);
+    }
+    return -1;
+  }
+
+  // An evicted texture becomes resident again with its new contents
+  if (evicted) {
+    evictedBytes -= bytes;
+    evictedTextures--;
+  }
+
+  if (fresh) {
+    ReleaseImageTextures(image);
+    image->texture = texture;
+  }
+
+  texture->hash = hash;
+  texture->lastUsed = frame;
+  image->width = source->width;
+  image->height = source->height;
+
+  return 0;
+}
+
+static void EvictTexture(Splat_Texture *texture) {
+  glDeleteTextures(1, &texture->name);
+  texture->name = 0;
+  texture->resident = false;
+
+  residentBytes -= texture->bytes;
+  residentTextures--;
+  evictedBytes += texture->bytes;
+  evictedTextures++;
+  evictions++;
+}
+
+static int RestoreTexture(Splat_Texture *texture) {
+  const uint32_t bytes = texture->bytes;
+  int result = -1;
+
+  if (texture->pixels) {
+    result = UploadTexture(texture, texture->pixels, texture->internalFormat, texture->pixelFormat, texture->width, texture->height,
+                           texture->width * pixelFormats[texture->pixelFormat].bytesPerPixel);
+
+    // The copy was only kept to get here if every image has since released it
+    if (result == 0 && !texture->retainCount) {
+      MemoryFree(texture->pixels);
+      texture->pixels = NULL;
+    }
+  } else {
+    // Ask the first image using this texture that knows how to reload it
+    Splat_Image *image = images;
+    while (image && (!image->reload || !ImageUsesTexture(image, texture))) {
+      image = image->next;
+    }
+
+    if (!image) {
+      Splat_SetError("Evicted image has no retained pixels or reload callback.");
+      return -1;
+    }
+
+    SDL_Surface *surface = image->reload(image, image->reloadData);
+    if (!surface) {
+      Splat_SetError("Reload callback failed to restore an evicted image.");
+      return -1;
+    }
+
+    // Tiles only upload their part of the reloaded image
+    PixelSource source;
+    if (LockSurfaceSource(surface, &source) == 0) {
+      if (texture->x + texture->width > (uint32_t) source.width || texture->y + texture->height > (uint32_t) source.height) {
+        Splat_SetError("Reload callback returned a surface smaller than the evicted image.");
+      } else {
+        const PixelSource part = TileSource(&source, texture->x, texture->y, texture->width, texture->height);
+        result = UploadPixels(texture, image->flags, &part);
+      }
+      UnlockSurfaceSource(surface);
+    }
+    SDL_FreeSurface(surface);
+  }
+
+  if (result == 0) {
+    evictedBytes -= bytes;
+    evictedTextures--;
+    reloads++;
   }
 
-  // Set the surface width and height
-  image->width = surface->w;
-  image->height = surface->h;
+  return result;
+}
+
+void ImageBeginFrame() {
+  frame++;
+}
+
+int TextureBind(Splat_Texture *texture) {
+  if (!texture->resident && RestoreTexture(texture) != 0) {
+    return -1;
+  }
 
+  glBindTexture(GL_TEXTURE_2D, texture->name);
+  STAT_ADD(textureBinds, 1);
+  texture->lastUsed = frame;
   return 0;
 }
 
+int ImageBind(Splat_Image *image) {
+  return TextureBind(image->texture);
+}
+
+void ImageEnforceBudget() {
+  if ((!budget || residentBytes <= budget) && !tileReleaseDelay) {
+    return;
+  }
+
+  // Note which textures can be restored by a reload callback
+  for (Splat_Texture *curr = textures; curr != NULL; curr = curr->next) {
+    curr->reloadable = curr->pixels != NULL;
+  }
+  for (Splat_Image *curr = images; curr != NULL; curr = curr->next) {
+    if (curr->reload) {
+      int count;
+      Splat_Texture **list = ImageTextures(curr, &count);
+      for (int i = 0; i < count; i++) {
+        list[i]->reloadable = true;
+      }
+    }
+  }
+
+  // Release tiles that have been out of view for a while
+  if (tileReleaseDelay) {
+    for (Splat_Texture *curr = textures; curr != NULL; curr = curr->next) {
+      if (curr->tile && curr->resident && curr->reloadable && frame - curr->lastUsed > tileReleaseDelay) {
+        EvictTexture(curr);
+      }
+    }
+  }
+
+  while (budget && residentBytes > budget) {
+    // Find the least recently used texture that can be restored later
+    Splat_Texture *victim = NULL;
+    for (Splat_Texture *curr = textures; curr != NULL; curr = curr->next) {
+      if (curr->resident && curr->lastUsed != frame && curr->reloadable &&
+          (!victim || curr->lastUsed < victim->lastUsed)) {
+        victim = curr;
+      }
+    }
+
+    if (!victim) {
+      break;
+    }
+
+    EvictTexture(victim);
+  }
+}
+
+/* Allocates an image and gives it its first contents */
+static Splat_Image *CreateImage(const char *caller, uint32_t flags, const PixelSource *source) {
+  // Allocate the surface for this context
+  Splat_Image *image = PoolAlloc(&imagePool);
+  if (!image) {
+    Splat_SetError("%s:  Allocation failed.", caller);
+    return NULL;
+  }
+  memset(image, 0, sizeof(Splat_Image));
+  image->flags = flags;
+
+  const uint64_t trace = TraceBegin();
+  if (SetImagePixels(image, source) != 0) {
+    PoolFree(&imagePool, image);
+    return NULL;
+  }
+  TraceEnd(trace, caller, NULL, 0);
+
+  // Place new image at the top of the list.
+  image->next = images;
+  images = image;
+
+  ImageEnforceBudget();
+
+  return image;
+}
+
+Splat_Image *Splat_CreateImage(SDL_Surface *surface) {
+  return Splat_CreateImageWithFlags(surface, defaultFlags);
+}
+
+Splat_Image *Splat_CreateImageWithFlags(SDL_Surface *surface, uint32_t flags) {
+  if (!surface) {
+    Splat_SetError("Splat_CreateImage:  Invalid argument.");
+    return NULL;
+  }
+
+  PixelSource source;
+  if (LockSurfaceSource(surface, &source) != 0) {
+    return NULL;
+  }
+
+  Splat_Image *image = CreateImage("Splat_CreateImage", flags, &source);
+  UnlockSurfaceSource(surface);
+
+  return image;
+}
+
+Splat_Image *Splat_CreateImageFromPixels(const void *pixels, int width, int height, int pitch, uint32_t format) {
+  const PixelSource source = { pixels, width, height, pitch, format };
+  if (!ValidPixelSource(&source)) {
+    Splat_SetError("Splat_CreateImageFromPixels:  Invalid argument.");
+    return NULL;
+  }
+
+  return CreateImage("Splat_CreateImageFromPixels", defaultFlags, &source);
+}
+
+Splat_Image *Splat_CreateTargetImage(int width, int height) {
+  if (width <= 0 || height <= 0 || (uint32_t) width > GetTileSize() || (uint32_t) height > GetTileSize()) {
+    Splat_SetError("Splat_CreateTargetImage:  Invalid argument.");
+    return NULL;
+  }
+
+  Splat_Image *image = PoolAlloc(&imagePool);
+  if (!image) {
+    Splat_SetError("Splat_CreateTargetImage:  Allocation failed.");
+    return NULL;
+  }
+  memset(image, 0, sizeof(Splat_Image));
+
+  // Allocate the texture without contents; the canvas fills it in
+  Splat_Texture *texture = CreateTexture();
+  if (!texture || UploadTexture(texture, NULL, pixelFormats[SPLAT_PIXELFORMAT_RGBA32].internalFormat, SPLAT_PIXELFORMAT_RGBA32, width, height, width * 4) != 0) {
+    if (texture) {
+      ReleaseTexture(texture);
+    }
+    PoolFree(&imagePool, image);
+    return NULL;
+  }
+
+  image->texture = texture;
+  image->width = width;
+  image->height = height;
+  image->target = true;
+
+  // Place new image at the top of the list.
+  image->next = images;
+  images = image;
+
+  ImageEnforceBudget();
+
+  return image;
+}
+
+int Splat_UpdateImage(Splat_Image *image, SDL_Surface *surface) {
+  if (!surface || !image) {
+    Splat_SetError("Splat_UpdateImage:  Invalid argument.");
+    return 1;
+  }
+
+  PixelSource source;
+  if (LockSurfaceSource(surface, &source) != 0) {
+    return 1;
+  }
+
+  const uint64_t trace = TraceBegin();
+  int result = SetImagePixels(image, &source);
+  UnlockSurfaceSource(surface);
+  TraceEnd(trace, "Splat_UpdateImage", NULL, 0);
+
+  if (result != 0) {
+    return 1;
+  }
+
+  ImageEnforceBudget();
+  return 0;
+}
+
+int Splat_UpdateImageFromPixels(Splat_Image *image, const void *pixels, int width, int height, int pitch, uint32_t format) {
+  const PixelSource source = { pixels, width, height, pitch, format };
+  if (!image || !ValidPixelSource(&source)) {
+    Splat_SetError("Splat_UpdateImageFromPixels:  Invalid argument.");
+    return 1;
+  }
+
+  const uint64_t trace = TraceBegin();
+  if (SetImagePixels(image, &source) != 0) {
+    return 1;
+  }
+  TraceEnd(trace, "Splat_UpdateImageFromPixels", NULL, 0);
+
+  ImageEnforceBudget();
+  return 0;
+}
+
+void ImageAttach(Splat_Instance *instance, Splat_Image *image) {
+  if (instance->image) {
+    instance->image->instanceCount--;
+  }
+  if (image) {
+    image->instanceCount++;
+  }
+  instance->image = image;
+}
+
 int Splat_DestroyImage(Splat_Image *image) {
   if (!image) {
     Splat_SetError("Splat_DestroyImage:  Invalid argument.");
     return -1;
   }
 
+  // Instances dereference their image as they render
+  if (image->instanceCount > 0) {
+    Splat_SetError("Splat_DestroyImage:  Image is still used by %u instances.", image->instanceCount);
+    return -1;
+  }
+
   for (Splat_Image *prev = NULL, *curr = images; curr != NULL; prev = curr, curr = curr->next) {
     if (curr == image) {
       if (prev) {
@@ -161,8 +967,11 @@ int Splat_DestroyImage(Splat_Image *image) {
         images = curr->next;
       }
 
-      glDeleteTextures(1, &image->texture);
-      free(image);
+      QueuePurge(image);
+      AnimationDestroyAll(image);
+      CanvasReleaseTarget(image);
+      ReleaseImageTextures(image);
+      PoolFree(&imagePool, image);
       return 0;
     }
   }
@@ -177,3 +986,149 @@ int Splat_GetImageSize(Splat_Image *image, uint32_t *width, uint32_t *height) {
   return 0;
 }
 
+int Splat_SetDefaultImageFlags(uint32_t flags) {
+  defaultFlags = flags;
+  return 0;
+}
+
+int Splat_SetImageTileSize(uint32_t size) {
+  tileSizeLimit = size;
+  return 0;
+}
+
+int Splat_SetTileReleaseDelay(uint32_t frames) {
+  tileReleaseDelay = frames;
+  return 0;
+}
+
+int Splat_SetTextureBudget(uint64_t bytes) {
+  budget = bytes;
+  ImageEnforceBudget();
+  return 0;
+}
+
+int Splat_SetImageRetained(Splat_Image *image, int retain) {
+  if (!image) {
+    Splat_SetError("Splat_SetImageRetained:  Invalid argument.");
+    return -1;
+  }
+
+  if (image->target) {
+    Splat_SetError("Splat_SetImageRetained:  Image is rendered into by a canvas.");
+    return -1;
+  }
+
+  if (!retain == !image->retained) {
+    return 0;
+  }
+
+  int count;
+  Splat_Texture **list = ImageTextures(image, &count);
+
+  // Textures shared with other images keep their copy while any of those images retains it
+  if (!retain) {
+    for (int i = 0; i < count; i++) {
+      UnretainTexture(list[i]);
+    }
+    image->retained = false;
+    return 0;
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (RetainTexture(list[i]) != 0) {
+      // Drop the copies nothing else asked for
+      for (int j = 0; j < i; j++) {
+        if (!list[j]->retainCount && list[j]->resident) {
+          MemoryFree(list[j]->pixels);
+          list[j]->pixels = NULL;
+        }
+      }
+      return -1;
+    }
+  }
+
+  for (int i = 0; i < count; i++) {
+    list[i]->retainCount++;
+  }
+  image->retained = true;
+
+  return 0;
+}
+
+int Splat_SetImageReloadCallback(Splat_Image *image, Splat_ReloadCallback callback, void *userdata) {
+  if (!image) {
+    Splat_SetError("Splat_SetImageReloadCallback:  Invalid argument.");
+    return -1;
+  }
+
+  if (image->target) {
+    Splat_SetError("Splat_SetImageReloadCallback:  Image is rendered into by a canvas.");
+    return -1;
+  }
+
+  image->reload = callback;
+  image->reloadData = userdata;
+  return 0;
+}
+
+uint64_t ImageGpuBytes() {
+  return residentBytes;
+}
+
+int Splat_GetTextureStats(Splat_TextureStats *stats) {
+  if (!stats) {
+    Splat_SetError("Splat_GetTextureStats:  Invalid argument.");
+    return -1;
+  }
+
+  stats->budget = budget;
+  stats->residentBytes = residentBytes;
+  stats->evictedBytes = evictedBytes;
+  stats->residentTextures = residentTextures;
+  stats->evictedTextures = evictedTextures;
+  stats->evictions = evictions;
+  stats->reloads = reloads;
+
+  // Every reference beyond the first is an upload that was avoided
+  stats->sharedImages = 0;
+  stats->savedBytes = 0;
+  for (Splat_Texture *curr = textures; curr != NULL; curr = curr->next) {
+    stats->sharedImages += curr->refcount - 1;
+    stats->savedBytes += (uint64_t) (curr->refcount - 1) * curr->bytes;
+  }
+
+  return 0;
+}
+
+void ImageCaptureState() {
+  for (Splat_Texture *curr = textures; curr != NULL; curr = curr->next) {
+    // Evicted textures are captured as they are uploaded again
+    if (!curr->resident) {
+      continue;
+    }
+
+    const bool compressed = IsCompressedFormat(curr->internalFormat);
+    const GLenum format = compressed ? 0 : pixelFormats[curr->pixelFormat].format;
+    const GLenum type = compressed ? 0 : pixelFormats[curr->pixelFormat].type;
+    const int size = RetainedSize(curr);
+
+    // Use the retained copy if there is one, otherwise read the texture back
+    void *pixels = curr->pixels;
+    if (!pixels && (pixels = MemoryAlloc(SPLAT_MEMORY_OTHER, size))) {
+      glBindTexture(GL_TEXTURE_2D, curr->name);
+      if (compressed) {
+        glGetCompressedTexImage(GL_TEXTURE_2D, 0, pixels);
+      } else {
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glGetTexImage(GL_TEXTURE_2D, 0, format, type, pixels);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+      }
+    }
+
+    GLCaptureTexture(curr->name, curr->width, curr->height, curr->internalFormat, format, type, pixels, size);
+
+    if (pixels != curr->pixels) {
+      MemoryFree(pixels);
+    }
+  }
+}
@@ -0,0 +1,46 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_IMAGE_H__
+#define __SPLAT_IMAGE_H__
+
+#include "types.h"
+
+/* Advances the frame counter used to time-stamp images as they are bound */
+void ImageBeginFrame();
+
+/* Binds the texture, uploading it again first if it was evicted */
+int TextureBind(Splat_Texture *texture);
+
+/* Binds the texture of an image that is not tiled */
+int ImageBind(Splat_Image *image);
+
+/* Evicts least-recently-used textures until the texture budget is met */
+void ImageEnforceBudget();
+
+/* Points the instance at an image, keeping count of the instances using each image */
+void ImageAttach(Splat_Instance *instance, Splat_Image *image);
+
+/* Returns the bytes of image textures resident in video memory */
+uint64_t ImageGpuBytes();
+
+#endif // __SPLAT_IMAGE_H__
@@ -20,11 +20,16 @@
   3. This notice may not be removed or altered from any source distribution.
 */
 
+#include <math.h>
 #include <SDL.h>
 #include <SDL_opengl.h>
 #include "splat.h"
 #include "types.h"
 #include "canvas.h"
+#include "image.h"
+#include "memory.h"
+#include "queue.h"
+#include "trace.h"
 
 Splat_Instance *Splat_CreateInstance(Splat_Image *image, Splat_Layer *layer, int x, int y, float s1, float t1, float s2, float t2, uint32_t flags) {
   if (!layer) {
@@ -33,7 +38,7 @@ Splat_Instance *Splat_CreateInstance(Splat_Image *image, Splat_Layer *layer, int
   }
 
   // Allocate the instance
-  Splat_Instance *instance = malloc(sizeof(Splat_Instance));
+  Splat_Instance *instance = PoolAlloc(&instancePool);
   if (!instance) {
     Splat_SetError("Splat_CreateInstance:  Allocation failed.");
     return NULL;
@@ -44,7 +49,8 @@ Splat_Instance *Splat_CreateInstance(Splat_Image *image, Splat_Layer *layer, int
   layer->instances = instance;
 
   // Setup the handle
-  instance->texture = image->texture;
+  instance->image = NULL;
+  ImageAttach(instance, image);
   instance->rect.x = x;
   instance->rect.y = y;
   instance->rect.w = roundf(image->width * (s2 - s1));
@@ -62,6 +68,7 @@ Splat_Instance *Splat_CreateInstance(Splat_Image *image, Splat_Layer *layer, int
   instance->clip.x = instance->clip.y = instance->clip.w = instance->clip.h = 0;
   instance->flags = flags;
   instance->nextCulledHandle = NULL;
+  instance->animation = NULL;
 
   return instance;
 }
@@ -81,7 +88,9 @@ int Splat_DestroyInstance(Splat_Instance *instance) {
         layer->instances = curr->next;
       }
 
-      free(instance);
+      QueuePurge(instance);
+      ImageAttach(instance, NULL);
+      PoolFree(&instancePool, instance);
       return 0;
     }
   }
@@ -96,6 +105,11 @@ int Splat_SetInstancePosition(Splat_Instance *instance, int x, int y) {
     return -1;
   }
 
+  if (QueueDeferred()) {
+    const Command command = { COMMAND_POSITION, instance, { .position = { x, y } } };
+    return QueueCommand(&command);
+  }
+
   instance->rect.x = x;
   instance->rect.y = y;
   return 0;
@@ -107,6 +121,11 @@ int Splat_SetInstanceLayer(Splat_Instance *instance, Splat_Layer *layer) {
     return -1;
   }
 
+  if (QueueDeferred()) {
+    const Command command = { COMMAND_LAYER, instance, { .layer = layer } };
+    return QueueCommand(&command);
+  }
+
   // Don't do anything if we're trying to move
   if (layer == instance->layer) {
     return 0;
@@ -125,6 +144,7 @@ int Splat_SetInstanceLayer(Splat_Instance *instance, Splat_Layer *layer) {
       // Add instance to new layer
       instance->next = layer->instances;
       layer->instances = instance;
+      instance->layer = layer;
       return 0;
     }
   }
@@ -133,18 +153,36 @@ int Splat_SetInstanceLayer(Splat_Instance *instance, Splat_Layer *layer) {
   return -1;
 }
 
+/* Shows a subimage of the instance's image, sizing the instance to match */
+static void SetTexCoords(Splat_Instance *instance, float s1, float t1, float s2, float t2) {
+  instance->s1 = s1;
+  instance->t1 = t1;
+  instance->s2 = s2;
+  instance->t2 = t2;
+  instance->rect.w = roundf(instance->image->width * (s2 - s1));
+  instance->rect.h = roundf(instance->image->height * (t2 - t1));
+
+  // Setting the image by hand stops any animation
+  instance->animation = NULL;
+}
+
 int Splat_SetInstanceImage(Splat_Instance *instance, Splat_Image *image, float s1, float t1, float s2, float t2) {
-  if (!instance || !image) {
-    Splat_SetError("Splat_SetInstanceLayer:  Invalid argument.");
+  if (!instance) {
+    Splat_SetError("Splat_SetInstanceImage:  Invalid argument.");
     return -1;
   }
 
-  instance->texture = image->texture;
-  instance->s1 = s1;
-  instance->t1 = t1;
-  instance->s1 = s1;
-  instance->s1 = s1;
+  if (QueueDeferred()) {
+    const Command command = { COMMAND_IMAGE, instance, { .image = { image, s1, t1, s2, t2 } } };
+    return QueueCommand(&command);
+  }
 
+  // A NULL image only updates the subimage
+  if (image) {
+    ImageAttach(instance, image);
+  }
+
+  SetTexCoords(instance, s1, t1, s2, t2);
   return 0;
 }
 
@@ -154,7 +192,144 @@ int Splat_SetInstanceFlags(Splat_Instance *instance, uint32_t flags) {
     return -1;
   }
 
+  if (QueueDeferred()) {
+    const Command command = { COMMAND_FLAGS, instance, { .flags = flags } };
+    return QueueCommand(&command);
+  }
+
   instance->flags = flags;
   return 0;
 }
 
+int Splat_SetInstanceAngle(Splat_Instance *instance, float angle) {
+  if (!instance) {
+    Splat_SetError("Splat_SetInstanceAngle:  Invalid argument.");
+    return -1;
+  }
+
+  if (QueueDeferred()) {
+    const Command command = { COMMAND_ANGLE, instance, { .angle = angle } };
+    return QueueCommand(&command);
+  }
+
+  instance->angle = angle;
+  return 0;
+}
+
+int Splat_SetInstanceClip(Splat_Instance *instance, SDL_Rect *clip) {
+  if (!instance) {
+    Splat_SetError("Splat_SetInstanceClip:  Invalid argument.");
+    return -1;
+  }
+
+  if (QueueDeferred()) {
+    Command command = { COMMAND_CLIP, instance, { .clip = { 0, 0, 0, 0 } } };
+    if (clip) {
+      command.args.clip = *clip;
+    }
+    return QueueCommand(&command);
+  }
+
+  if (clip) {
+    instance->clip = *clip;
+  } else {
+    instance->clip.x = instance->clip.y = instance->clip.w = instance->clip.h = 0;
+  }
+  return 0;
+}
+
+/*
+ * Checks the arguments of the bulk setters, which change nothing unless
+ * every instance is valid.  Queued batches reserve room for every
+ * command first, so they are queued whole or not at all.
+ */
+static int CheckInstances(const char *caller, Splat_Instance **instances, const void *values, int count) {
+  if (!instances || !values || count < 0) {
+    Splat_SetError("%s:  Invalid argument.", caller);
+    return -1;
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (!instances[i]) {
+      Splat_SetError("%s:  Instance %d is NULL.", caller, i);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+int Splat_SetInstancesPosition(Splat_Instance **instances, const int32_t *positions, int count) {
+  if (CheckInstances("Splat_SetInstancesPosition", instances, positions, count) != 0) {
+    return -1;
+  }
+
+  const uint64_t trace = TraceBegin();
+  if (QueueDeferred()) {
+    if (QueueReserve(count) != 0) {
+      return -1;
+    }
+    for (int i = 0; i < count; i++) {
+      const Command command = { COMMAND_POSITION, instances[i], { .position = { positions[2 * i], positions[2 * i + 1] } } };
+      QueueCommand(&command);
+    }
+  } else {
+    for (int i = 0; i < count; i++) {
+      instances[i]->rect.x = positions[2 * i];
+      instances[i]->rect.y = positions[2 * i + 1];
+    }
+  }
+  TraceEnd(trace, "SetInstancesPosition", "count", count);
+
+  return 0;
+}
+
+int Splat_SetInstancesFlags(Splat_Instance **instances, const uint32_t *flags, int count) {
+  if (CheckInstances("Splat_SetInstancesFlags", instances, flags, count) != 0) {
+    return -1;
+  }
+
+  const uint64_t trace = TraceBegin();
+  if (QueueDeferred()) {
+    if (QueueReserve(count) != 0) {
+      return -1;
+    }
+    for (int i = 0; i < count; i++) {
+      const Command command = { COMMAND_FLAGS, instances[i], { .flags = flags[i] } };
+      QueueCommand(&command);
+    }
+  } else {
+    for (int i = 0; i < count; i++) {
+      instances[i]->flags = flags[i];
+    }
+  }
+  TraceEnd(trace, "SetInstancesFlags", "count", count);
+
+  return 0;
+}
+
+int Splat_SetInstancesTexCoords(Splat_Instance **instances, const float *texcoords, int count) {
+  if (CheckInstances("Splat_SetInstancesTexCoords", instances, texcoords, count) != 0) {
+    return -1;
+  }
+
+  const uint64_t trace = TraceBegin();
+  if (QueueDeferred()) {
+    if (QueueReserve(count) != 0) {
+      return -1;
+    }
+    for (int i = 0; i < count; i++) {
+      const float *st = texcoords + 4 * i;
+      const Command command = { COMMAND_IMAGE, instances[i], { .image = { NULL, st[0], st[1], st[2], st[3] } } };
+      QueueCommand(&command);
+    }
+  } else {
+    for (int i = 0; i < count; i++) {
+      const float *st = texcoords + 4 * i;
+      SetTexCoords(instances[i], st[0], st[1], st[2], st[3]);
+    }
+  }
+  TraceEnd(trace, "SetInstancesTexCoords", "count", count);
+
+  return 0;
+}
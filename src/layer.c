@@ -26,6 +26,9 @@
 #include "splat.h"
 #include "types.h"
 #include "canvas.h"
+#include "memory.h"
+#include "queue.h"
+#include "timer.h"
 
 Splat_Layer *Splat_CreateLayer(Splat_Canvas *canvas) {
   if (!canvas) {
@@ -34,7 +37,7 @@ Splat_Layer *Splat_CreateLayer(Splat_Canvas *canvas) {
   }
 
   // Allocate the layer
-  Splat_Layer *layer = malloc(sizeof(Splat_Layer));
+  Splat_Layer *layer = PoolAlloc(&layerPool);
   if (!layer) {
     Splat_SetError("Splat_CreateLayer:  Allocation failed.");
     return NULL;
@@ -42,6 +45,8 @@ Splat_Layer *Splat_CreateLayer(Splat_Canvas *canvas) {
 
   layer->canvas = canvas;
   layer->instances = NULL;
+  layer->timer = NULL;
+  layer->gpuTime = 0.0f;
   layer->next = NULL;
 
   // Place new layer at the bottom of the list.
@@ -73,7 +78,9 @@ int Splat_DestroyLayer(Splat_Layer *layer) {
         layer->canvas->layers = curr->next;
       }
 
-      free(layer);
+      QueuePurge(layer);
+      TimerDestroy(layer->timer);
+      PoolFree(&layerPool, layer);
       return 0;
     }
   }
@@ -96,7 +103,7 @@ int Splat_MoveLayer(Splat_Layer *layer, Splat_Layer *other) {
   Splat_Layer *layerPrev = NULL, *otherPrev = NULL;
   int found = 0;
 
-  for (Splat_Layer *prev = NULL, *curr = layer->canvas->layers; found < 4 && curr != NULL; prev = curr, curr = curr->next) {
+  for (Splat_Layer *prev = NULL, *curr = layer->canvas->layers; found < 3 && curr != NULL; prev = curr, curr = curr->next) {
     if (curr == layer) {
       layerPrev = prev;
       assert((found & 1) == 0);
@@ -115,6 +122,23 @@ int Splat_MoveLayer(Splat_Layer *layer, Splat_Layer *other) {
     return -1;
   }
 
+  // Adjacent layers point at each other, so swapping their next pointers would make one point at itself
+  if (layer->next == other || other->next == layer) {
+    Splat_Layer *first = (layer->next == other) ? layer : other;
+    Splat_Layer *second = (first == layer) ? other : layer;
+    Splat_Layer *firstPrev = (first == layer) ? layerPrev : otherPrev;
+
+    first->next = second->next;
+    second->next = first;
+    if (firstPrev) {
+      firstPrev->next = second;
+    } else {
+      layer->canvas->layers = second;
+    }
+
+    return 0;
+  }
+
   // Swap the next pointers for the two layers
   Splat_Layer *tmp = layer->next;
   layer->next = other->next;
@@ -0,0 +1,286 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+#include "splat.h"
+#include "types.h"
+#include "canvas.h"
+#include "capture.h"
+#include "image.h"
+#include "memory.h"
+#include "offscreen.h"
+#include "shader.h"
+
+/* Chunks start with this many slots, doubling with each chunk up to POOL_MAX_SLOTS */
+#define POOL_MIN_SLOTS 64
+#define POOL_MAX_SLOTS 4096
+
+extern SDL_Window *window;
+
+/* Precedes each allocation, keeping the memory after it aligned for any type */
+typedef union MemoryHeader {
+  struct {
+    size_t size;
+    Splat_MemoryType type;
+  } info;
+  long double alignDouble;
+  long long alignLong;
+  void *alignPointer;
+} MemoryHeader;
+
+typedef struct PoolChunk {
+  struct PoolChunk *next;
+  size_t bytes;
+  uint32_t slots;
+} PoolChunk;
+
+/* Space taken by a chunk header or slot, rounded up to keep objects aligned */
+#define ALIGNED_SIZE(size) (((size) + sizeof(MemoryHeader) - 1) / sizeof(MemoryHeader) * sizeof(MemoryHeader))
+
+Pool imagePool = { .type = SPLAT_MEMORY_IMAGE, .size = sizeof(Splat_Image) };
+Pool layerPool = { .type = SPLAT_MEMORY_LAYER, .size = sizeof(Splat_Layer) };
+Pool instancePool = { .type = SPLAT_MEMORY_INSTANCE, .size = sizeof(Splat_Instance) };
+Pool canvasPool = { .type = SPLAT_MEMORY_CANVAS, .size = sizeof(Splat_Canvas) };
+Pool rectPool = { .type = SPLAT_MEMORY_RECT, .size = sizeof(Splat_Rect) };
+Pool linePool = { .type = SPLAT_MEMORY_LINE, .size = sizeof(Splat_Line) };
+
+static Pool *pools[] = { &imagePool, &layerPool, &instancePool, &canvasPool, &rectPool, &linePool };
+
+static Splat_AllocFunction allocFunction = NULL;
+static Splat_FreeFunction freeFunction = NULL;
+static void *allocData = NULL;
+
+static uint64_t heapBytes = 0; // Held from the allocator, including headers and free slots
+static uint32_t heapBlocks = 0; // Blocks held from the allocator
+static uint64_t typeBytes[SPLAT_MEMORY_TYPES];
+
+static void *Allocate(size_t size) {
+  void *block = allocFunction ? allocFunction(size, allocData) : malloc(size);
+  if (block) {
+    heapBytes += size;
+    heapBlocks++;
+  }
+  return block;
+}
+
+static void Release(void *block, size_t size) {
+  heapBytes -= size;
+  heapBlocks--;
+  if (freeFunction) {
+    freeFunction(block, allocData);
+  } else {
+    free(block);
+  }
+}
+
+void *MemoryAlloc(Splat_MemoryType type, size_t size) {
+  MemoryHeader *header = Allocate(sizeof(MemoryHeader) + size);
+  if (!header) {
+    return NULL;
+  }
+
+  header->info.size = size;
+  header->info.type = type;
+  typeBytes[type] += size;
+  return header + 1;
+}
+
+void *MemoryCalloc(Splat_MemoryType type, size_t count, size_t size) {
+  if (size && count > SIZE_MAX / size) {
+    return NULL;
+  }
+
+  void *ptr = MemoryAlloc(type, count * size);
+  if (ptr) {
+    memset(ptr, 0, count * size);
+  }
+  return ptr;
+}
+
+void *MemoryRealloc(Splat_MemoryType type, void *ptr, size_t size) {
+  if (!ptr) {
+    return MemoryAlloc(type, size);
+  }
+
+  MemoryHeader *header = (MemoryHeader *) ptr - 1;
+  const size_t oldSize = header->info.size;
+
+  // Custom allocators have no realloc, so the block is moved
+  if (allocFunction) {
+    void *moved = MemoryAlloc(type, size);
+    if (moved) {
+      memcpy(moved, ptr, SDL_min(oldSize, size));
+      MemoryFree(ptr);
+    }
+    return moved;
+  }
+
+  const Splat_MemoryType oldType = header->info.type;
+  MemoryHeader *resized = realloc(header, sizeof(MemoryHeader) + size);
+  if (!resized) {
+    return NULL;
+  }
+
+  heapBytes = heapBytes - oldSize + size;
+  typeBytes[oldType] -= oldSize;
+  typeBytes[type] += size;
+  resized->info.size = size;
+  resized->info.type = type;
+  return resized + 1;
+}
+
+void MemoryFree(void *ptr) {
+  if (!ptr) {
+    return;
+  }
+
+  MemoryHeader *header = (MemoryHeader *) ptr - 1;
+  typeBytes[header->info.type] -= header->info.size;
+  Release(header, sizeof(MemoryHeader) + header->info.size);
+}
+
+/* Threads the slots of a chunk onto the pool's free list, first slot first */
+static void LinkChunk(Pool *pool, PoolChunk *chunk) {
+  const size_t slotSize = ALIGNED_SIZE(pool->size);
+  uint8_t *slots = (uint8_t *) chunk + ALIGNED_SIZE(sizeof(PoolChunk));
+  for (uint32_t i = chunk->slots; i-- > 0; /**/) {
+    void **slot = (void **) (slots + i * slotSize);
+    *slot = pool->freeSlots;
+    pool->freeSlots = slot;
+  }
+}
+
+/* Returns the pool's chunks to the allocator, except its first and smallest if asked */
+static void ReleaseChunks(Pool *pool, bool keepFirst) {
+  PoolChunk *kept = NULL;
+  while (pool->chunks) {
+    PoolChunk *chunk = pool->chunks;
+    pool->chunks = chunk->next;
+    if (keepFirst && !pool->chunks) {
+      kept = chunk;
+    } else {
+      Release(chunk, chunk->bytes);
+    }
+  }
+
+  pool->freeSlots = NULL;
+  pool->chunkSlots = 0;
+  if (kept) {
+    kept->next = NULL;
+    pool->chunks = kept;
+    pool->chunkSlots = SDL_min(kept->slots * 2, POOL_MAX_SLOTS);
+    LinkChunk(pool, kept);
+  }
+}
+
+void *PoolAlloc(Pool *pool) {
+  if (!pool->freeSlots) {
+    const uint32_t slots = pool->chunkSlots ? pool->chunkSlots : POOL_MIN_SLOTS;
+    const size_t bytes = ALIGNED_SIZE(sizeof(PoolChunk)) + slots * ALIGNED_SIZE(pool->size);
+    PoolChunk *chunk = Allocate(bytes);
+    if (!chunk) {
+      return NULL;
+    }
+
+    chunk->next = pool->chunks;
+    chunk->bytes = bytes;
+    chunk->slots = slots;
+    pool->chunks = chunk;
+    pool->chunkSlots = SDL_min(slots * 2, POOL_MAX_SLOTS);
+    LinkChunk(pool, chunk);
+  }
+
+  void **slot = pool->freeSlots;
+  pool->freeSlots = *slot;
+  pool->live++;
+  typeBytes[pool->type] += pool->size;
+  return slot;
+}
+
+void PoolFree(Pool *pool, void *object) {
+  if (!object) {
+    return;
+  }
+
+  void **slot = object;
+  *slot = pool->freeSlots;
+  pool->freeSlots = slot;
+  pool->live--;
+  typeBytes[pool->type] -= pool->size;
+
+  // Keep one chunk, so an object created and destroyed every frame does not reach the allocator
+  if (pool->live == 0 && pool->chunks && pool->chunks->next) {
+    ReleaseChunks(pool, true);
+  }
+}
+
+void MemoryFinish() {
+  for (size_t i = 0; i < SDL_arraysize(pools); i++) {
+    if (pools[i]->live == 0) {
+      ReleaseChunks(pools[i], false);
+    }
+  }
+}
+
+int Splat_SetAllocator(Splat_AllocFunction allocate, Splat_FreeFunction release, void *userdata) {
+  if (!allocate != !release) {
+    Splat_SetError("Splat_SetAllocator:  Invalid argument.");
+    return -1;
+  }
+
+  if (window || OffscreenActive()) {
+    Splat_SetError("Splat_SetAllocator:  Must be called before Splat_Prepare().");
+    return -1;
+  }
+
+  if (heapBlocks) {
+    Splat_SetError("Splat_SetAllocator:  Memory from the previous allocator is still in use.");
+    return -1;
+  }
+
+  allocFunction = allocate;
+  freeFunction = release;
+  allocData = userdata;
+  return 0;
+}
+
+int Splat_GetMemoryStats(Splat_MemoryStats *stats) {
+  if (!stats) {
+    Splat_SetError("Splat_GetMemoryStats:  Invalid argument.");
+    return -1;
+  }
+
+  memset(stats, 0, sizeof(Splat_MemoryStats));
+  stats->cpuBytes = heapBytes;
+  stats->gpuBytes = ImageGpuBytes() + CanvasGpuBytes() + ShaderGpuBytes();
+  for (int i = 0; i < SPLAT_MEMORY_TYPES; i++) {
+    stats->bytes[i] = typeBytes[i];
+  }
+  for (size_t i = 0; i < SDL_arraysize(pools); i++) {
+    stats->objects[pools[i]->type] += pools[i]->live;
+  }
+
+  return 0;
+}
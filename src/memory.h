@@ -0,0 +1,66 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_MEMORY_H__
+#define __SPLAT_MEMORY_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Heap memory of the library goes through these functions, which use
+ * the allocator set by Splat_SetAllocator and charge each allocation
+ * to a type for Splat_GetMemoryStats.
+ */
+void *MemoryAlloc(Splat_MemoryType type, size_t size);
+void *MemoryCalloc(Splat_MemoryType type, size_t count, size_t size);
+void *MemoryRealloc(Splat_MemoryType type, void *ptr, size_t size);
+void MemoryFree(void *ptr);
+
+/*
+ * Hands out objects of one size from chunks of slots, so objects that
+ * come and go every frame do not each cost a trip to the allocator.
+ * Chunks are returned to the allocator once no object is live.
+ */
+typedef struct Pool {
+  Splat_MemoryType type;
+  size_t size; /* Object size */
+  void *freeSlots; /* Linked through their first bytes */
+  struct PoolChunk *chunks;
+  uint32_t chunkSlots; /* Slots in the next chunk, doubling up to a limit */
+  uint32_t live; /* Objects handed out */
+} Pool;
+
+extern Pool imagePool;
+extern Pool layerPool;
+extern Pool instancePool;
+extern Pool canvasPool;
+extern Pool rectPool;
+extern Pool linePool;
+
+void *PoolAlloc(Pool *pool);
+void PoolFree(Pool *pool, void *object);
+
+/* Returns the chunks of empty pools to the allocator */
+void MemoryFinish();
+
+#endif // __SPLAT_MEMORY_H__
@@ -0,0 +1,159 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "splat.h"
+#include "offscreen.h"
+#include "present.h"
+
+#ifdef HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+static EGLDisplay display = EGL_NO_DISPLAY;
+static EGLContext context = EGL_NO_CONTEXT;
+#endif // HAVE_EGL
+
+extern SDL_Window *window;
+extern int defaultViewportWidth;
+extern int defaultViewportHeight;
+
+#ifdef HAVE_EGL
+/* Opens a display that needs no window system, falling back to the default display */
+static EGLDisplay GetDisplay() {
+  const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  if (extensions && strstr(extensions, "EGL_MESA_platform_surfaceless")) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+      EGLDisplay surfaceless = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+      if (surfaceless != EGL_NO_DISPLAY) {
+        return surfaceless;
+      }
+    }
+  }
+
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+#endif // HAVE_EGL
+
+bool OffscreenActive() {
+#ifdef HAVE_EGL
+  return context != EGL_NO_CONTEXT;
+#else
+  return false;
+#endif
+}
+
+int Splat_PrepareOffscreen(int width, int height) {
+  if (width <= 0 || height <= 0) {
+    Splat_SetError("Splat_PrepareOffscreen:  Invalid argument.");
+    return -1;
+  }
+
+#ifdef HAVE_EGL
+  if (window || context != EGL_NO_CONTEXT) {
+    Splat_SetError("Splat_PrepareOffscreen:  Splat is already prepared.");
+    return -1;
+  }
+
+  display = GetDisplay();
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+    Splat_SetError("Splat_PrepareOffscreen:  Unable to initialize EGL (0x%x).", eglGetError());
+    display = EGL_NO_DISPLAY;
+    return -1;
+  }
+
+  // Rendering goes to canvas framebuffers, so no surface is needed
+  const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+  if (!extensions || !strstr(extensions, "EGL_KHR_surfaceless_context")) {
+    Splat_SetError("Splat_PrepareOffscreen:  EGL does not support surfaceless contexts.");
+    OffscreenFinish();
+    return -1;
+  }
+
+  const EGLint configAttribs[] = {
+    EGL_SURFACE_TYPE, 0,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_RED_SIZE, 8,
+    EGL_GREEN_SIZE, 8,
+    EGL_BLUE_SIZE, 8,
+    EGL_ALPHA_SIZE, 8,
+    EGL_NONE
+  };
+  EGLConfig config;
+  EGLint configs = 0;
+  if (!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(display, configAttribs, &config, 1, &configs) || configs == 0) {
+    Splat_SetError("Splat_PrepareOffscreen:  No suitable EGL configuration (0x%x).", eglGetError());
+    OffscreenFinish();
+    return -1;
+  }
+
+  context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+  if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+    Splat_SetError("Splat_PrepareOffscreen:  OpenGL context creation failed (0x%x).", eglGetError());
+    OffscreenFinish();
+    return -1;
+  }
+
+  defaultViewportWidth = width;
+  defaultViewportHeight = height;
+
+  // Our shading model--Flat
+  glShadeModel(GL_FLAT);
+  glDisable(GL_DITHER);
+
+  PresentPrepare();
+
+  if (glGetError() != GL_NO_ERROR) {
+    Splat_SetError("Splat_PrepareOffscreen:  OpenGL error occurred during initialization");
+    OffscreenFinish();
+    return -1;
+  }
+
+  return 0;
+#else
+  Splat_SetError("Splat_PrepareOffscreen:  SplatGL was built without EGL support.");
+  return -1;
+#endif // HAVE_EGL
+}
+
+void OffscreenFinish() {
+#ifdef HAVE_EGL
+  if (display == EGL_NO_DISPLAY) {
+    return;
+  }
+
+  eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (context != EGL_NO_CONTEXT) {
+    eglDestroyContext(display, context);
+    context = EGL_NO_CONTEXT;
+  }
+
+  eglTerminate(display);
+  display = EGL_NO_DISPLAY;
+#endif // HAVE_EGL
+}
@@ -0,0 +1,34 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_OFFSCREEN_H__
+#define __SPLAT_OFFSCREEN_H__
+
+#include <stdbool.h>
+
+/* Returns true if Splat was prepared with Splat_PrepareOffscreen */
+bool OffscreenActive();
+
+/* Destroys the offscreen context, if any */
+void OffscreenFinish();
+
+#endif // __SPLAT_OFFSCREEN_H__
@@ -0,0 +1,174 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#define GL_GLEXT_PROTOTYPES
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "splat.h"
+#include "present.h"
+
+/* Most frames that can be limited in flight */
+#define MAX_FRAMES_IN_FLIGHT 8
+
+static int presentMode = SPLAT_PRESENT_VSYNC;
+static int maxFramesInFlight = 0;
+
+/* Window and mode the swap interval was last set for, as some platforms keep it per window */
+static SDL_Window *intervalWindow = NULL;
+static int intervalMode = -1;
+
+/* Fences marking the end of each queued frame, oldest first */
+static GLsync fences[MAX_FRAMES_IN_FLIGHT];
+static int fenceHead = 0;
+static int fenceCount = 0;
+static bool syncSupported = false;
+
+void PresentPrepare() {
+  // Both the SDL and the EGL context are created without a profile, so glGetString works for each
+  const char *version = (const char *) glGetString(GL_VERSION);
+  const char *extensions = (const char *) glGetString(GL_EXTENSIONS);
+  int major = 0, minor = 0;
+  if (version) {
+    while (*version && (*version < '0' || *version > '9')) {
+      version++;
+    }
+    sscanf(version, "%d.%d", &major, &minor);
+  }
+
+  syncSupported = major > 3 || (major == 3 && minor >= 2) || (extensions && strstr(extensions, "GL_ARB_sync"));
+}
+
+bool PresentSyncSupported() {
+  return syncSupported;
+}
+
+int Splat_SetPresentMode(int mode) {
+  if (mode < SPLAT_PRESENT_VSYNC || mode > SPLAT_PRESENT_IMMEDIATE) {
+    Splat_SetError("Splat_SetPresentMode:  Invalid argument.");
+    return -1;
+  }
+
+  presentMode = mode;
+  intervalWindow = NULL;
+  return 0;
+}
+
+int Splat_SetMaxFramesInFlight(int frames) {
+  if (frames < 0 || frames > MAX_FRAMES_IN_FLIGHT) {
+    Splat_SetError("Splat_SetMaxFramesInFlight:  Invalid argument.");
+    return -1;
+  }
+
+  maxFramesInFlight = frames;
+  return 0;
+}
+
+/* Removes the oldest fence, waiting for it to signal if asked */
+static bool RetireFence(bool wait) {
+  const int tail = (fenceHead + MAX_FRAMES_IN_FLIGHT - fenceCount) % MAX_FRAMES_IN_FLIGHT;
+
+  const GLenum status = glClientWaitSync(fences[tail], GL_SYNC_FLUSH_COMMANDS_BIT, wait ? GL_TIMEOUT_IGNORED : 0);
+  if (status == GL_TIMEOUT_EXPIRED) {
+    return false;
+  }
+
+  glDeleteSync(fences[tail]);
+  fences[tail] = NULL;
+  fenceCount--;
+  return true;
+}
+
+void PresentBeginFrame() {
+  // Drop fences of frames that have already finished
+  while (fenceCount > 0 && RetireFence(false)) {
+    /**/
+  }
+
+  // Block until the GPU catches up, so input sampled next is at most this many frames from the screen
+  while (maxFramesInFlight > 0 && fenceCount >= maxFramesInFlight) {
+    RetireFence(true);
+  }
+}
+
+/* Applies the present mode to the window, falling back to vsync if adaptive is unavailable */
+static void ApplyPresentMode(SDL_Window *window) {
+  if (window == intervalWindow && presentMode == intervalMode) {
+    return;
+  }
+
+  switch (presentMode) {
+    case SPLAT_PRESENT_ADAPTIVE:
+      if (SDL_GL_SetSwapInterval(-1) != 0) {
+        SDL_GL_SetSwapInterval(1);
+      }
+      break;
+    case SPLAT_PRESENT_IMMEDIATE:
+      SDL_GL_SetSwapInterval(0);
+      break;
+    default:
+      SDL_GL_SetSwapInterval(1);
+      break;
+  }
+
+  intervalWindow = window;
+  intervalMode = presentMode;
+}
+
+void PresentEndFrame(SDL_Window *window) {
+  if (window) {
+    ApplyPresentMode(window);
+
+    // Finish rendering by swap buffers
+    SDL_GL_SwapWindow(window);
+  }
+
+  if (maxFramesInFlight > 0) {
+    // Without fences the only way to bound the queue is to drain it
+    if (!syncSupported) {
+      glFinish();
+      return;
+    }
+
+    if (fenceCount == MAX_FRAMES_IN_FLIGHT) {
+      RetireFence(true);
+    }
+
+    fences[fenceHead] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    fenceHead = (fenceHead + 1) % MAX_FRAMES_IN_FLIGHT;
+    fenceCount++;
+  }
+}
+
+void PresentFinish() {
+  for (/**/; fenceCount > 0; fenceCount--) {
+    const int tail = (fenceHead + MAX_FRAMES_IN_FLIGHT - fenceCount) % MAX_FRAMES_IN_FLIGHT;
+    glDeleteSync(fences[tail]);
+    fences[tail] = NULL;
+  }
+
+  intervalWindow = NULL;
+  intervalMode = -1;
+  syncSupported = false;
+}
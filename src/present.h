@@ -0,0 +1,44 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_PRESENT_H__
+#define __SPLAT_PRESENT_H__
+
+#include <stdbool.h>
+#include <SDL.h>
+
+/* Detects sync object support once a context is current */
+void PresentPrepare();
+
+/* Returns true if the context has sync objects, from GL 3.2 or ARB_sync */
+bool PresentSyncSupported();
+
+/* Waits until fewer than the allowed number of frames are queued on the GPU */
+void PresentBeginFrame();
+
+/* Swaps the window, if any, and fences the frame so its completion can be tracked */
+void PresentEndFrame(SDL_Window *window);
+
+/* Releases outstanding fences */
+void PresentFinish();
+
+#endif // __SPLAT_PRESENT_H__
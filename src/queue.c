@@ -0,0 +1,350 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <SDL.h>
+#include "splat.h"
+#include "queue.h"
+
+#define QUEUE_BLOCK_COMMANDS 1024 // Commands per block of a queue
+
+/*
+ * Blocks of commands, linked in the order they were filled.  Only the
+ * producing thread writes commands and advances count, and the
+ * render thread only reads commands below count, so neither side
+ * takes a lock.
+ */
+typedef struct QueueBlock {
+  Command commands[QUEUE_BLOCK_COMMANDS];
+  SDL_atomic_t count; // Commands published by the producer
+  struct QueueBlock *next; // Set by the producer once the block is full
+} QueueBlock;
+
+typedef struct Queue {
+  QueueBlock *head; // Block the render thread applies from
+  int applied; // Commands of head already applied
+  QueueBlock *tail; // Block the producer writes to, only touched by the producer
+  QueueBlock *spare; // Stack of applied blocks, pushed by the render thread and popped by the producer
+  QueueBlock *reserved; // Stack of empty blocks set aside by QueueReserve, only touched by the producer
+  SDL_atomic_t claimed; // Non-zero while a thread owns the queue
+} Queue;
+
+static SDL_atomic_t threaded; // Non-zero while other threads may queue calls
+static unsigned long renderThread = 0;
+static SDL_TLSID queueKey = 0; // Index + 1 of the queue the thread owns
+static Queue queues[SPLAT_MAX_THREAD_QUEUES];
+
+/* Releases a thread's queue as it exits, so another thread may claim it */
+static void SDLCALL ReleaseQueue(void *value) {
+  if (value) {
+    SDL_AtomicSet(&queues[(uintptr_t) value - 1].claimed, 0);
+  }
+}
+
+/* Returns the calling thread's queue, claiming the first free one if it has none */
+static Queue *ThreadQueue() {
+  const uintptr_t value = (uintptr_t) SDL_TLSGet(queueKey);
+  if (value) {
+    return &queues[value - 1];
+  }
+
+  for (uintptr_t i = 0; i < SPLAT_MAX_THREAD_QUEUES; i++) {
+    if (SDL_AtomicCAS(&queues[i].claimed, 0, 1)) {
+      SDL_TLSSet(queueKey, (void *) (i + 1), ReleaseQueue);
+      return &queues[i];
+    }
+  }
+
+  return NULL;
+}
+
+/* Returns an empty block, reusing one the render thread has applied if possible */
+static QueueBlock *TakeBlock(Queue *queue) {
+  QueueBlock *block;
+  do {
+    block = SDL_AtomicGetPtr((void **) &queue->spare);
+  } while (block && !SDL_AtomicCASPtr((void **) &queue->spare, block, block->next));
+
+  // The allocator set by Splat_SetAllocator need not be thread-safe
+  if (!block && !(block = malloc(sizeof(QueueBlock)))) {
+    return NULL;
+  }
+
+  SDL_AtomicSet(&block->count, 0);
+  block->next = NULL;
+  return block;
+}
+
+/* Returns the block to continue the queue with, using a reserved one first */
+static QueueBlock *NextBlock(Queue *queue) {
+  QueueBlock *block = queue->reserved;
+  if (block) {
+    queue->reserved = block->next;
+    block->next = NULL;
+    return block;
+  }
+
+  return TakeBlock(queue);
+}
+
+static void ReturnBlock(Queue *queue, QueueBlock *block) {
+  do {
+    block->next = SDL_AtomicGetPtr((void **) &queue->spare);
+  } while (!SDL_AtomicCASPtr((void **) &queue->spare, block->next, block));
+}
+
+bool QueueDeferred() {
+  return SDL_AtomicGet(&threaded) && SDL_ThreadID() != renderThread;
+}
+
+int QueueCommand(const Command *command) {
+  Queue *queue = ThreadQueue();
+  if (!queue) {
+    Splat_SetError("Too many threads are queueing calls.");
+    return -1;
+  }
+
+  QueueBlock *block = queue->tail;
+  if (!block) {
+    if (!(block = NextBlock(queue))) {
+      Splat_SetError("Unable to allocate a command queue.");
+      return -1;
+    }
+    queue->tail = block;
+    SDL_AtomicSetPtr((void **) &queue->head, block);
+  }
+
+  int count = SDL_AtomicGet(&block->count);
+  if (count == QUEUE_BLOCK_COMMANDS) {
+    QueueBlock *next = NextBlock(queue);
+    if (!next) {
+      Splat_SetError("Unable to allocate a command queue.");
+      return -1;
+    }
+    SDL_AtomicSetPtr((void **) &block->next, next);
+    queue->tail = block = next;
+    count = 0;
+  }
+
+  block->commands[count] = *command;
+  SDL_AtomicSet(&block->count, count + 1); // Publishes the command to the render thread
+  return 0;
+}
+
+int QueueReserve(int count) {
+  Queue *queue = ThreadQueue();
+  if (!queue) {
+    Splat_SetError("Too many threads are queueing calls.");
+    return -1;
+  }
+
+  int space = queue->tail ? QUEUE_BLOCK_COMMANDS - SDL_AtomicGet(&queue->tail->count) : 0;
+  for (QueueBlock *block = queue->reserved; block != NULL; block = block->next) {
+    space += QUEUE_BLOCK_COMMANDS;
+  }
+
+  while (space < count) {
+    QueueBlock *block = TakeBlock(queue);
+    if (!block) {
+      Splat_SetError("Unable to allocate a command queue.");
+      return -1;
+    }
+    block->next = queue->reserved;
+    queue->reserved = block;
+    space += QUEUE_BLOCK_COMMANDS;
+  }
+
+  return 0;
+}
+
+static void Apply(Command *command) {
+  // Arguments were checked when the call was queued
+  switch (command->type) {
+    case COMMAND_POSITION:
+      Splat_SetInstancePosition(command->instance, command->args.position.x, command->args.position.y);
+      break;
+    case COMMAND_LAYER:
+      Splat_SetInstanceLayer(command->instance, command->args.layer);
+      break;
+    case COMMAND_IMAGE:
+      Splat_SetInstanceImage(command->instance, command->args.image.image, command->args.image.s1, command->args.image.t1, command->args.image.s2, command->args.image.t2);
+      break;
+    case COMMAND_FLAGS:
+      Splat_SetInstanceFlags(command->instance, command->args.flags);
+      break;
+    case COMMAND_ANGLE:
+      Splat_SetInstanceAngle(command->instance, command->args.angle);
+      break;
+    case COMMAND_CLIP:
+      Splat_SetInstanceClip(command->instance, &command->args.clip);
+      break;
+    case COMMAND_PLAY_ANIMATION:
+      Splat_PlayAnimation(command->instance, command->args.play.animation, command->args.play.loop);
+      break;
+    case COMMAND_STOP_ANIMATION:
+      Splat_StopAnimation(command->instance);
+      break;
+    case COMMAND_PURGED:
+      break;
+  }
+}
+
+static bool References(const Command *command, const void *object) {
+  if (command->instance == object) {
+    return true;
+  }
+
+  switch (command->type) {
+    case COMMAND_LAYER:
+      return command->args.layer == object;
+    case COMMAND_IMAGE:
+      return command->args.image.image == object;
+    case COMMAND_PLAY_ANIMATION:
+      return command->args.play.animation == object;
+    default:
+      return false;
+  }
+}
+
+void QueuePurge(const void *object) {
+  // Published commands are only read and written by the render thread, like QueueApply
+  for (int i = 0; i < SPLAT_MAX_THREAD_QUEUES; i++) {
+    Queue *queue = &queues[i];
+    int applied = queue->applied;
+    for (QueueBlock *block = SDL_AtomicGetPtr((void **) &queue->head); block != NULL; ) {
+      const int count = SDL_AtomicGet(&block->count);
+      for (int j = applied; j < count; j++) {
+        if (References(&block->commands[j], object)) {
+          block->commands[j].type = COMMAND_PURGED;
+        }
+      }
+
+      block = count == QUEUE_BLOCK_COMMANDS ? SDL_AtomicGetPtr((void **) &block->next) : NULL;
+      applied = 0;
+    }
+  }
+}
+
+void QueueApply() {
+  for (int i = 0; i < SPLAT_MAX_THREAD_QUEUES; i++) {
+    Queue *queue = &queues[i];
+    QueueBlock *block = SDL_AtomicGetPtr((void **) &queue->head);
+    while (block) {
+      const int count = SDL_AtomicGet(&block->count);
+      while (queue->applied < count) {
+        Apply(&block->commands[queue->applied++]);
+      }
+
+      // The producer links the next block only once this one is full
+      QueueBlock *next = count == QUEUE_BLOCK_COMMANDS ? SDL_AtomicGetPtr((void **) &block->next) : NULL;
+      if (!next) {
+        break;
+      }
+
+      SDL_AtomicSetPtr((void **) &queue->head, next);
+      queue->applied = 0;
+      ReturnBlock(queue, block);
+      block = next;
+    }
+  }
+}
+
+void QueueFinish() {
+  QueueApply();
+  SDL_AtomicSet(&threaded, 0);
+
+  for (int i = 0; i < SPLAT_MAX_THREAD_QUEUES; i++) {
+    Queue *queue = &queues[i];
+    for (QueueBlock *block = queue->head, *next; block != NULL; block = next) {
+      next = block->next;
+      free(block);
+    }
+    for (QueueBlock *block = queue->spare, *next; block != NULL; block = next) {
+      next = block->next;
+      free(block);
+    }
+    for (QueueBlock *block = queue->reserved, *next; block != NULL; block = next) {
+      next = block->next;
+      free(block);
+    }
+    queue->head = queue->tail = queue->spare = queue->reserved = NULL;
+    queue->applied = 0;
+  }
+}
+
+int Splat_SetThreadedUpdates(int enable) {
+  if (!enable) {
+    SDL_AtomicSet(&threaded, 0);
+    QueueApply();
+    return 0;
+  }
+
+  if (!queueKey && !(queueKey = SDL_TLSCreate())) {
+    Splat_SetError("Splat_SetThreadedUpdates:  Unable to create thread-local storage.");
+    return -1;
+  }
+
+  renderThread = SDL_ThreadID();
+  SDL_AtomicSet(&threaded, 1);
+  return 0;
+}
+
+int Splat_SetThreadQueue(int index) {
+  if (index < 0 || index >= SPLAT_MAX_THREAD_QUEUES) {
+    Splat_SetError("Splat_SetThreadQueue:  Invalid argument.");
+    return -1;
+  }
+
+  if (!SDL_AtomicGet(&threaded)) {
+    Splat_SetError("Splat_SetThreadQueue:  Threaded updates are not enabled.");
+    return -1;
+  }
+
+  const uintptr_t value = (uintptr_t) SDL_TLSGet(queueKey);
+  if (value == (uintptr_t) index + 1) {
+    return 0;
+  }
+
+  if (!SDL_AtomicCAS(&queues[index].claimed, 0, 1)) {
+    Splat_SetError("Splat_SetThreadQueue:  Queue is owned by another thread.");
+    return -1;
+  }
+
+  // Give up the previous queue; commands already in it are still applied
+  if (value) {
+    ReleaseQueue((void *) value);
+  }
+  SDL_TLSSet(queueKey, (void *) ((uintptr_t) index + 1), ReleaseQueue);
+  return 0;
+}
+
+int Splat_ReleaseThreadQueue() {
+  const uintptr_t value = queueKey ? (uintptr_t) SDL_TLSGet(queueKey) : 0;
+  if (value) {
+    // Commands already in the queue are still applied
+    SDL_TLSSet(queueKey, NULL, NULL);
+    ReleaseQueue((void *) value);
+  }
+
+  return 0;
+}
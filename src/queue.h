@@ -0,0 +1,81 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_QUEUE_H__
+#define __SPLAT_QUEUE_H__
+
+#include <stdbool.h>
+#include <SDL.h>
+#include "types.h"
+
+typedef enum {
+  COMMAND_POSITION,
+  COMMAND_LAYER,
+  COMMAND_IMAGE,
+  COMMAND_FLAGS,
+  COMMAND_ANGLE,
+  COMMAND_CLIP,
+  COMMAND_PLAY_ANIMATION,
+  COMMAND_STOP_ANIMATION,
+  COMMAND_PURGED, // Refers to a destroyed object and is skipped
+} CommandType;
+
+/* A deferred call to one of the instance mutation functions */
+typedef struct Command {
+  CommandType type;
+  Splat_Instance *instance;
+  union {
+    SDL_Point position;
+    Splat_Layer *layer;
+    struct {
+      Splat_Image *image;
+      float s1, t1, s2, t2;
+    } image;
+    uint32_t flags;
+    float angle;
+    SDL_Rect clip;
+    struct {
+      Splat_Animation *animation;
+      int loop;
+    } play;
+  } args;
+} Command;
+
+/* Returns true if calls on this thread must be queued rather than applied */
+bool QueueDeferred();
+
+/* Queues a command from the calling thread, returning -1 if it cannot be queued */
+int QueueCommand(const Command *command);
+
+/* Sets aside room for count more commands from the calling thread, so queuing them cannot fail */
+int QueueReserve(int count);
+
+/* Drops queued commands that refer to an object about to be destroyed */
+void QueuePurge(const void *object);
+
+/* Applies queued commands, queue by queue in index order */
+void QueueApply();
+
+/* Applies outstanding commands and releases the queues */
+void QueueFinish();
+
+#endif // __SPLAT_QUEUE_H__
@@ -21,24 +21,33 @@
 */
 
 #define GL_GLEXT_PROTOTYPES
+#include <math.h>
 #include <SDL_opengl.h>
 #include <GL/glu.h>
 
 #include "splat.h"
+#include "animation.h"
 #include "canvas.h"
+#include "capture.h"
+#include "glcapture.h"
+#include "glrecord.h"
+#include "image.h"
+#include "memory.h"
+#include "offscreen.h"
+#include "present.h"
+#include "queue.h"
+#include "shader.h"
+#include "stats.h"
+#include "timer.h"
+#include "trace.h"
 #include "types.h"
 
 #define MASK_IMAGEMOD (SPLAT_MIRROR_X | SPLAT_MIRROR_Y | SPLAT_MIRROR_DIAG | SPLAT_ROTATE)
 
 SDL_Window *window = NULL;
 SDL_GLContext window_glcontext = NULL;
-GLuint framebuffer = 0;
-GLuint frameTexture = 0;
-int viewportWidth = 0;
-int viewportHeight = 0;
-GLuint vertexShader = 0;
-GLuint fragmentShader = 0;
-GLuint shaderProgram = 0;
+int defaultViewportWidth = 0;
+int defaultViewportHeight = 0;
 
 static float vertex_buffer[18]; /* Vertex buffer */
 static float texcoord_buffer[12]; /* TexCoord buffer */
@@ -52,20 +61,160 @@ static float texcoord_buffer[12]; /* TexCoord buffer */
     } \
   }
 
-int Splat_Render(Splat_Canvas *canvas) {
-  if (!canvas) {
-    Splat_SetError("Splat_Render:  Invalid argument.");
-    return -1;
+/* Draws a textured quad.  (x1, y1) is textured with (s1, t1) and (x2, y2) with (s2, t2). */
+static int DrawQuad(float x1, float y1, float x2, float y2, float s1, float t1, float s2, float t2, float depth) {
+  // First triangle
+  //glTexCoord2f(s1, t2);
+  texcoord_buffer[0] = s1;
+  texcoord_buffer[1] = t2;
+  //glVertex3f(x1, y2, depth);
+  vertex_buffer[0] = x1;
+  vertex_buffer[1] = y2;
+  vertex_buffer[2] = depth;
+
+  //glTexCoord2f(s1, t1);
+  texcoord_buffer[2] = s1;
+  texcoord_buffer[3] = t1;
+  //glVertex3f(x1, y1, depth);
+  vertex_buffer[3] = x1;
+  vertex_buffer[4] = y1;
+  vertex_buffer[5] = depth;
+
+  //glTexCoord2f(s2, t1);
+  texcoord_buffer[4] = s2;
+  texcoord_buffer[5] = t1;
+  //glVertex3f(x2, y1, depth);
+  vertex_buffer[6] = x2;
+  vertex_buffer[7] = y1;
+  vertex_buffer[8] = depth;
+
+  // Second triangle
+  //glTexCoord2f(s2, t2);
+  texcoord_buffer[6] = s2;
+  texcoord_buffer[7] = t2;
+  //glVertex3f(x2, y2, depth);
+  vertex_buffer[9] = x2;
+  vertex_buffer[10] = y2;
+  vertex_buffer[11] = depth;
+
+  //glTexCoord2f(s1, t2);
+  texcoord_buffer[8] = s1;
+  texcoord_buffer[9] = t2;
+  //glVertex3f(x1, y2, depth);
+  vertex_buffer[12] = x1;
+  vertex_buffer[13] = y2;
+  vertex_buffer[14] = depth;
+
+  //glTexCoord2f(s2, t1);
+  texcoord_buffer[10] = s2;
+  texcoord_buffer[11] = t1;
+  //glVertex3f(x2, y1, depth);
+  vertex_buffer[15] = x2;
+  vertex_buffer[16] = y1;
+  vertex_buffer[17] = depth;
+
+  // Finished with our triangles
+  glDrawArrays(GL_TRIANGLES, 0, 6); ERRCHECK();
+  STAT_ADD(drawCalls, 1);
+
+  return 0;
+}
+
+/*
+ * Draws an instance of a tiled image one tile at a time.  Tiles outside
+ * the visible rect, given in the instance's coordinates, are skipped.
+ */
+static int DrawTiles(Splat_Instance *instance, float width, float height, const SDL_Rect *visible, float depth) {
+  Splat_Image *image = instance->image;
+
+  // Portion of the image shown by the instance, in pixels
+  const float u1 = instance->s1 * image->width;
+  const float u2 = instance->s2 * image->width;
+  const float v1 = instance->t1 * image->height;
+  const float v2 = instance->t2 * image->height;
+  if (u1 == u2 || v1 == v2) {
+    return 0;
   }
 
-  int winwidth, winheight;
+  const uint32_t firstColumn = fminf(u1, u2) / image->tileSize;
+  const uint32_t lastColumn = SDL_min((uint32_t) ceilf(fmaxf(u1, u2) / image->tileSize), image->columns);
+  const uint32_t firstRow = fminf(v1, v2) / image->tileSize;
+  const uint32_t lastRow = SDL_min((uint32_t) ceilf(fmaxf(v1, v2) / image->tileSize), image->rows);
+
+  for (uint32_t row = firstRow; row < lastRow; row++) {
+    for (uint32_t column = firstColumn; column < lastColumn; column++) {
+      Splat_Texture *tile = image->tiles[row * image->columns + column];
+
+      // Part of the tile within the portion shown
+      const float ua = fmaxf(fminf(u1, u2), tile->x);
+      const float ub = fminf(fmaxf(u1, u2), tile->x + tile->width);
+      const float va = fmaxf(fminf(v1, v2), tile->y);
+      const float vb = fminf(fmaxf(v1, v2), tile->y + tile->height);
+      if (ua >= ub || va >= vb) {
+        continue;
+      }
+
+      // Where that part lands within the instance
+      const float xa = (ua - u1) / (u2 - u1) * width;
+      const float xb = (ub - u1) / (u2 - u1) * width;
+      const float ya = (va - v1) / (v2 - v1) * height;
+      const float yb = (vb - v1) / (v2 - v1) * height;
+
+      if (visible && (fmaxf(xa, xb) <= visible->x || fminf(xa, xb) >= visible->x + visible->w ||
+                      fmaxf(ya, yb) <= visible->y || fminf(ya, yb) >= visible->y + visible->h)) {
+        continue;
+      }
+
+      if (TextureBind(tile) != 0) {
+        return -1;
+      }
+
+      if (DrawQuad(xa, ya, xb, yb, (ua - tile->x) / tile->width, (va - tile->y) / tile->height,
+                   (ub - tile->x) / tile->width, (vb - tile->y) / tile->height, depth) != 0) {
+        return -1;
+      }
+    }
+  }
+
+  return 0;
+}
+
+/* Renders the canvas into its framebuffer */
+static int RenderCanvas(Splat_Canvas *canvas) {
+  const int viewportWidth = canvas->viewportWidth;
+  const int viewportHeight = canvas->viewportHeight;
   SDL_Rect scaledRect;
 
-  SDL_GetWindowSize(window, &winwidth, &winheight);
+  // Images expect their top row first, which is the bottom row of the framebuffer
+  const bool flipY = !canvas->target;
+
+  StatsReset(canvas);
+  StatsBind(canvas);
+
+  if (canvas->gpuProfiling) {
+    CanvasCollectGpuTimes(canvas);
+  }
+
+  // Dynamic resolution renders into the lower left of the framebuffer and the blit scales it back up
+  CanvasUpdateResolution(canvas);
+  const int renderWidth = canvas->renderWidth;
+  const int renderHeight = canvas->renderHeight;
+  const float resolution = (float) renderWidth / viewportWidth;
+  if (canvas->timer) {
+    TimerBegin(canvas->timer);
+  }
+
+  // Let the application move the view as late as possible
+  if (canvas->lateLatch) {
+    canvas->lateLatch(canvas, canvas->lateLatchData);
+  }
+
+  // One clock for every animation on the canvas this frame
+  canvas->time = SDL_GetTicks();
 
   /* Render to our framebuffer */
-  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer); ERRCHECK();
-  glViewport(0, 0, viewportWidth, viewportHeight); ERRCHECK();
+  glBindFramebuffer(GL_FRAMEBUFFER, canvas->framebuffer); ERRCHECK();
+  glViewport(0, 0, renderWidth, renderHeight); ERRCHECK();
 
   // Change to the projection matrix and set up our ortho view
   glMatrixMode(GL_PROJECTION); ERRCHECK();
@@ -75,26 +224,29 @@ int Splat_Render(Splat_Canvas *canvas) {
   // Set up modelview for 2D integer coordinates
   glMatrixMode(GL_MODELVIEW); ERRCHECK();
   glLoadIdentity(); ERRCHECK();
-  glTranslatef(0.375f, viewportHeight + 0.375f, 0.0f); ERRCHECK();
-  glScalef(1.0f, -1.0f, 0.001f); ERRCHECK(); // Make the positive Z-axis point "out" from the view (e.g images at depth 4 will be higher than those at depth 0), and swap the Y axis
+  if (flipY) {
+    glTranslatef(0.375f, viewportHeight + 0.375f, 0.0f); ERRCHECK();
+    glScalef(1.0f, -1.0f, 0.001f); ERRCHECK(); // Make the positive Z-axis point "out" from the view (e.g images at depth 4 will be higher than those at depth 0), and swap the Y axis
+  } else {
+    glTranslatef(0.375f, 0.375f, 0.0f); ERRCHECK();
+    glScalef(1.0f, 1.0f, 0.001f); ERRCHECK();
+  }
 
   // Clear the color and depth buffers.
+  glClearColor(canvas->clearColor[0], canvas->clearColor[1], canvas->clearColor[2], canvas->clearColor[3]); ERRCHECK();
   glClear(GL_COLOR_BUFFER_BIT); ERRCHECK();
 
   // Enable textures and blending
   glEnable(GL_TEXTURE_2D); ERRCHECK();
   glEnable(GL_BLEND); ERRCHECK();
-  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); ERRCHECK();
-
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); ERRCHECK();
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST); ERRCHECK();
+  // Accumulate coverage in alpha, so the canvas can be composited over another
+  glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA); ERRCHECK();
 
   // Save the current matrix
   glPushMatrix(); ERRCHECK();
 
   // Scale as necessary
   glScalef(canvas->scale[0], canvas->scale[1], 1.0f); ERRCHECK();
-  bool scaledCanvas = !(canvas->scale[0] == 1.0f && canvas->scale[1] == 1.0f);
 
   // Specify vertex and tex coord buffers
   glVertexPointer(3, GL_FLOAT, 0, vertex_buffer); ERRCHECK();
@@ -102,22 +254,33 @@ int Splat_Render(Splat_Canvas *canvas) {
   glTexCoordPointer(2, GL_FLOAT, 0, texcoord_buffer); ERRCHECK();
   glEnableClientState(GL_TEXTURE_COORD_ARRAY); ERRCHECK();
 
+  // Visible area in canvas coordinates
   SDL_Rect viewRect;
   viewRect.x = canvas->origin.x;
   viewRect.y = canvas->origin.y;
-  viewRect.w = viewportWidth;
-  viewRect.h = viewportHeight;
+  viewRect.w = ceilf(viewportWidth / canvas->scale[0]);
+  viewRect.h = ceilf(viewportHeight / canvas->scale[1]);
 
+  uint64_t start = SDL_GetPerformanceCounter();
   float depth = 0.0f;
   for (Splat_Layer *layer = canvas->layers; layer != NULL; layer = layer->next) {
+    const uint64_t layerTrace = TraceBegin();
+    if (layer->timer) {
+      TimerBegin(layer->timer);
+    }
+
     for (Splat_Instance *instance = layer->instances; instance != NULL; instance = instance->next) {
-      //TODO do this once per texture
-      // Bind our texture
-      glBindTexture(GL_TEXTURE_2D, instance->texture); ERRCHECK();
+      STAT_ADD(instancesVisited, 1);
+
+      if (instance->animation) {
+        AnimateInstance(instance, canvas->time);
+      }
 
       if ((instance->flags & SPLAT_RELATIVE) != 0 && !SDL_HasIntersection(&instance->rect, &viewRect)) {
+        STAT_ADD(instancesCulled, 1);
         continue;
       }
+      STAT_ADD(instancesDrawn, 1);
 
       // Save the current matrix
       glPushMatrix(); ERRCHECK();
@@ -132,6 +295,7 @@ int Splat_Render(Splat_Canvas *canvas) {
 
       // Set color for rendering
       glColor4ub(instance->color.r, instance->color.g, instance->color.b, instance->color.a); ERRCHECK();
+      STAT_ADD(stateChanges, 1);
 
       // Scale the render rect
       scaledRect.x = instance->rect.x;
@@ -174,83 +338,66 @@ int Splat_Render(Splat_Canvas *canvas) {
         // Enable scissoring
         glEnable(GL_SCISSOR_TEST); ERRCHECK();
 
-        // Snip, snip, snip...
-        if (scaledCanvas) {
-          glScissor(instance->clip.x * canvas->scale[0], winheight - ((instance->clip.y + instance->clip.h) * canvas->scale[1]), instance->clip.w * canvas->scale[0], instance->clip.h * canvas->scale[1]); ERRCHECK();
-        } else {
-          glScissor(instance->clip.x, winheight - (instance->clip.y + instance->clip.h), instance->clip.w, instance->clip.h); ERRCHECK();
-        }
+        // Snip, snip, snip...  The clip is in canvas coordinates, the scissor in framebuffer pixels
+        const float sx = canvas->scale[0] * resolution;
+        const float sy = canvas->scale[1] * resolution;
+        const float y = flipY ? renderHeight - ((instance->clip.y + instance->clip.h) * sy) : instance->clip.y * sy;
+        glScissor(instance->clip.x * sx, y, instance->clip.w * sx, instance->clip.h * sy); ERRCHECK();
+        STAT_ADD(stateChanges, 2);
       } else {
         // Disable scissoring
         glDisable(GL_SCISSOR_TEST); ERRCHECK();
+        STAT_ADD(stateChanges, 1);
       }
 
-      // Prepare to render triangles
-
-      // First triangle
-      //glTexCoord2f(instance->s1, instance->t2);
-      texcoord_buffer[0] = instance->s1;
-      texcoord_buffer[1] = instance->t2;
-      //glVertex3f(0.0f, scaled_rect.h, depth);
-      vertex_buffer[0] = 0.0f;
-      vertex_buffer[1] = scaledRect.h;
-      vertex_buffer[2] = depth;
-
-      //glTexCoord2f(instance->s1, instance->t1);
-      texcoord_buffer[2] = instance->s1;
-      texcoord_buffer[3] = instance->t1;
-      //glVertex3f(0.0f, 0.0f, depth);
-      vertex_buffer[3] = 0.0f;
-      vertex_buffer[4] = 0.0f;
-      vertex_buffer[5] = depth;
-
-      //glTexCoord2f(instance->s2, instance->t1);
-      texcoord_buffer[4] = instance->s2;
-      texcoord_buffer[5] = instance->t1;
-      //glVertex3f(scaled_rect.w, 0.0f, depth);
-      vertex_buffer[6] = scaledRect.w;
-      vertex_buffer[7] = 0.0f;
-      vertex_buffer[8] = depth;
-
-      // Second triangle
-      //glTexCoord2f(instance->s2, instance->t2);
-      texcoord_buffer[6] = instance->s2;
-      texcoord_buffer[7] = instance->t2;
-      //glVertex3f(scaled_rect.w, scaled_rect.h, depth);
-      vertex_buffer[9] = scaledRect.w;
-      vertex_buffer[10] = scaledRect.h;
-      vertex_buffer[11] = depth;
-
-      //glTexCoord2f(instance->s1, instance->t2);
-      texcoord_buffer[8] = instance->s1;
-      texcoord_buffer[9] = instance->t2;
-      //glVertex3f(0.0f, scaled_rect.h, depth);
-      vertex_buffer[12] = 0.0f;
-      vertex_buffer[13] = scaledRect.h;
-      vertex_buffer[14] = depth;
-
-      //glTexCoord2f(instance->s2, instance->t1);
-      texcoord_buffer[10] = instance->s2;
-      texcoord_buffer[11] = instance->t1;
-      //glVertex3f(scaled_rect.w, 0.0f, depth);
-      vertex_buffer[15] = scaledRect.w;
-      vertex_buffer[16] = 0.0f;
-      vertex_buffer[17] = depth;
+      if (instance->image->tiles) {
+        // Tiles can only be culled if the instance isn't mirrored or rotated
+        SDL_Rect visible;
+        const bool cullTiles = (instance->flags & MASK_IMAGEMOD) == 0;
+        if (cullTiles) {
+          visible.x = ((instance->flags & SPLAT_RELATIVE) ? viewRect.x : 0) - instance->rect.x;
+          visible.y = ((instance->flags & SPLAT_RELATIVE) ? viewRect.y : 0) - instance->rect.y;
+          visible.w = viewRect.w;
+          visible.h = viewRect.h;
+        }
 
-      // Finished with our triangles
-      glDrawArrays(GL_TRIANGLES, 0, 6); ERRCHECK();
+        if (DrawTiles(instance, scaledRect.w, scaledRect.h, cullTiles ? &visible : NULL, depth) != 0) {
+          return -1;
+        }
+      } else {
+        //TODO do this once per texture
+        // Bind our texture, uploading it again if it was evicted
+        if (ImageBind(instance->image) != 0) {
+          return -1;
+        }
+
+        if (DrawQuad(0.0f, 0.0f, scaledRect.w, scaledRect.h, instance->s1, instance->t1, instance->s2, instance->t2, depth) != 0) {
+          return -1;
+        }
+      }
 
       // Finished with our triangles
       glPopMatrix(); ERRCHECK();
     }
 
+    if (layer->timer) {
+      TimerEnd(layer->timer);
+    }
+    TraceEnd(layerTrace, "Layer", "layer", (int) depth);
+
     depth += 1.0f;
   }
 
   // Disable scissoring
   glDisable(GL_SCISSOR_TEST); ERRCHECK();
+  frameStats->layerTime = StatsElapsed(start);
 
-  uint32_t time = SDL_GetTicks();
+  uint32_t time = canvas->time;
+  start = SDL_GetPerformanceCounter();
+  const uint64_t debugTrace = TraceBegin();
+  if (canvas->debugTimer) {
+    TimerBegin(canvas->debugTimer);
+  }
 
   // Draw rects
   if (canvas->rects) {
@@ -261,6 +408,7 @@ int Splat_Render(Splat_Canvas *canvas) {
 
     for (Splat_Rect *prev = NULL, *curr = canvas->rects; curr != NULL; /**/) {
       glColor4ub(curr->color.r, curr->color.g, curr->color.b, curr->color.a); ERRCHECK();
+      STAT_ADD(stateChanges, 1);
 
       // Save the current matrix
       glPushMatrix(); ERRCHECK();
@@ -296,6 +444,7 @@ int Splat_Render(Splat_Canvas *canvas) {
 
         // Finished with our triangles
         glDrawArrays(GL_TRIANGLES, 0, 6); ERRCHECK();
+        STAT_ADD(drawCalls, 1);
       } else {
         vertex_buffer[0] = curr->x1;
         vertex_buffer[1] = curr->y1;
@@ -311,6 +460,7 @@ int Splat_Render(Splat_Canvas *canvas) {
 
         // Finished with our lines
         glDrawArrays(GL_LINE_LOOP, 0, 4); ERRCHECK();
+        STAT_ADD(drawCalls, 1);
       }
 
       // Restore the old matrix
@@ -326,7 +476,7 @@ int Splat_Render(Splat_Canvas *canvas) {
         
         Splat_Rect *old = curr;
         curr = curr->next;
-        free(old);
+        PoolFree(&rectPool, old);
       } else {
         prev = curr;
         curr = curr->next;
@@ -340,6 +490,7 @@ int Splat_Render(Splat_Canvas *canvas) {
     glDisableClientState(GL_TEXTURE_COORD_ARRAY); ERRCHECK();
     for (Splat_Line *prev = NULL, *curr = canvas->lines; curr != NULL; /**/) {
       glColor4ub(curr->color.r, curr->color.g, curr->color.b, curr->color.a); ERRCHECK();
+      STAT_ADD(stateChanges, 1);
 
       if (!curr->relative) {
         // Translate to the active canvas's current location
@@ -352,6 +503,7 @@ int Splat_Render(Splat_Canvas *canvas) {
 
       // Finished with our triangles
       glDrawArrays(GL_LINES, 0, 2); ERRCHECK();
+      STAT_ADD(drawCalls, 1);
 
       // Expire old lines
       if (time >= curr->ttl) {
@@ -363,7 +515,7 @@ int Splat_Render(Splat_Canvas *canvas) {
 
         Splat_Line *old = curr;
         curr = curr->next;
-        free(old);
+        PoolFree(&linePool, old);
       } else {
         prev = curr;
         curr = curr->next;
@@ -373,12 +525,243 @@ int Splat_Render(Splat_Canvas *canvas) {
 
   // Restore original, non-scaled matrix
   glPopMatrix(); ERRCHECK();
+  frameStats->debugTime = StatsElapsed(start);
+  TraceEnd(debugTrace, "Debug primitives", NULL, 0);
+  if (canvas->debugTimer) {
+    TimerEnd(canvas->debugTimer);
+  }
+
+  if (canvas->timer) {
+    TimerEnd(canvas->timer);
+  }
+
+  StatsBind(NULL);
+
+  return 0;
+}
+
+/*
+ * Draws the canvas' framebuffer into a rect of the window, scaling it to fit.
+ * Every post-process pass but the last renders into an intermediate target
+ * the size of the rect; the last draws into the window.
+ */
+static int BlitCanvas(Splat_Canvas *canvas, const SDL_Rect *dest, int winwidth, int winheight, bool blend) {
+  GLuint source = canvas->frameTexture;
+  int inputWidth = canvas->renderWidth;
+  int inputHeight = canvas->renderHeight;
+  int textureWidth = canvas->viewportWidth;
+  int textureHeight = canvas->viewportHeight;
+
+  if (canvas->blitTimer) {
+    TimerBegin(canvas->blitTimer);
+  }
+
+  if (canvas->programCount > 1) {
+    glDisable(GL_BLEND); ERRCHECK();
+
+    // Intermediate passes draw in normalized device coordinates
+    glMatrixMode(GL_PROJECTION); ERRCHECK();
+    glPushMatrix(); ERRCHECK();
+    glLoadIdentity(); ERRCHECK();
+    glMatrixMode(GL_MODELVIEW); ERRCHECK();
+    glPushMatrix(); ERRCHECK();
+    glLoadIdentity(); ERRCHECK();
+
+    for (int pass = 0; pass < canvas->programCount - 1; pass++) {
+      GLuint target;
+      int targetWidth, targetHeight;
+      if (ShaderBindTarget(pass % 2, dest->w, dest->h, &target, &targetWidth, &targetHeight) != 0) {
+        return -1;
+      }
+      glViewport(0, 0, dest->w, dest->h); ERRCHECK();
+
+      glBindTexture(GL_TEXTURE_2D, source); ERRCHECK();
+      if (ProgramUse(canvas->programs[pass], inputWidth, inputHeight, textureWidth, textureHeight, dest->w, dest->h) != 0) {
+        return -1;
+      }
+      STAT_ADD(textureBinds, 1);
+      STAT_ADD(stateChanges, 1);
+
+      // Intermediate targets keep the frame texture's bottom-up rows
+      if (DrawQuad(-1.0f, -1.0f, 1.0f, 1.0f, 0.0f, 0.0f, (float) inputWidth / textureWidth, (float) inputHeight / textureHeight, 0.0f) != 0) {
+        return -1;
+      }
+
+      source = target;
+      inputWidth = dest->w;
+      inputHeight = dest->h;
+      textureWidth = targetWidth;
+      textureHeight = targetHeight;
+    }
+
+    glPopMatrix(); ERRCHECK();
+    glMatrixMode(GL_PROJECTION); ERRCHECK();
+    glPopMatrix(); ERRCHECK();
+    glMatrixMode(GL_MODELVIEW); ERRCHECK();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0); ERRCHECK();
+    glViewport(0, 0, winwidth, winheight); ERRCHECK();
+  }
+
+  // Canvases after the first are drawn over the ones beneath
+  if (blend) {
+    glEnable(GL_BLEND); ERRCHECK();
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA); ERRCHECK();
+  } else {
+    glDisable(GL_BLEND); ERRCHECK();
+  }
+  STAT_ADD(stateChanges, 1);
+
+  glBindTexture(GL_TEXTURE_2D, source); ERRCHECK();
+  STAT_ADD(textureBinds, 1);
+
+  if (canvas->programCount > 0) {
+    if (ProgramUse(canvas->programs[canvas->programCount - 1], inputWidth, inputHeight, textureWidth, textureHeight, dest->w, dest->h) != 0) {
+      return -1;
+    }
+    STAT_ADD(stateChanges, 1);
+  }
+
+  // The frame texture is stored bottom-up, so flip it vertically
+  if (DrawQuad(dest->x, dest->y, dest->x + dest->w, dest->y + dest->h,
+               0.0f, (float) inputHeight / textureHeight, (float) inputWidth / textureWidth, 0.0f, 0.0f) != 0) {
+    return -1;
+  }
+
+  if (canvas->programCount > 0) {
+    glUseProgram(0); ERRCHECK();
+  }
+
+  if (canvas->blitTimer) {
+    TimerEnd(canvas->blitTimer);
+  }
+
+  return 0;
+}
+
+int Splat_Render(Splat_Canvas *canvas) {
+  if (!canvas) {
+    Splat_SetError("Splat_Render:  Invalid argument.");
+    return -1;
+  }
+
+  return Splat_RenderCanvases(&canvas, 1, NULL);
+}
+
+int Splat_RenderCanvases(Splat_Canvas **canvases, int count, const SDL_Rect *viewports) {
+  if (!canvases || count <= 0) {
+    Splat_SetError("Splat_RenderCanvases:  Invalid argument.");
+    return -1;
+  }
+
+  // Instance updates queued by other threads land before anything else happens
+  QueueApply();
+
+  for (int i = 0; i < count; i++) {
+    if (!canvases[i]) {
+      Splat_SetError("Splat_RenderCanvases:  Invalid argument.");
+      return -1;
+    }
+
+    if (canvases[i]->target) {
+      Splat_SetError("Splat_RenderCanvases:  Canvas renders to an image.");
+      return -1;
+    }
+
+    // Canvases not attached to a window use the one given to Splat_Prepare
+    if (!canvases[i]->framebuffer) {
+      if (window) {
+        if (Splat_AttachCanvas(canvases[i], window, defaultViewportWidth, defaultViewportHeight) != 0) {
+          return -1;
+        }
+      } else if (OffscreenActive()) {
+        if (CanvasAttachOffscreen(canvases[i], defaultViewportWidth, defaultViewportHeight) != 0) {
+          return -1;
+        }
+      } else {
+        Splat_SetError("Splat_RenderCanvases:  Splat_Prepare has not been called.");
+        return -1;
+      }
+    }
+
+    if (canvases[i]->window != canvases[0]->window) {
+      Splat_SetError("Splat_RenderCanvases:  Canvases are attached to different windows.");
+      return -1;
+    }
+  }
+
+  SDL_Window *target = canvases[0]->window;
+  if (target && SDL_GL_GetCurrentWindow() != target && SDL_GL_MakeCurrent(target, window_glcontext) != 0) {
+    Splat_SetError("Splat_RenderCanvases:  Unable to render to window.  Check SDL_GetError() for more information.");
+    return -1;
+  }
+
+  // Wait for queued frames before sampling anything for this one
+  PresentBeginFrame();
+
+  if (target) {
+    int winwidth, winheight;
+    SDL_GetWindowSize(target, &winwidth, &winheight);
+    GLCaptureBeginFrame(winwidth, winheight);
+  } else {
+    GLCaptureBeginFrame(canvases[0]->viewportWidth, canvases[0]->viewportHeight);
+  }
+
+  ImageBeginFrame();
+  ShaderBeginFrame();
+
+  // Refresh canvases rendered into images before anything samples them
+  const uint32_t now = SDL_GetTicks();
+  for (Splat_Canvas *curr = CanvasFirst(); curr != NULL; curr = curr->next) {
+    if (CanvasRefreshDue(curr, now)) {
+      if (RenderCanvas(curr) != 0) {
+        StatsBind(NULL);
+        return -1;
+      }
+      StatsFrameEnd(curr);
+
+      if (curr->capture && CaptureFrame(curr) != 0) {
+        return -1;
+      }
+    }
+  }
+
+  for (int i = 0; i < count; i++) {
+    const uint64_t trace = TraceBegin();
+    if (RenderCanvas(canvases[i]) != 0) {
+      StatsBind(NULL);
+      return -1;
+    }
+    TraceEnd(trace, "RenderCanvas", "canvas", i);
+
+    if (canvases[i]->capture && CaptureFrame(canvases[i]) != 0) {
+      return -1;
+    }
+  }
+
+  // Offscreen canvases stay in their framebuffers for Splat_ReadPixels
+  if (!target) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0); ERRCHECK();
+    PresentEndFrame(NULL);
+    GLCaptureEndFrame();
+    for (int i = 0; i < count; i++) {
+      StatsFrameEnd(canvases[i]);
+    }
+    ImageEnforceBudget();
+    return 0;
+  }
+
+  int winwidth, winheight;
+  SDL_GetWindowSize(target, &winwidth, &winheight);
 
   // Render to the screen
   glBindFramebuffer(GL_FRAMEBUFFER, 0); ERRCHECK();
   glViewport(0, 0, winwidth, winheight); ERRCHECK(); // Render on the whole framebuffer, complete from the lower left corner to the upper right
 
-  glDisable(GL_BLEND); ERRCHECK();
+  // Parts of the window outside the viewports are otherwise left as the swap found them
+  glClearColor(0.0f, 0.0f, 0.0f, 1.0f); ERRCHECK();
+  glClear(GL_COLOR_BUFFER_BIT); ERRCHECK();
+
   glEnable(GL_TEXTURE_2D); ERRCHECK();
 
   // Specify vertex and tex coord buffers
@@ -398,117 +781,43 @@ int Splat_Render(Splat_Canvas *canvas) {
   glTranslatef(0.375f, winheight + 0.375f, 0.0f); ERRCHECK();
   glScalef(1.0f, -1.0f, 0.001f); ERRCHECK(); // Make the positive Z-axis point "out" from the view (e.g images at depth 4 will be higher than those at depth 0), and swap the Y axis
 
-  glBindTexture(GL_TEXTURE_2D, frameTexture); ERRCHECK();
   glColor4ub(255, 255, 255, 255); ERRCHECK();
 
-#ifdef SPLAT_SHADERS_EXPERIMENTAL
-  glUseProgram(shaderProgram); ERRCHECK();
-
-  if (shaderProgram) {
-    float size[2];
-    GLint uniform;
-
-    size[0] = viewportWidth;
-    size[1] = viewportHeight;
-    uniform = glGetUniformLocation(shaderProgram, "rubyInputSize"); ERRCHECK();
-    glUniform2fv(uniform, 1, size); ERRCHECK();
-
-    uniform = glGetUniformLocation(shaderProgram, "rubyTextureSize"); ERRCHECK();
-    glUniform2fv(uniform, 1, size); ERRCHECK();
-
-    size[0] = winwidth;
-    size[1] = winheight;
-    uniform = glGetUniformLocation(shaderProgram, "rubyOutputSize"); ERRCHECK();
-    glUniform2fv(uniform, 1, size); ERRCHECK();
+  // Scale each canvas up once, into its own part of the window
+  const SDL_Rect fullWindow = { 0, 0, winwidth, winheight };
+  for (int i = 0; i < count; i++) {
+    const uint64_t trace = TraceBegin();
+    const uint64_t start = SDL_GetPerformanceCounter();
+    StatsBind(canvases[i]);
+    const int result = BlitCanvas(canvases[i], viewports ? &viewports[i] : &fullWindow, winwidth, winheight, i > 0);
+    StatsBind(NULL);
+    if (result != 0) {
+      return -1;
+    }
+    canvases[i]->stats.blitTime = StatsElapsed(start);
+    TraceEnd(trace, "Blit", "canvas", i);
   }
-#endif // SPLAT_SHADERS_EXPERIMENTAL
 
-  // First triangle
-  //glTexCoord2f(handle->s1, handle->t2);
-  texcoord_buffer[0] = 0.0f;
-  texcoord_buffer[1] = 0.0f;
-  //glVertex3f(0.0f, scaled_rect.h, handle->depth);
-  vertex_buffer[0] = 0.0f;
-  vertex_buffer[1] = (float) winheight;
-  vertex_buffer[2] = 0.0f;
-
-  //glTexCoord2f(handle->s1, handle->t1);
-  texcoord_buffer[2] = 0.0f;
-  texcoord_buffer[3] = 1.0f;
-  //glVertex3f(0.0f, 0.0f, handle->depth);
-  vertex_buffer[3] = 0.0f;
-  vertex_buffer[4] = 0.0f;
-  vertex_buffer[5] = 0.0f;
-
-  //glTexCoord2f(handle->s2, handle->t1);
-  texcoord_buffer[4] = 1.0f;
-  texcoord_buffer[5] = 1.0f;
-  //glVertex3f(scaled_rect.w, 0.0f, handle->depth);
-  vertex_buffer[6] = (float) winwidth;
-  vertex_buffer[7] = 0.0f;
-  vertex_buffer[8] = 0.0f;
-
-  // Second triangle
-  //glTexCoord2f(handle->s2, handle->t2);
-  texcoord_buffer[6] = 1.0f;
-  texcoord_buffer[7] = 0.0f;
-  //glVertex3f(scaled_rect.w, scaled_rect.h, handle->depth);
-  vertex_buffer[9] = (float) winwidth;
-  vertex_buffer[10] = (float) winheight;
-  vertex_buffer[11] = 0.0f;
-
-  //glTexCoord2f(handle->s1, handle->t2);
-  texcoord_buffer[8] = 0.0f;
-  texcoord_buffer[9] = 0.0f;
-  //glVertex3f(0.0f, scaled_rect.h, handle->depth);
-  vertex_buffer[12] = 0.0f;
-  vertex_buffer[13] = (float) winheight;
-  vertex_buffer[14] = 0.0f;
-
-  //glTexCoord2f(handle->s2, handle->t1);
-  texcoord_buffer[10] = 1.0f;
-  texcoord_buffer[11] = 1.0f;
-  //glVertex3f(scaled_rect.w, 0.0f, handle->depth);
-  vertex_buffer[15] = (float) winwidth;
-  vertex_buffer[16] = 0.0f;
-  vertex_buffer[17] = 0.0f;
-
-  // Finished with our triangles
-  glDrawArrays(GL_TRIANGLES, 0, 6); ERRCHECK();
-
-#ifdef SPLAT_SHADERS_EXPERIMENTAL
-  glUseProgram(0); ERRCHECK();
-#endif // SPLAT_SHADERS_EXPERIMENTAL
-
-  // Finish rendering by swap buffers
-  SDL_GL_SwapWindow(window);
-
-#if ENABLE_FPS_LOG
-  fps_lastframe = fps_frametime;
-  fps_frametime = SDL_GetTicks();
-  Uint32 current_fps = 1.0f / (((float) (fps_frametime - fps_lastframe)) / 1000.0f);
-  fps_max = current_fps > fps_max ? current_fps : fps_max;
-  fps_min = current_fps < fps_min ? current_fps : fps_min;
-  fps_times[fps_index] = current_fps;
-  fps_index++;
-  if (fps_index > MAX_FPS_INDEX) {
-    fps_index = 0;
+  const uint64_t trace = TraceBegin();
+  const uint64_t start = SDL_GetPerformanceCounter();
+  PresentEndFrame(target);
+  const float swapTime = StatsElapsed(start);
+  GLCaptureEndFrame();
+  TraceEnd(trace, "Swap", NULL, 0);
+
+  uint32_t drawCalls = 0;
+  uint64_t bytesUploaded = 0;
+  for (int i = 0; i < count; i++) {
+    canvases[i]->stats.swapTime = swapTime;
+    StatsFrameEnd(canvases[i]);
+    drawCalls += canvases[i]->stats.drawCalls;
+    bytesUploaded += canvases[i]->stats.bytesUploaded;
   }
+  TraceCounter("Draw calls", drawCalls);
+  TraceCounter("Bytes uploaded", bytesUploaded);
 
-  if (fps_frametime > fps_next_update) {
-    Uint32 i, total = 0, fps;
-    for (i = 0; i < MAX_FPS_INDEX; i++) {
-      total += fps_times[i];
-    }
-    fps = total / MAX_FPS_INDEX;
-    printf("FPS:  %d (%d to %d)\n", fps, fps_min, fps_max);
-
-    // Reset min/max and set next print time
-    fps_min = (Uint32) -1;
-    fps_max = 0;
-    fps_next_update = fps_frametime + 2000;
-  }
-#endif
+  // Evict textures that were not needed this frame if over budget
+  ImageEnforceBudget();
 
   return 0;
 }
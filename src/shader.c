@@ -0,0 +1,588 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#define GL_GLEXT_PROTOTYPES
+#include <stdio.h>
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "splat.h"
+#include "types.h"
+#include "canvas.h"
+#include "glcapture.h"
+#include "glrecord.h"
+#include "hash.h"
+#include "memory.h"
+#include "shader.h"
+
+#ifndef PACKAGE_VERSION
+#define PACKAGE_VERSION "unknown"
+#endif
+
+/* Identifies a program binary cache file */
+#define CACHE_MAGIC "SPLATPB1"
+
+static Splat_Shader *shaders = NULL;
+static Splat_Program *programs = NULL;
+static uint32_t frameCount = 0;
+static char *cacheDirectory = NULL;
+
+/* Intermediate render targets, alternated between passes */
+static struct {
+  GLuint framebuffer;
+  GLuint texture;
+  int width;
+  int height;
+} targets[2];
+
+/* Copies a string with MemoryAlloc, so it can be released with MemoryFree */
+static char *CopyString(const char *string) {
+  const size_t length = strlen(string) + 1;
+  char *copy = MemoryAlloc(SPLAT_MEMORY_OTHER, length);
+  if (copy) {
+    memcpy(copy, string, length);
+  }
+  return copy;
+}
+
+static const GLenum shaderTypes[] = {
+  GL_VERTEX_SHADER,   /* SPLAT_VERTEX_SHADER */
+  GL_FRAGMENT_SHADER, /* SPLAT_FRAGMENT_SHADER */
+  GL_GEOMETRY_SHADER, /* SPLAT_GEOMETRY_SHADER */
+};
+
+Splat_Shader *Splat_CreateShader(const char *source, int shaderType) {
+  if (!source || shaderType < SPLAT_VERTEX_SHADER || shaderType > SPLAT_GEOMETRY_SHADER) {
+    Splat_SetError("Splat_CreateShader:  Invalid argument.");
+    return NULL;
+  }
+
+  Splat_Shader *shader = MemoryAlloc(SPLAT_MEMORY_OTHER, sizeof(Splat_Shader));
+  if (!shader) {
+    Splat_SetError("Splat_CreateShader:  Allocation failed.");
+    return NULL;
+  }
+  memset(shader, 0, sizeof(Splat_Shader));
+  shader->type = shaderType;
+
+  // Compiling waits until link time, when the program may come from the cache instead
+  shader->source = CopyString(source);
+  if (!shader->source) {
+    Splat_SetError("Splat_CreateShader:  Allocation failed.");
+    MemoryFree(shader);
+    return NULL;
+  }
+
+  // Place new shader at the top of the list.
+  shader->next = shaders;
+  shaders = shader;
+
+  return shader;
+}
+
+int Splat_DestroyShader(Splat_Shader *shader) {
+  if (!shader) {
+    Splat_SetError("Splat_DestroyShader:  Invalid argument.");
+    return -1;
+  }
+
+  for (Splat_Shader *prev = NULL, *curr = shaders; curr != NULL; prev = curr, curr = curr->next) {
+    if (curr == shader) {
+      if (prev) {
+        prev->next = curr->next;
+      } else {
+        shaders = curr->next;
+      }
+
+      // Programs the shader is attached to keep their own copy of the source
+      MemoryFree(shader->source);
+      MemoryFree(shader);
+      return 0;
+    }
+  }
+
+  Splat_SetError("Splat_DestroyShader:  Shader not found.");
+  return -1;
+}
+
+Splat_Program *Splat_CreateProgram() {
+  Splat_Program *program = MemoryAlloc(SPLAT_MEMORY_OTHER, sizeof(Splat_Program));
+  if (!program) {
+    Splat_SetError("Splat_CreateProgram:  Allocation failed.");
+    return NULL;
+  }
+  memset(program, 0, sizeof(Splat_Program));
+
+  program->program = glCreateProgram();
+  if (!program->program) {
+    Splat_SetError("Splat_CreateProgram:  Unable to create program.");
+    MemoryFree(program);
+    return NULL;
+  }
+
+  // Place new program at the top of the list.
+  program->next = programs;
+  programs = program;
+
+  return program;
+}
+
+/* Removes the program from every canvas' post-process chain */
+static void ReleaseProgram(Splat_Program *program) {
+  for (Splat_Canvas *canvas = CanvasFirst(); canvas != NULL; canvas = canvas->next) {
+    int count = 0;
+    for (int i = 0; i < canvas->programCount; i++) {
+      if (canvas->programs[i] != program) {
+        canvas->programs[count++] = canvas->programs[i];
+      }
+    }
+    canvas->programCount = count;
+  }
+}
+
+int Splat_DestroyProgram(Splat_Program *program) {
+  if (!program) {
+    Splat_SetError("Splat_DestroyProgram:  Invalid argument.");
+    return -1;
+  }
+
+  for (Splat_Program *prev = NULL, *curr = programs; curr != NULL; prev = curr, curr = curr->next) {
+    if (curr == program) {
+      if (prev) {
+        prev->next = curr->next;
+      } else {
+        programs = curr->next;
+      }
+
+      ReleaseProgram(program);
+      glDeleteProgram(program->program);
+      for (int i = 0; i < program->shaderCount; i++) {
+        MemoryFree(program->shaderSources[i]);
+      }
+      MemoryFree(program->shaderSources);
+      MemoryFree(program->shaderTypes);
+      MemoryFree(program);
+      return 0;
+    }
+  }
+
+  Splat_SetError("Splat_DestroyProgram:  Program not found.");
+  return -1;
+}
+
+int Splat_AttachShader(Splat_Program *program, Splat_Shader *shader) {
+  if (!program || !shader) {
+    Splat_SetError("Splat_AttachShader:  Invalid argument.");
+    return -1;
+  }
+
+  const int count = program->shaderCount + 1;
+  int *types = MemoryRealloc(SPLAT_MEMORY_OTHER, program->shaderTypes, count * sizeof(int));
+  if (types) {
+    program->shaderTypes = types;
+  }
+  char **sources = MemoryRealloc(SPLAT_MEMORY_OTHER, program->shaderSources, count * sizeof(char *));
+  if (sources) {
+    program->shaderSources = sources;
+  }
+  char *source = CopyString(shader->source);
+  if (!types || !sources || !source) {
+    MemoryFree(source);
+    Splat_SetError("Splat_AttachShader:  Allocation failed.");
+    return -1;
+  }
+
+  program->shaderTypes[program->shaderCount] = shader->type;
+  program->shaderSources[program->shaderCount] = source;
+  program->shaderCount = count;
+
+  return 0;
+}
+
+int Splat_SetShaderCacheDirectory(const char *path) {
+  char *copy = NULL;
+  if (path && !(copy = CopyString(path))) {
+    Splat_SetError("Splat_SetShaderCacheDirectory:  Allocation failed.");
+    return -1;
+  }
+
+  MemoryFree(cacheDirectory);
+  cacheDirectory = copy;
+  return 0;
+}
+
+/* Hashes everything a program binary depends on: its sources, the driver and SplatGL itself */
+static uint64_t ProgramKey(Splat_Program *program) {
+  const char *driver[] = {
+    (const char *) glGetString(GL_VENDOR),
+    (const char *) glGetString(GL_RENDERER),
+    (const char *) glGetString(GL_VERSION),
+    PACKAGE_VERSION,
+  };
+
+  HashState state;
+  HashInit(&state, 0);
+  for (int i = 0; i < 4; i++) {
+    const char *string = driver[i] ? driver[i] : "";
+    HashUpdate(&state, string, strlen(string) + 1);
+  }
+  for (int i = 0; i < program->shaderCount; i++) {
+    HashUpdate(&state, &program->shaderTypes[i], sizeof(int));
+    HashUpdate(&state, program->shaderSources[i], strlen(program->shaderSources[i]) + 1);
+  }
+
+  return HashFinal(&state);
+}
+
+/* Returns the cache file for the key, or NULL if caching is off */
+static char *CachePath(uint64_t key, const char *suffix) {
+  if (!cacheDirectory) {
+    return NULL;
+  }
+
+  GLint formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  if (glGetError() != GL_NO_ERROR || formats == 0) {
+    return NULL;
+  }
+
+  const size_t length = strlen(cacheDirectory) + 32;
+  char *path = MemoryAlloc(SPLAT_MEMORY_OTHER, length);
+  if (path) {
+    snprintf(path, length, "%s/%016llx%s", cacheDirectory, (unsigned long long) key, suffix);
+  }
+  return path;
+}
+
+/* Loads the program from its cache file, returning true if it linked */
+static bool LoadProgramBinary(Splat_Program *program, const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    return false;
+  }
+
+  char magic[sizeof(CACHE_MAGIC) - 1];
+  uint32_t format, length;
+  void *binary = NULL;
+  bool linked = false;
+
+  if (fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, CACHE_MAGIC, sizeof(magic)) == 0 &&
+      fread(&format, sizeof(format), 1, file) == 1 && fread(&length, sizeof(length), 1, file) == 1 &&
+      (binary = MemoryAlloc(SPLAT_MEMORY_OTHER, length)) != NULL && fread(binary, length, 1, file) == 1) {
+    glProgramBinary(program->program, format, binary, length);
+
+    // Drivers reject binaries from other versions, which just means compiling again
+    GLint status = GL_FALSE;
+    glGetProgramiv(program->program, GL_LINK_STATUS, &status);
+    linked = glGetError() == GL_NO_ERROR && status;
+  }
+
+  MemoryFree(binary);
+  fclose(file);
+  return linked;
+}
+
+/* Writes the linked program to its cache file; failures only cost a compile next time */
+static void SaveProgramBinary(Splat_Program *program, const char *path) {
+  GLint length = 0;
+  glGetProgramiv(program->program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (glGetError() != GL_NO_ERROR || length <= 0) {
+    return;
+  }
+
+  void *binary = MemoryAlloc(SPLAT_MEMORY_OTHER, length);
+  if (!binary) {
+    return;
+  }
+
+  GLenum format;
+  glGetProgramBinary(program->program, length, &length, &format, binary);
+
+  // Write to a temporary file and rename it, so readers never see a partial entry
+  const size_t tempLength = strlen(path) + 8;
+  char *temp = MemoryAlloc(SPLAT_MEMORY_OTHER, tempLength);
+  if (glGetError() == GL_NO_ERROR && temp) {
+    snprintf(temp, tempLength, "%s.%u", path, (unsigned) SDL_GetTicks());
+
+    FILE *file = fopen(temp, "wb");
+    if (file) {
+      const uint32_t header[2] = { format, (uint32_t) length };
+      const bool written = fwrite(CACHE_MAGIC, sizeof(CACHE_MAGIC) - 1, 1, file) == 1 &&
+                           fwrite(header, sizeof(header), 1, file) == 1 &&
+                           fwrite(binary, length, 1, file) == 1;
+      if (fclose(file) == 0 && written) {
+        remove(path);
+        rename(temp, path);
+      }
+      remove(temp);
+    }
+  }
+
+  MemoryFree(temp);
+  MemoryFree(binary);
+}
+
+/* Compiles the program's shaders and links it */
+static int CompileProgram(Splat_Program *program, bool retrievable) {
+  GLuint *compiled = MemoryAlloc(SPLAT_MEMORY_OTHER, SDL_max(program->shaderCount, 1) * sizeof(GLuint));
+  if (!compiled) {
+    Splat_SetError("Splat_LinkProgram:  Allocation failed.");
+    return -1;
+  }
+
+  int result = 0;
+  int attached = 0;
+  for (int i = 0; i < program->shaderCount; i++) {
+    const char *source = program->shaderSources[i];
+    GLuint shader = glCreateShader(shaderTypes[program->shaderTypes[i]]);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (!status) {
+      char log[512] = "";
+      glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+      Splat_SetError("Splat_LinkProgram:  Compilation failed.  %s", log);
+      glDeleteShader(shader);
+      result = -1;
+      break;
+    }
+
+    glAttachShader(program->program, shader);
+    compiled[attached++] = shader;
+  }
+
+  if (result == 0) {
+    if (retrievable) {
+      glProgramParameteri(program->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program->program);
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(program->program, GL_LINK_STATUS, &status);
+    if (!status) {
+      char log[512] = "";
+      glGetProgramInfoLog(program->program, sizeof(log), NULL, log);
+      Splat_SetError("Splat_LinkProgram:  Link failed.  %s", log);
+      result = -1;
+    }
+  }
+
+  // The linked program no longer needs its shader objects
+  for (int i = 0; i < attached; i++) {
+    glDetachShader(program->program, compiled[i]);
+    glDeleteShader(compiled[i]);
+  }
+  MemoryFree(compiled);
+
+  return result;
+}
+
+int Splat_LinkProgram(Splat_Program *program) {
+  if (!program) {
+    Splat_SetError("Splat_LinkProgram:  Invalid argument.");
+    return -1;
+  }
+
+  program->linked = false;
+
+  char *path = CachePath(ProgramKey(program), ".bin");
+  const bool cached = path && LoadProgramBinary(program, path);
+  if (!cached) {
+    if (CompileProgram(program, path != NULL) != 0) {
+      MemoryFree(path);
+      return -1;
+    }
+
+    if (path) {
+      SaveProgramBinary(program, path);
+    }
+  }
+  MemoryFree(path);
+
+  // Resolve uniforms once, rather than every frame
+  program->inputSize = glGetUniformLocation(program->program, "rubyInputSize");
+  program->textureSize = glGetUniformLocation(program->program, "rubyTextureSize");
+  program->outputSize = glGetUniformLocation(program->program, "rubyOutputSize");
+  program->frameCount = glGetUniformLocation(program->program, "rubyFrameCount");
+  program->texture = glGetUniformLocation(program->program, "rubyTexture");
+  program->linked = true;
+
+  return 0;
+}
+
+int Splat_SetCanvasPrograms(Splat_Canvas *canvas, Splat_Program **chain, int count) {
+  if (!canvas || count < 0 || (count > 0 && !chain)) {
+    Splat_SetError("Splat_SetCanvasPrograms:  Invalid argument.");
+    return -1;
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (!chain[i] || !chain[i]->linked) {
+      Splat_SetError("Splat_SetCanvasPrograms:  Program is not linked.");
+      return -1;
+    }
+  }
+
+  if (count > canvas->programCapacity) {
+    Splat_Program **resized = MemoryRealloc(SPLAT_MEMORY_CANVAS, canvas->programs, count * sizeof(Splat_Program *));
+    if (!resized) {
+      Splat_SetError("Splat_SetCanvasPrograms:  Allocation failed.");
+      return -1;
+    }
+    canvas->programs = resized;
+    canvas->programCapacity = count;
+  }
+
+  if (count > 0) {
+    memcpy(canvas->programs, chain, count * sizeof(Splat_Program *));
+  }
+  canvas->programCount = count;
+
+  return 0;
+}
+
+int Splat_SetCanvasProgram(Splat_Canvas *canvas, Splat_Program *program) {
+  return Splat_SetCanvasPrograms(canvas, program ? &program : NULL, program ? 1 : 0);
+}
+
+void ShaderBeginFrame() {
+  frameCount++;
+}
+
+int ShaderBindTarget(int index, int width, int height, GLuint *texture, int *textureWidth, int *textureHeight) {
+  // Targets only grow, so canvases of different sizes share them without reallocating every frame
+  if (width > targets[index].width || height > targets[index].height) {
+    targets[index].width = SDL_max(width, targets[index].width);
+    targets[index].height = SDL_max(height, targets[index].height);
+
+    if (!targets[index].framebuffer) {
+      glGenFramebuffers(1, &targets[index].framebuffer);
+      glGenTextures(1, &targets[index].texture);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, targets[index].texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, targets[index].width, targets[index].height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, targets[index].framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, targets[index].texture, 0);
+
+    if (glGetError() != GL_NO_ERROR || glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+      Splat_SetError("Splat_Render:  Unable to create post-process target.");
+      return -1;
+    }
+  } else {
+    glBindFramebuffer(GL_FRAMEBUFFER, targets[index].framebuffer);
+  }
+
+  *texture = targets[index].texture;
+  *textureWidth = targets[index].width;
+  *textureHeight = targets[index].height;
+
+  return 0;
+}
+
+int ProgramUse(Splat_Program *program, int inputWidth, int inputHeight, int textureWidth, int textureHeight, int outputWidth, int outputHeight) {
+  glUseProgram(program->program);
+
+  if (program->inputSize >= 0) {
+    glUniform2f(program->inputSize, inputWidth, inputHeight);
+  }
+  if (program->textureSize >= 0) {
+    glUniform2f(program->textureSize, textureWidth, textureHeight);
+  }
+  if (program->outputSize >= 0) {
+    glUniform2f(program->outputSize, outputWidth, outputHeight);
+  }
+  if (program->frameCount >= 0) {
+    glUniform1i(program->frameCount, frameCount);
+  }
+  if (program->texture >= 0) {
+    glUniform1i(program->texture, 0);
+  }
+
+  GLenum err = glGetError();
+  if (err != GL_NO_ERROR) {
+    Splat_SetError("Splat_Render:  An OpenGL (%d) error occurred while applying a program", err);
+    return -1;
+  }
+
+  return 0;
+}
+
+uint64_t ShaderGpuBytes() {
+  uint64_t bytes = 0;
+  for (int i = 0; i < 2; i++) {
+    bytes += (uint64_t) targets[i].width * targets[i].height * 4;
+  }
+  return bytes;
+}
+
+void ShaderFinish() {
+  while (programs) {
+    Splat_DestroyProgram(programs);
+  }
+
+  while (shaders) {
+    Splat_DestroyShader(shaders);
+  }
+
+  MemoryFree(cacheDirectory);
+  cacheDirectory = NULL;
+
+  for (int i = 0; i < 2; i++) {
+    if (targets[i].framebuffer) {
+      glDeleteFramebuffers(1, &targets[i].framebuffer);
+      glDeleteTextures(1, &targets[i].texture);
+    }
+  }
+  memset(targets, 0, sizeof(targets));
+}
+
+void ShaderCaptureState() {
+  for (int i = 0; i < 2; i++) {
+    if (targets[i].framebuffer) {
+      GLCaptureFramebuffer(targets[i].framebuffer, targets[i].texture);
+    }
+  }
+
+  for (Splat_Program *curr = programs; curr != NULL; curr = curr->next) {
+    if (!curr->linked) {
+      continue;
+    }
+
+    GLenum *types = MemoryAlloc(SPLAT_MEMORY_OTHER, curr->shaderCount * sizeof(GLenum));
+    if (!types) {
+      continue;
+    }
+    for (int i = 0; i < curr->shaderCount; i++) {
+      types[i] = shaderTypes[curr->shaderTypes[i]];
+    }
+
+    GLCaptureProgram(curr->program, curr->shaderCount, types, curr->shaderSources);
+    MemoryFree(types);
+  }
+}
@@ -0,0 +1,48 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_SHADER_H__
+#define __SPLAT_SHADER_H__
+
+#include <SDL_opengl.h>
+#include "types.h"
+
+/* Advances the frame count passed to post-process programs */
+void ShaderBeginFrame();
+
+/*
+ * Binds one of the two intermediate targets used between post-process
+ * passes, growing it to at least the given size.  Returns the target's
+ * texture and its full size.
+ */
+int ShaderBindTarget(int index, int width, int height, GLuint *texture, int *textureWidth, int *textureHeight);
+
+/* Makes the program current and sets its uniforms for a pass */
+int ProgramUse(Splat_Program *program, int inputWidth, int inputHeight, int textureWidth, int textureHeight, int outputWidth, int outputHeight);
+
+/* Returns the bytes of the intermediate targets */
+uint64_t ShaderGpuBytes();
+
+/* Destroys all shaders, programs and intermediate targets */
+void ShaderFinish();
+
+#endif // __SPLAT_SHADER_H__
@@ -27,19 +27,29 @@
 #include <SDL.h>
 #include "splat.h"
 #include "canvas.h"
+#include "glcapture.h"
+#include "memory.h"
+#include "offscreen.h"
+#include "present.h"
+#include "queue.h"
+#include "shader.h"
+#include "trace.h"
 
 extern SDL_Window *window;
 extern SDL_GLContext window_glcontext;
-extern GLuint framebuffer;
-extern GLuint frameTexture;
-extern int viewportWidth;
-extern int viewportHeight;
+extern int defaultViewportWidth;
+extern int defaultViewportHeight;
 
 int Splat_Prepare(SDL_Window *userWindow, int userViewportWidth, int userViewportHeight) {
+  if (OffscreenActive()) {
+    Splat_SetError("Splat_Prepare:  Splat is already prepared for offscreen rendering.");
+    return -1;
+  }
+
   int width, height;
   window = userWindow;
-  viewportWidth = userViewportWidth;
-  viewportHeight = userViewportHeight;
+  defaultViewportWidth = userViewportWidth;
+  defaultViewportHeight = userViewportHeight;
   SDL_GetWindowSize(userWindow, &width, &height);
 
   SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 4);
@@ -63,7 +73,7 @@ int Splat_Prepare(SDL_Window *userWindow, int userViewportWidth, int userViewpor
   glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
   // Setup our viewport.
-  glViewport(0, 0, viewportWidth, viewportHeight);
+  glViewport(0, 0, defaultViewportWidth, defaultViewportHeight);
 
   // Change to the projection matrix and set up our ortho view
   glMatrixMode(GL_PROJECTION);
@@ -81,22 +91,7 @@ int Splat_Prepare(SDL_Window *userWindow, int userViewportWidth, int userViewpor
 
   glDisable(GL_DITHER);
 
-  /* Create the frame buffer for rendering to texture*/
-  glGenFramebuffers(1, &framebuffer);
-
-  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-
-  /* Set up the texture to which we're going to render */
-  glGenTextures(1, &frameTexture);
-  glBindTexture(GL_TEXTURE_2D, frameTexture);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, viewportWidth, viewportHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-
-  /* Configure the framebuffer texture */
-  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, frameTexture, 0);
-  GLenum DrawBuffers[1] = { GL_COLOR_ATTACHMENT0 };
-  glDrawBuffers(1, DrawBuffers);
+  PresentPrepare();
 
   GLenum err = glGetError();
   if (err != GL_NO_ERROR) {
@@ -109,12 +104,22 @@ int Splat_Prepare(SDL_Window *userWindow, int userViewportWidth, int userViewpor
 }
 
 void Splat_Finish() {
+  QueueFinish();
+
+  // Canvases release their framebuffers, so the context must still exist
+  CanvasFinish();
+  ShaderFinish();
+  PresentFinish();
+
   if (window) {
     SDL_GL_DeleteContext(window_glcontext);
     window_glcontext = NULL;
     window = NULL;
   }
 
-  CanvasFinish();
+  GLCaptureFinish();
+  OffscreenFinish();
+  TraceFinish();
+  MemoryFinish();
 }
 
@@ -0,0 +1,114 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "splat.h"
+#include "canvas.h"
+#include "stats.h"
+
+Splat_FrameStats *frameStats = NULL;
+static uint64_t pendingUploads = 0; // Bytes uploaded since the last render
+
+void StatsReset(Splat_Canvas *canvas) {
+  Splat_FrameStats *stats = &canvas->stats;
+  stats->instancesVisited = 0;
+  stats->instancesCulled = 0;
+  stats->instancesDrawn = 0;
+  stats->drawCalls = 0;
+  stats->textureBinds = 0;
+  stats->stateChanges = 0;
+  stats->bytesUploaded = pendingUploads;
+  stats->layerTime = 0.0f;
+  stats->debugTime = 0.0f;
+  stats->blitTime = 0.0f;
+  stats->swapTime = 0.0f;
+  pendingUploads = 0;
+}
+
+void StatsBind(Splat_Canvas *canvas) {
+  frameStats = canvas ? &canvas->stats : NULL;
+}
+
+void StatsUpload(uint64_t bytes) {
+  if (frameStats) {
+    frameStats->bytesUploaded += bytes;
+  } else {
+    pendingUploads += bytes;
+  }
+}
+
+float StatsElapsed(uint64_t start) {
+  return (float) ((SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+}
+
+void StatsFrameEnd(Splat_Canvas *canvas) {
+  const uint64_t now = SDL_GetPerformanceCounter();
+  if (canvas->lastFrameEnd) {
+    canvas->stats.frameTime = (float) ((now - canvas->lastFrameEnd) * 1000.0 / SDL_GetPerformanceFrequency());
+    canvas->frameTimes[canvas->frameTimeIndex] = canvas->stats.frameTime;
+    canvas->frameTimeIndex = (canvas->frameTimeIndex + 1) % FRAME_HISTORY;
+    if (canvas->frameTimeCount < FRAME_HISTORY) {
+      canvas->frameTimeCount++;
+    }
+  }
+  canvas->lastFrameEnd = now;
+}
+
+static int CompareFloat(const void *a, const void *b) {
+  const float x = *(const float *) a;
+  const float y = *(const float *) b;
+  return (x > y) - (x < y);
+}
+
+/* Returns the value below which the given percent of the sorted values fall */
+static float Percentile(const float *sorted, int count, int percent) {
+  int index = (count * percent + 99) / 100 - 1;
+  return sorted[index < 0 ? 0 : index];
+}
+
+int Splat_GetFrameStats(Splat_Canvas *canvas, Splat_FrameStats *stats) {
+  if (!canvas || !stats) {
+    Splat_SetError("Splat_GetFrameStats:  Invalid argument.");
+    return -1;
+  }
+
+  *stats = canvas->stats;
+  stats->debugGpuTime = canvas->debugGpuTime;
+  stats->blitGpuTime = canvas->blitGpuTime;
+  stats->frameCount = canvas->frameTimeCount;
+  stats->frameTimeP50 = 0.0f;
+  stats->frameTimeP95 = 0.0f;
+  stats->frameTimeP99 = 0.0f;
+
+  const int count = canvas->frameTimeCount;
+  if (count > 0) {
+    float sorted[FRAME_HISTORY];
+    memcpy(sorted, canvas->frameTimes, count * sizeof(float));
+    qsort(sorted, count, sizeof(float), CompareFloat);
+    stats->frameTimeP50 = Percentile(sorted, count, 50);
+    stats->frameTimeP95 = Percentile(sorted, count, 95);
+    stats->frameTimeP99 = Percentile(sorted, count, 99);
+  }
+
+  return 0;
+}
@@ -0,0 +1,55 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_STATS_H__
+#define __SPLAT_STATS_H__
+
+#include <SDL.h>
+#include "canvas.h"
+
+/* Statistics of the canvas being rendered, or NULL between renders */
+extern Splat_FrameStats *frameStats;
+
+/* Adds to a counter of the canvas being rendered */
+#define STAT_ADD(field, n) \
+  { \
+    if (frameStats) { \
+      frameStats->field += (n); \
+    } \
+  }
+
+/* Clears the canvas' counters before it is rendered */
+void StatsReset(Splat_Canvas *canvas);
+
+/* Directs counters to the canvas, or nowhere if NULL */
+void StatsBind(Splat_Canvas *canvas);
+
+/* Counts bytes uploaded to video memory, outside a render counted with the next one */
+void StatsUpload(uint64_t bytes);
+
+/* Returns the milliseconds elapsed since start, a value of SDL_GetPerformanceCounter() */
+float StatsElapsed(uint64_t start);
+
+/* Records the time since the canvas' previous frame completed */
+void StatsFrameEnd(Splat_Canvas *canvas);
+
+#endif // __SPLAT_STATS_H__
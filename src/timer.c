@@ -0,0 +1,106 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#define GL_GLEXT_PROTOTYPES
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "splat.h"
+#include "memory.h"
+#include "timer.h"
+
+bool TimerSupported() {
+  static int supported = -1;
+
+  if (supported < 0) {
+    GLint bits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+    supported = glGetError() == GL_NO_ERROR && bits > 0;
+  }
+
+  return supported;
+}
+
+GpuTimer *TimerCreate() {
+  if (!TimerSupported()) {
+    return NULL;
+  }
+
+  GpuTimer *timer = MemoryAlloc(SPLAT_MEMORY_OTHER, sizeof(GpuTimer));
+  if (!timer) {
+    return NULL;
+  }
+  memset(timer, 0, sizeof(GpuTimer));
+
+  glGenQueries(TIMER_DEPTH * 2, &timer->queries[0][0]);
+  return timer;
+}
+
+void TimerBegin(GpuTimer *timer) {
+  // Drop the measurement rather than wait on the oldest
+  if (timer->pending == TIMER_DEPTH) {
+    return;
+  }
+
+  glQueryCounter(timer->queries[timer->head][0], GL_TIMESTAMP);
+  timer->active = true;
+}
+
+void TimerEnd(GpuTimer *timer) {
+  if (!timer->active) {
+    return;
+  }
+
+  glQueryCounter(timer->queries[timer->head][1], GL_TIMESTAMP);
+  timer->head = (timer->head + 1) % TIMER_DEPTH;
+  timer->pending++;
+  timer->active = false;
+}
+
+bool TimerResult(GpuTimer *timer, float *ms) {
+  if (timer->pending == 0) {
+    return false;
+  }
+
+  const int tail = (timer->head + TIMER_DEPTH - timer->pending) % TIMER_DEPTH;
+
+  // The end timestamp is written last, so once it is available both are
+  GLint available = GL_FALSE;
+  glGetQueryObjectiv(timer->queries[tail][1], GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) {
+    return false;
+  }
+
+  GLuint64 start, end;
+  glGetQueryObjectui64v(timer->queries[tail][0], GL_QUERY_RESULT, &start);
+  glGetQueryObjectui64v(timer->queries[tail][1], GL_QUERY_RESULT, &end);
+  timer->pending--;
+
+  *ms = (end - start) / 1000000.0f;
+  return true;
+}
+
+void TimerDestroy(GpuTimer *timer) {
+  if (timer) {
+    glDeleteQueries(TIMER_DEPTH * 2, &timer->queries[0][0]);
+    MemoryFree(timer);
+  }
+}
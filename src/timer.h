@@ -0,0 +1,61 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_TIMER_H__
+#define __SPLAT_TIMER_H__
+
+#include <stdbool.h>
+#include <SDL_opengl.h>
+
+/* Number of measurements that may be in flight before results are read */
+#define TIMER_DEPTH 4
+
+/*
+ * Measures GPU time between two points in the command stream with
+ * timestamp queries.  Results are collected a few frames later, so
+ * reading them never waits for the GPU.  Timers may overlap or nest.
+ */
+typedef struct GpuTimer {
+  GLuint queries[TIMER_DEPTH][2]; /* Start and end timestamps of each measurement */
+  int head; /* Next measurement to start */
+  int pending; /* Measurements awaiting results */
+  bool active; /* True between TimerBegin and TimerEnd */
+} GpuTimer;
+
+/* Returns true if the context supports timestamp queries */
+bool TimerSupported();
+
+/* Creates a timer, returning NULL if timing is unsupported */
+GpuTimer *TimerCreate();
+
+/* Marks the start of a measurement, skipped if too many are in flight */
+void TimerBegin(GpuTimer *timer);
+
+/* Marks the end of the measurement begun by TimerBegin */
+void TimerEnd(GpuTimer *timer);
+
+/* Retrieves the oldest completed measurement in milliseconds, returning false if none is ready */
+bool TimerResult(GpuTimer *timer, float *ms);
+
+void TimerDestroy(GpuTimer *timer);
+
+#endif // __SPLAT_TIMER_H__
@@ -0,0 +1,302 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <SDL.h>
+#include "splat.h"
+#include "trace.h"
+
+#define TRACE_CAPACITY 8192 // Events each thread can queue before new ones are dropped
+#define TRACE_THREADS 64 // Threads that can hold a buffer at once, as buffers of exited threads are reused
+#define TRACE_FLUSH_INTERVAL 20 // Milliseconds between writes of queued events
+
+typedef struct TraceEvent {
+  const char *name;
+  const char *argName; // Name of the integer argument, or NULL if none
+  int64_t arg;
+  uint64_t timestamp; // Performance counter at the start of the event
+  uint64_t duration; // Performance counter ticks, 0 for counters
+  char phase; // 'X' for spans, 'C' for counters
+} TraceEvent;
+
+/*
+ * Single-producer, single-consumer ring of events.  Only the owning
+ * thread advances head and only the flusher advances tail, so neither
+ * side takes a lock.
+ */
+typedef struct TraceBuffer {
+  TraceEvent events[TRACE_CAPACITY];
+  SDL_atomic_t head; // Events written by the owning thread
+  SDL_atomic_t tail; // Events written out by the flusher
+  SDL_atomic_t dropped; // Events lost because the ring was full
+  SDL_atomic_t exited; // Set as the owning thread exits
+  bool unowned; // Free for another thread to claim, only touched under registerLock
+  unsigned long thread;
+} TraceBuffer;
+
+static SDL_atomic_t tracing; // Non-zero while a trace is in progress
+static SDL_atomic_t stopping; // Tells the flusher to exit
+static int generation = 0; // Incremented when buffers are freed, so threads don't use stale ones
+static SDL_TLSID bufferKey = 0;
+static SDL_mutex *registerLock = NULL;
+static TraceBuffer *buffers[TRACE_THREADS]; // Kept between traces, since threads may still be writing to them
+static SDL_atomic_t bufferCount;
+static SDL_Thread *flusher = NULL;
+static FILE *file = NULL;
+static bool firstEvent;
+static uint64_t traceStart;
+static double ticksPerMicrosecond;
+
+/* Marks the buffer of an exiting thread, so the next trace can hand it to another thread */
+static void SDLCALL ReleaseBuffer(void *value) {
+  const uintptr_t packed = (uintptr_t) value;
+  if (packed && (int) (packed >> 8) == generation) {
+    SDL_AtomicSet(&buffers[(packed & 0xff) - 1]->exited, 1);
+  }
+}
+
+/* Returns the calling thread's buffer, registering one if needed */
+static TraceBuffer *ThreadBuffer() {
+  // The thread-local value packs the generation with the buffer's slot + 1
+  const uintptr_t value = (uintptr_t) SDL_TLSGet(bufferKey);
+  if (value && (int) (value >> 8) == generation) {
+    return buffers[(value & 0xff) - 1];
+  }
+
+  TraceBuffer *buffer = NULL;
+  SDL_LockMutex(registerLock);
+  const int count = SDL_AtomicGet(&bufferCount);
+  int slot = 0;
+  while (slot < count && !buffers[slot]->unowned) {
+    slot++;
+  }
+
+  if (slot < count) {
+    // A reclaimed buffer keeps its head and tail, which the flusher may be reading
+    buffer = buffers[slot];
+    buffer->unowned = false;
+    buffer->thread = SDL_ThreadID();
+  } else if (slot < TRACE_THREADS && (buffer = malloc(sizeof(TraceBuffer)))) {
+    SDL_AtomicSet(&buffer->head, 0);
+    SDL_AtomicSet(&buffer->tail, 0);
+    SDL_AtomicSet(&buffer->dropped, 0);
+    SDL_AtomicSet(&buffer->exited, 0);
+    buffer->unowned = false;
+    buffer->thread = SDL_ThreadID();
+    buffers[slot] = buffer;
+    SDL_AtomicSet(&bufferCount, slot + 1);
+  }
+
+  if (buffer) {
+    SDL_TLSSet(bufferKey, (void *) (((uintptr_t) generation << 8) | (slot + 1)), ReleaseBuffer);
+  }
+  SDL_UnlockMutex(registerLock);
+
+  return buffer;
+}
+
+static void Record(const TraceEvent *event) {
+  TraceBuffer *buffer = ThreadBuffer();
+  if (!buffer) {
+    return;
+  }
+
+  const unsigned head = SDL_AtomicGet(&buffer->head);
+  const unsigned tail = SDL_AtomicGet(&buffer->tail);
+  if (head - tail >= TRACE_CAPACITY) {
+    SDL_AtomicAdd(&buffer->dropped, 1);
+    return;
+  }
+
+  buffer->events[head % TRACE_CAPACITY] = *event;
+  SDL_AtomicSet(&buffer->head, head + 1); // Publishes the event to the flusher
+}
+
+uint64_t TraceBegin() {
+  return SDL_AtomicGet(&tracing) ? SDL_GetPerformanceCounter() : 0;
+}
+
+void TraceEnd(uint64_t start, const char *name, const char *argName, int64_t arg) {
+  if (!start || !SDL_AtomicGet(&tracing)) {
+    return;
+  }
+
+  const TraceEvent event = { name, argName, arg, start, SDL_GetPerformanceCounter() - start, 'X' };
+  Record(&event);
+}
+
+void TraceCounter(const char *name, int64_t value) {
+  if (!SDL_AtomicGet(&tracing)) {
+    return;
+  }
+
+  const TraceEvent event = { name, "value", value, SDL_GetPerformanceCounter(), 0, 'C' };
+  Record(&event);
+}
+
+static void WriteEvent(const TraceEvent *event, unsigned long thread) {
+  fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"splat\",\"ph\":\"%c\",\"ts\":%.3f,", firstEvent ? "" : ",",
+          event->name, event->phase, (event->timestamp - traceStart) / ticksPerMicrosecond);
+  if (event->phase == 'X') {
+    fprintf(file, "\"dur\":%.3f,", event->duration / ticksPerMicrosecond);
+  }
+  fprintf(file, "\"pid\":1,\"tid\":%lu", thread);
+  if (event->argName) {
+    fprintf(file, ",\"args\":{\"%s\":%lld}", event->argName, (long long) event->arg);
+  }
+  fputc('}', file);
+  firstEvent = false;
+}
+
+/* Writes out the events queued by every thread */
+static void Flush() {
+  const int count = SDL_AtomicGet(&bufferCount);
+  for (int i = 0; i < count; i++) {
+    TraceBuffer *buffer = buffers[i];
+    const unsigned head = SDL_AtomicGet(&buffer->head);
+    unsigned tail = SDL_AtomicGet(&buffer->tail);
+    for (; tail != head; tail++) {
+      WriteEvent(&buffer->events[tail % TRACE_CAPACITY], buffer->thread);
+    }
+    SDL_AtomicSet(&buffer->tail, tail); // Hands the slots back to the owning thread
+  }
+  fflush(file);
+}
+
+static int FlushEvents(void *data) {
+  while (!SDL_AtomicGet(&stopping)) {
+    SDL_Delay(TRACE_FLUSH_INTERVAL);
+    Flush();
+  }
+
+  return 0;
+}
+
+int Splat_StartTrace(const char *path) {
+  if (!path) {
+    Splat_SetError("Splat_StartTrace:  Invalid argument.");
+    return -1;
+  }
+
+  if (SDL_AtomicGet(&tracing)) {
+    Splat_SetError("Splat_StartTrace:  A trace is already in progress.");
+    return -1;
+  }
+
+  if (!bufferKey && !(bufferKey = SDL_TLSCreate())) {
+    Splat_SetError("Splat_StartTrace:  Unable to create thread-local storage.");
+    return -1;
+  }
+
+  if (!registerLock && !(registerLock = SDL_CreateMutex())) {
+    Splat_SetError("Splat_StartTrace:  Unable to create mutex.");
+    return -1;
+  }
+
+  file = fopen(path, "w");
+  if (!file) {
+    Splat_SetError("Splat_StartTrace:  Unable to open %s.", path);
+    return -1;
+  }
+  fputs("{\"traceEvents\":[", file);
+
+  firstEvent = true;
+  traceStart = SDL_GetPerformanceCounter();
+  ticksPerMicrosecond = SDL_GetPerformanceFrequency() / 1000000.0;
+  SDL_AtomicSet(&stopping, 0);
+
+  // Discard anything recorded after the previous trace stopped, and free the buffers of exited threads
+  SDL_LockMutex(registerLock);
+  const int count = SDL_AtomicGet(&bufferCount);
+  for (int i = 0; i < count; i++) {
+    SDL_AtomicSet(&buffers[i]->tail, SDL_AtomicGet(&buffers[i]->head));
+    SDL_AtomicSet(&buffers[i]->dropped, 0);
+    if (SDL_AtomicGet(&buffers[i]->exited)) {
+      SDL_AtomicSet(&buffers[i]->exited, 0);
+      buffers[i]->unowned = true;
+    }
+  }
+  SDL_UnlockMutex(registerLock);
+
+  flusher = SDL_CreateThread(FlushEvents, "SplatTrace", NULL);
+  if (!flusher) {
+    fclose(file);
+    file = NULL;
+    Splat_SetError("Splat_StartTrace:  Unable to start the trace writer thread.");
+    return -1;
+  }
+
+  SDL_AtomicSet(&tracing, 1);
+  return 0;
+}
+
+int Splat_StopTrace() {
+  if (!SDL_AtomicGet(&tracing)) {
+    Splat_SetError("Splat_StopTrace:  No trace is in progress.");
+    return -1;
+  }
+
+  // Other threads may still be finishing an event; the last flush picks it up
+  SDL_AtomicSet(&tracing, 0);
+  SDL_AtomicSet(&stopping, 1);
+  SDL_WaitThread(flusher, NULL);
+  flusher = NULL;
+  Flush();
+
+  const int count = SDL_AtomicGet(&bufferCount);
+  uint64_t dropped = 0;
+  for (int i = 0; i < count; i++) {
+    dropped += SDL_AtomicGet(&buffers[i]->dropped);
+  }
+
+  fprintf(file, "\n],\"otherData\":{\"droppedEvents\":%llu}}\n", (unsigned long long) dropped);
+  const bool failed = ferror(file) != 0;
+  fclose(file);
+  file = NULL;
+
+  if (failed) {
+    Splat_SetError("Splat_StopTrace:  Unable to write the trace.");
+    return -1;
+  }
+
+  return 0;
+}
+
+void TraceFinish() {
+  if (SDL_AtomicGet(&tracing)) {
+    Splat_StopTrace();
+  }
+
+  const int count = SDL_AtomicGet(&bufferCount);
+  for (int i = 0; i < count; i++) {
+    free(buffers[i]);
+    buffers[i] = NULL;
+  }
+  SDL_AtomicSet(&bufferCount, 0);
+  generation++;
+
+  if (registerLock) {
+    SDL_DestroyMutex(registerLock);
+    registerLock = NULL;
+  }
+}
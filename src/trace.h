@@ -0,0 +1,47 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef __SPLAT_TRACE_H__
+#define __SPLAT_TRACE_H__
+
+#include <SDL.h>
+
+/*
+ * Trace events are recorded into a ring buffer owned by the calling
+ * thread and written out as Chrome trace-event JSON by a background
+ * thread.  Names and argument names must be string literals, since
+ * only the pointers are kept until the event is written.
+ */
+
+/* Returns the start time of a span, or 0 if not tracing */
+uint64_t TraceBegin();
+
+/* Records a span begun by TraceBegin, with an integer argument if argName is not NULL */
+void TraceEnd(uint64_t start, const char *name, const char *argName, int64_t arg);
+
+/* Records the value of a counter */
+void TraceCounter(const char *name, int64_t value);
+
+/* Stops any trace in progress */
+void TraceFinish();
+
+#endif // __SPLAT_TRACE_H__
@@ -27,15 +27,56 @@
 #include <SDL_opengl.h>
 #include <SDL.h>
 
+/* Texture shared by one or more images with identical contents */
+typedef struct Splat_Texture {
+  GLuint name;
+  uint32_t width;
+  uint32_t height;
+  uint32_t bytes; /* Video memory used by the texture */
+  uint32_t lastUsed; /* Frame in which the texture was last bound */
+  bool resident; /* True if the texture is currently uploaded */
+  uint32_t retainCount; /* Images using the texture that keep a copy of its pixels in system memory */
+  bool reloadable; /* Scratch flag set while looking for eviction candidates */
+  bool tile; /* True if the texture is one tile of a larger image */
+  uint32_t x; /* Position of a tile within its image */
+  uint32_t y;
+  void *pixels; /* Retained copy of the pixel data or compressed blocks, or NULL */
+  GLint internalFormat; /* Texture format, either the base format or a compressed format */
+  uint32_t pixelFormat; /* Splat_PixelFormat of the retained pixel data */
+  uint64_t hash; /* Content hash if the texture can be shared, 0 otherwise */
+  int refcount; /* Number of images using the texture */
+  struct Splat_Texture *next;
+} Splat_Texture;
+
 typedef struct Splat_Image {
-  GLuint texture;
+  Splat_Texture *texture; /* NULL if the image is tiled */
+  Splat_Texture **tiles; /* Grid of tiles, row by row, if the image is too large for one texture */
+  uint32_t columns;
+  uint32_t rows;
+  uint32_t tileSize;
   uint32_t width;
   uint32_t height;
+  uint32_t flags; /* Splat_ImageFlags the image was created with */
+  bool target; /* Rendered into by a canvas, so never shared, tiled, evicted or updated */
+  bool retained; /* Keeps a copy of its pixels, counted in the retainCount of each of its textures */
+  Splat_ReloadCallback reload; /* Called to restore an evicted texture without a retained copy */
+  void *reloadData;
+  struct Splat_Animation *animations; /* Animations using this image */
+  uint32_t instanceCount; /* Instances showing this image, which keep it from being destroyed */
   struct Splat_Image *next;
 } Splat_Image;
 
+typedef struct Splat_Animation {
+  Splat_Image *image;
+  int count;
+  Splat_AnimationFrame *frames;
+  uint32_t *ends; /* Time at which each frame ends, relative to the start */
+  uint32_t duration;
+  struct Splat_Animation *next;
+} Splat_Animation;
+
 typedef struct Splat_Instance {
-  GLuint texture;
+  Splat_Image *image;
   SDL_Rect rect;
   float s1;
   float t1;
@@ -48,12 +89,18 @@ typedef struct Splat_Instance {
   uint32_t flags;
   Splat_Instance *nextCulledHandle;
   SDL_Rect clip; /* If not empty, the image is clipped to this rect */
+  Splat_Animation *animation; /* Animation being played, or NULL */
+  uint32_t animationStart; /* Time the animation started */
+  int animationFrame; /* Frame of the animation currently shown */
+  bool animationLoop;
   Splat_Instance *next;
 } Splat_Instance;
 
 typedef struct Splat_Layer {
   Splat_Canvas *canvas;
   Splat_Instance *instances;
+  struct GpuTimer *timer; // Measures GPU time of the layer while profiling
+  float gpuTime; // Latest GPU milliseconds spent drawing the layer
   struct Splat_Layer *next;
 } Splat_Layer;
 
@@ -80,14 +127,25 @@ typedef struct Splat_Line {
   struct Splat_Line *next;
 } Splat_Line;
 
-//struct Splat_Shader {
-//  int type;
-//  GLuint shader;
-//};
-//
-//struct Splat_Program {
-//  GLuint program;
-//};
+typedef struct Splat_Shader {
+  int type; /* Splat_ShaderType */
+  char *source; /* Compiled when a program using it is linked and not found in the cache */
+  struct Splat_Shader *next;
+} Splat_Shader;
+
+typedef struct Splat_Program {
+  GLuint program;
+  bool linked;
+  int shaderCount; /* Shaders attached, copied so they may be destroyed before linking */
+  int *shaderTypes;
+  char **shaderSources;
+  GLint inputSize; /* Uniform locations, resolved when the program is linked */
+  GLint textureSize;
+  GLint outputSize;
+  GLint frameCount;
+  GLint texture;
+  struct Splat_Program *next;
+} Splat_Program;
 
 #endif // __SPLAT_TYPES_H__
 
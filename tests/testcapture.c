@@ -0,0 +1,133 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+/*
+ * Checks that captured frames and Splat_ReadPixels hand out the top row
+ * first, both for a canvas rendered into an image and for a canvas
+ * presented as usual.  Exits with 77, which automake reports as a
+ * skipped test, when no offscreen context is available.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <SDL.h>
+#include "splat.h"
+
+#define SIZE 4
+#define FRAMES 8
+
+static const uint8_t red[4] = { 255, 0, 0, 255 }; // RGBA
+static const uint8_t blue[4] = { 0, 0, 255, 255 };
+
+typedef struct Received {
+  int frames;
+  uint8_t top[4]; // BGRA of the first and last rows of the latest frame
+  uint8_t bottom[4];
+} Received;
+
+static void OnFrame(Splat_Canvas *canvas, const void *pixels, int width, int height, int pitch, uint32_t format, uint64_t frame, void *userdata) {
+  Received *received = userdata;
+  const uint8_t *rows = pixels;
+  memcpy(received->top, rows, 4);
+  memcpy(received->bottom, rows + (ptrdiff_t) (height - 1) * pitch, 4);
+  received->frames++;
+}
+
+/* Compares a BGRA pixel against an RGBA color */
+static bool MatchesBgra(const uint8_t *pixel, const uint8_t *color) {
+  return pixel[0] == color[2] && pixel[1] == color[1] && pixel[2] == color[0] && pixel[3] == color[3];
+}
+
+static int Check(const char *what, const Received *received) {
+  if (received->frames == 0 || !MatchesBgra(received->top, red) || !MatchesBgra(received->bottom, blue)) {
+    fprintf(stderr, "%s: %d frames, top %u,%u,%u bottom %u,%u,%u (BGR)\n", what, received->frames,
+            received->top[0], received->top[1], received->top[2],
+            received->bottom[0], received->bottom[1], received->bottom[2]);
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  SDL_setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+  SDL_setenv("GALLIUM_DRIVER", "llvmpipe", 0);
+  if (Splat_PrepareOffscreen(SIZE, SIZE) != 0) {
+    fprintf(stderr, "Skipped: %s\n", Splat_GetError());
+    return 77;
+  }
+
+  // Red on the top half, blue on the bottom half
+  uint8_t pixels[SIZE * SIZE * 4];
+  for (int p = 0; p < SIZE * SIZE; p++) {
+    memcpy(&pixels[p * 4], (p < SIZE * SIZE / 2) ? red : blue, 4);
+  }
+  Splat_Image *image = Splat_CreateImageFromPixels(pixels, SIZE, SIZE, SIZE * 4, SPLAT_PIXELFORMAT_RGBA32);
+  Splat_Image *target = Splat_CreateTargetImage(SIZE, SIZE);
+
+  // One canvas draws the image into the target, the other shows the target
+  Splat_Canvas *inner = Splat_CreateCanvas();
+  Splat_Canvas *outer = Splat_CreateCanvas();
+  Splat_Instance *drawn = Splat_CreateInstance(image, Splat_CreateLayer(inner), 0, 0, 0.0f, 0.0f, 1.0f, 1.0f, 0);
+  Splat_Instance *shown = Splat_CreateInstance(target, Splat_CreateLayer(outer), 0, 0, 0.0f, 0.0f, 1.0f, 1.0f, 0);
+  if (!image || !target || !drawn || !shown || Splat_RenderToImage(inner, target, 0) != 0 || Splat_Render(outer) != 0) {
+    fprintf(stderr, "Setup failed: %s\n", Splat_GetError());
+    return 1;
+  }
+
+  Received innerFrames = { 0 }, outerFrames = { 0 };
+  if (Splat_StartCapture(inner, OnFrame, &innerFrames) != 0 || Splat_StartCapture(outer, OnFrame, &outerFrames) != 0) {
+    fprintf(stderr, "Capture failed: %s\n", Splat_GetError());
+    return 1;
+  }
+
+  for (int i = 0; i < FRAMES; i++) {
+    if (Splat_Render(outer) != 0) {
+      fprintf(stderr, "Render failed: %s\n", Splat_GetError());
+      return 1;
+    }
+  }
+
+  // Stopping delivers the frames still in flight
+  Splat_StopCapture(inner);
+  Splat_StopCapture(outer);
+
+  int failures = Check("target canvas capture", &innerFrames) + Check("presented canvas capture", &outerFrames);
+
+  // Splat_ReadPixels returns RGBA, top row first, whichever way the framebuffer is stored
+  Splat_Canvas *canvases[] = { inner, outer };
+  for (int i = 0; i < 2; i++) {
+    uint8_t read[SIZE * SIZE * 4];
+    if (Splat_ReadPixels(canvases[i], read, SIZE * 4) != 0 ||
+        memcmp(read, red, 4) != 0 || memcmp(&read[(SIZE - 1) * SIZE * 4], blue, 4) != 0) {
+      fprintf(stderr, "%s canvas read back upside down or failed\n", i ? "Presented" : "Target");
+      failures++;
+    }
+  }
+
+  Splat_DestroyCanvas(outer);
+  Splat_DestroyCanvas(inner);
+  Splat_Finish();
+
+  return failures ? 1 : 0;
+}
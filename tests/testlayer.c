@@ -0,0 +1,122 @@
+/*
+  Splat Graphics Library
+  Copyright (C) 2014  Michael Dale Long <mlong@digitalbytes.net>
+  http://digitalbytes.net/projects/splatgl/
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+/*
+ * Checks that layers and instances keep a consistent order as they are
+ * moved, by rendering a solid layer per color offscreen and reading back
+ * which one ends up on top.  Exits with 77, which automake reports as a
+ * skipped test, when no offscreen context is available.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <SDL.h>
+#include "splat.h"
+
+#define SIZE 4
+#define LAYERS 3
+
+static const uint8_t colors[LAYERS][4] = { { 255, 0, 0, 255 }, { 0, 255, 0, 255 }, { 0, 0, 255, 255 } };
+
+static Splat_Canvas *canvas;
+static Splat_Layer *layers[LAYERS];
+static Splat_Image *images[LAYERS];
+static int failures = 0;
+
+/* Renders the canvas and returns the index of the color on top, or -1 */
+static int TopColor() {
+  uint8_t pixels[SIZE * SIZE * 4];
+  if (Splat_Render(canvas) != 0 || Splat_ReadPixels(canvas, pixels, SIZE * 4) != 0) {
+    fprintf(stderr, "Render failed: %s\n", Splat_GetError());
+    return -1;
+  }
+
+  for (int i = 0; i < LAYERS; i++) {
+    if (memcmp(pixels, colors[i], 4) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void Expect(const char *what, int result, int top) {
+  const int actual = (result == 0) ? TopColor() : -1;
+  if (result != 0 || actual != top) {
+    fprintf(stderr, "%s: expected color %d on top, got %d (%s)\n", what, top, actual, result ? Splat_GetError() : "");
+    failures++;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  SDL_setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+  SDL_setenv("GALLIUM_DRIVER", "llvmpipe", 0);
+  if (Splat_PrepareOffscreen(SIZE, SIZE) != 0) {
+    fprintf(stderr, "Skipped: %s\n", Splat_GetError());
+    return 77;
+  }
+
+  canvas = Splat_CreateCanvas();
+  Splat_Instance *instances[LAYERS];
+  for (int i = 0; i < LAYERS; i++) {
+    uint8_t pixels[SIZE * SIZE * 4];
+    for (int p = 0; p < SIZE * SIZE; p++) {
+      memcpy(&pixels[p * 4], colors[i], 4);
+    }
+
+    layers[i] = Splat_CreateLayer(canvas);
+    images[i] = Splat_CreateImageFromPixels(pixels, SIZE, SIZE, SIZE * 4, SPLAT_PIXELFORMAT_RGBA32);
+    instances[i] = Splat_CreateInstance(images[i], layers[i], 0, 0, 0.0f, 0.0f, 1.0f, 1.0f, 0);
+    if (!instances[i]) {
+      fprintf(stderr, "Setup failed: %s\n", Splat_GetError());
+      return 1;
+    }
+  }
+
+  // Layers draw in creation order, so the last one starts on top: 0, 1, 2
+  Expect("initial order", 0, 2);
+
+  // Adjacent layers, in both argument orders and at the head of the list
+  Expect("move adjacent", Splat_MoveLayer(layers[1], layers[2]), 1); // 0, 2, 1
+  Expect("move adjacent reversed", Splat_MoveLayer(layers[1], layers[2]), 2); // 0, 1, 2
+  Expect("move adjacent at head", Splat_MoveLayer(layers[1], layers[0]), 2); // 1, 0, 2
+  Expect("move apart", Splat_MoveLayer(layers[1], layers[2]), 1); // 2, 0, 1
+  Expect("move adjacent to tail", Splat_MoveLayer(layers[1], layers[0]), 0); // 2, 1, 0
+
+  // Moving the same instance more than once follows it from layer to layer
+  Splat_Layer *top = Splat_CreateLayer(canvas);
+  Splat_Instance *instance = instances[2];
+  Expect("instance to top", Splat_SetInstanceLayer(instance, top), 2);
+  Expect("instance to bottom", Splat_SetInstanceLayer(instance, layers[1]), 0);
+  Expect("instance to top again", Splat_SetInstanceLayer(instance, top), 2);
+  Expect("instance home", Splat_SetInstanceLayer(instance, layers[2]), 0);
+  Splat_DestroyLayer(top);
+
+  for (int i = 0; i < LAYERS; i++) {
+    Splat_DestroyInstance(instances[i]);
+    Splat_DestroyLayer(layers[i]);
+    Splat_DestroyImage(images[i]);
+  }
+  Splat_DestroyCanvas(canvas);
+  Splat_Finish();
+
+  return failures ? 1 : 0;
+}